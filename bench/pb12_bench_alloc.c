@@ -0,0 +1,146 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "pb12.h"
+#include "pb12_alloc.h"
+
+#define PB12_BENCH_LONGEST  64          /* Longest block allocated */
+#define PB12_BENCH_BATCH    100         /* Most allocations timed at once */
+#define PB12_BENCH_STEPS    200000000.0 /* Blocks a list walk may visit, all told */
+#define PB12_BENCH_ALLOCS   100000      /* Most allocations timed per size */
+
+/**
+    Makes a free list of count holes of random lengths, each kept apart from
+    the next by a word that stays allocated, plus what is left over at the
+    end of memory.
+
+    @param PB12_MemList *mem_list - List to make.
+    @param PB12_MemBlock **used - Set to the words kept allocated.
+    @param int count - Number of holes.
+    @param const PB12_Config *config - Settings.
+    @param unsigned int seed - Seed for the lengths of the holes.
+*/
+static void pb12BenchMakeList(PB12_MemList *mem_list, PB12_MemBlock **used, int count,
+                              const PB12_Config *config, unsigned int seed) {
+    PB12_MemBlock **holes;
+    int i;
+
+    srand(seed);
+    pb12AllocInit(mem_list, count * (2 * PB12_BENCH_LONGEST + 1), config);
+
+    /* The list is one block until the holes are freed, so this is quick. */
+    holes = (PB12_MemBlock**) malloc(count * sizeof(PB12_MemBlock*));
+    for (i=0; i<count; i++) {
+        holes[i] = pb12AllocFirstFit(mem_list, 1 + rand() % PB12_BENCH_LONGEST);
+        used[i] = pb12AllocFirstFit(mem_list, 1);
+    }
+    for (i=0; i<count; i++)
+        pb12AllocMerge(mem_list, holes[i]);
+    free(holes);
+}
+
+
+/**
+    Times allocations from two lists that start out the same, one with the
+    size tree and one by walking the list, and checks they take the same
+    blocks.  Blocks are freed again after every batch.
+
+    @param PB12_MemList *lists - Two lists.
+    @param PB12_MemBlock* (*fit[2])(PB12_MemList*, int) - Schemes to time.
+    @param int allocs - Number of allocations.
+    @param int count - Number of holes in the lists.
+    @param double *seconds - Set to the time each scheme took.
+*/
+static void pb12BenchTime(PB12_MemList *lists, PB12_MemBlock* (*fit[2])(PB12_MemList*, int),
+                          int allocs, int count, double *seconds) {
+    PB12_MemBlock *taken[2][PB12_BENCH_BATCH];
+    int length[PB12_BENCH_BATCH];
+    int batch;
+    int done;
+    int i;
+    int j;
+    clock_t start;
+
+    seconds[0] = seconds[1] = 0;
+    for (done = 0; done < allocs; done += batch) {
+        batch = allocs - done;
+        if (batch > PB12_BENCH_BATCH)
+            batch = PB12_BENCH_BATCH;
+        if (batch > count)
+            batch = count;
+
+        for (i=0; i<batch; i++)
+            length[i] = 1 + rand() % PB12_BENCH_LONGEST;
+
+        for (j=0; j<2; j++) {
+            start = clock();
+            for (i=0; i<batch; i++)
+                taken[j][i] = fit[j](&lists[j], length[i]);
+            seconds[j] += (double)(clock() - start) / CLOCKS_PER_SEC;
+        }
+
+        for (i=batch-1; i>=0; i--) {
+            if ((taken[0][i] == NULL) != (taken[1][i] == NULL) ||
+                (taken[0][i] && taken[0][i]->address != taken[1][i]->address))
+                printf("MISMATCH: allocation %d took different blocks.\n", done + i);
+            for (j=0; j<2; j++) {
+                if (taken[j][i] != NULL)
+                    pb12AllocMerge(&lists[j], taken[j][i]);
+            }
+        }
+    }
+}
+
+
+/**
+    Compares best fit and worst fit through the size tree against walking
+    the free list, with 10, 1000 and 100000 free blocks.
+
+    Usage: pb12_bench_alloc
+*/
+int main(void) {
+    static const int counts[] = { 10, 1000, 100000 };
+    PB12_MemBlock* (*best[2])(PB12_MemList*, int);
+    PB12_MemBlock* (*worst[2])(PB12_MemList*, int);
+    PB12_Config config;
+    PB12_MemList lists[2];
+    PB12_MemBlock **used[2];
+    double best_time[2];
+    double worst_time[2];
+    int allocs;
+    int c;
+    int j;
+
+    best[0] = pb12AllocBestFit;
+    best[1] = pb12AllocBestFitList;
+    worst[0] = pb12AllocWorstFit;
+    worst[1] = pb12AllocWorstFitList;
+    pb12InitConfig(&config);
+
+    printf("Nanoseconds per allocation:\n");
+    printf("%12s %12s %12s %12s %12s\n", "Free blocks",
+           "Best tree", "Best list", "Worst tree", "Worst list");
+
+    for (c=0; c<(int)(sizeof(counts) / sizeof(counts[0])); c++) {
+        allocs = (int)(PB12_BENCH_STEPS / counts[c]);
+        if (allocs > PB12_BENCH_ALLOCS)
+            allocs = PB12_BENCH_ALLOCS;
+
+        for (j=0; j<2; j++) {
+            used[j] = (PB12_MemBlock**) malloc(counts[c] * sizeof(PB12_MemBlock*));
+            pb12BenchMakeList(&lists[j], used[j], counts[c], &config, counts[c]);
+        }
+        pb12BenchTime(lists, best, allocs, counts[c], best_time);
+        pb12BenchTime(lists, worst, allocs, counts[c], worst_time);
+        for (j=0; j<2; j++) {
+            pb12AllocDestroy(&lists[j]);
+            free(used[j]);
+        }
+
+        printf("%12d %12.0f %12.0f %12.0f %12.0f\n", counts[c],
+               best_time[0] / allocs * 1e9, best_time[1] / allocs * 1e9,
+               worst_time[0] / allocs * 1e9, worst_time[1] / allocs * 1e9);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,186 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "pb12.h"
+#include "pb12_mem.h"
+#include "pb12_image.h"
+
+#define PB12_BENCH_REPEAT   2000    /* Times every file is loaded by default */
+
+
+/**
+    Loads a program the way the OS used to: the file is opened once to read
+    the memory it needs and again by pb12Load().
+
+    @param PB12_MEM *mem - Memory.
+    @param const char *filename - Path to program file.
+
+    @return int - Memory the program asks for.
+*/
+static int pb12BenchOldLoad(PB12_MEM *mem, const char *filename) {
+    FILE *fp;
+    char buffer[256];
+    int mem_req;
+
+    mem_req = 0;
+    fp = fopen(filename, "rt");
+    if (fp == NULL)
+        return 0;
+    if (fgets(buffer, 256, fp))
+        sscanf(buffer, "%d", &mem_req);
+    fclose(fp);
+
+    pb12Load(mem, 0, filename);
+    return mem_req;
+}
+
+
+/**
+    Loads a program the way the OS does now, through an image.
+
+    @param PB12_MEM *mem - Memory.
+    @param const char *filename - Path to program file.
+
+    @return int - Memory the program asks for.
+*/
+static int pb12BenchNewLoad(PB12_MEM *mem, const char *filename) {
+    PB12_Image image;
+    int mem_req;
+
+    if (pb12ReadImage(&image, filename) == PB12_FAILURE)
+        return 0;
+    pb12LoadImage(mem, 0, &image);
+    mem_req = image.mem_req;
+    pb12FreeImage(&image);
+    return mem_req;
+}
+
+
+/**
+    Times one way of loading programs.
+
+    @param PB12_MEM *mem - Memory.
+    @param int (*load)(PB12_MEM*, const char*) - Loads one program.
+    @param char **files - Program files.
+    @param int count - Number of files.
+    @param int repeat - Times every file is loaded.
+
+    @return double - Seconds taken.
+*/
+static double pb12BenchTime(PB12_MEM *mem, int (*load)(PB12_MEM*, const char*),
+                            char **files, int count, int repeat) {
+    clock_t start;
+    long sum;
+    int r;
+    int i;
+
+    sum = 0;
+    start = clock();
+    for (r=0; r<repeat; r++) {
+        for (i=0; i<count; i++)
+            sum += load(mem, files[i]);
+    }
+    if (sum < 0)
+        puts("Negative memory requirements.");
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+
+/**
+    Compares loading programs line by line with pb12Load() against reading
+    them as images with pb12ReadImage(), and reports the throughput of each.
+
+    Usage: pb12_bench_load [-n N] files
+*/
+int main(int argc, char **argv) {
+    PB12_Config config;
+    PB12_MEM old_mem;
+    PB12_MEM new_mem;
+    PB12_Image image;
+    double bytes;
+    double old_time;
+    double new_time;
+    char word[2][6];
+    char **files;
+    int count;
+    int repeat;
+    int first;
+    int i;
+    int j;
+    FILE *fp;
+
+    repeat = PB12_BENCH_REPEAT;
+    first = 1;
+    if (argc > 2 && strcmp(argv[1], "-n") == 0) {
+        sscanf(argv[2], "%d", &repeat);
+        first = 3;
+    }
+    if (first >= argc) {
+        puts("Usage: pb12_bench_load [-n N] files");
+        return EXIT_FAILURE;
+    }
+
+    pb12InitConfig(&config);
+    if (pb12InitMem(&old_mem, PB12_MEM_SIZE, &config) == PB12_FAILURE ||
+        pb12InitMem(&new_mem, PB12_MEM_SIZE, &config) == PB12_FAILURE) {
+        puts("ERROR: initializing memory.");
+        return EXIT_FAILURE;
+    }
+
+    /* Only programs that fit in memory, and that both ways load the same. */
+    files = (char**) malloc((argc - first) * sizeof(char*));
+    count = 0;
+    bytes = 0;
+    for (i=first; i<argc; i++) {
+        if (pb12ReadImage(&image, argv[i]) == PB12_FAILURE) {
+            printf("Skipping %s: cannot be read.\n", argv[i]);
+            continue;
+        }
+        j = image.length;
+        pb12FreeImage(&image);
+        if (j > PB12_MEM_SIZE) {
+            printf("Skipping %s: does not fit in memory.\n", argv[i]);
+            continue;
+        }
+
+        if (pb12BenchOldLoad(&old_mem, argv[i]) != pb12BenchNewLoad(&new_mem, argv[i]))
+            printf("MISMATCH: %s asks for different memory.\n", argv[i]);
+        for (j=0; j<PB12_MEM_SIZE; j++) {
+            pb12GetMemWord(&old_mem, j, word[0]);
+            pb12GetMemWord(&new_mem, j, word[1]);
+            if (memcmp(word[0], word[1], 6) != 0) {
+                printf("MISMATCH: %s differs at %d.\n", argv[i], j);
+                break;
+            }
+        }
+
+        fp = fopen(argv[i], "rb");
+        if (fp) {
+            fseek(fp, 0, SEEK_END);
+            bytes += ftell(fp);
+            fclose(fp);
+        }
+        files[count++] = argv[i];
+    }
+
+    if (count == 0) {
+        puts("No programs to load.");
+        return EXIT_FAILURE;
+    }
+
+    old_time = pb12BenchTime(&old_mem, pb12BenchOldLoad, files, count, repeat);
+    new_time = pb12BenchTime(&new_mem, pb12BenchNewLoad, files, count, repeat);
+    bytes *= repeat;
+
+    printf("Loaded %d programs %d times, %.0f bytes.\n", count, repeat, bytes);
+    printf("  pb12Load (fgets):  %8.3f s  %8.2f MB/s\n",
+           old_time, old_time > 0 ? bytes / old_time / 1e6 : 0.0);
+    printf("  pb12ReadImage:     %8.3f s  %8.2f MB/s\n",
+           new_time, new_time > 0 ? bytes / new_time / 1e6 : 0.0);
+
+    free(files);
+    pb12DestroyMem(&old_mem);
+    pb12DestroyMem(&new_mem);
+    return EXIT_SUCCESS;
+}
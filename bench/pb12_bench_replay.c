@@ -0,0 +1,440 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "pb12.h"
+#include "pb12_alloc.h"
+#include "pb12_buddy.h"
+#include "pb12_trace.h"
+
+#define PB12_BENCH_REPEATS  100     /* Times each allocator replays the trace by default */
+#define PB12_BENCH_SAMPLES  10      /* Points fragmentation is shown at by default */
+#define PB12_BENCH_MAX_IDS  1000000 /* Process ids a trace can name */
+
+/* An allocator a trace can be replayed against */
+typedef struct S_PB12_BenchAlloc {
+    const char *name;                               /* Name in the report */
+    const char *column;                             /* Heading in the fragmentation table */
+    unsigned int options;                           /* PB12_OPT_* it is chosen by */
+    PB12_MemBlock* (*fit)(PB12_MemList*, int);      /* Allocation scheme, or NULL for buddy */
+} PB12_BenchAlloc;
+
+static const PB12_BenchAlloc pb12BenchAllocs[] = {
+    { "First fit",       "ff",      PB12_OPT_FIRST_FIT,      pb12AllocFirstFit },
+    { "Next fit",        "nf",      PB12_OPT_NEXT_FIT,       pb12AllocNextFit },
+    { "Best fit",        "bf",      0,                       pb12AllocBestFit },
+    { "Best fit list",   "bf-list", PB12_OPT_FIRST_FIT,      pb12AllocBestFitList },
+    { "Worst fit",       "wf",      PB12_OPT_WORST_FIT,      pb12AllocWorstFit },
+    { "Worst fit list",  "wf-list", PB12_OPT_FIRST_FIT,      pb12AllocWorstFitList },
+    { "Segregated fit",  "sf",      PB12_OPT_SEGREGATED_FIT, pb12AllocSegregatedFit },
+    { "TLSF",            "tlsf",    PB12_OPT_TLSF,           pb12AllocTlsf },
+    { "Buddy",           "bd",      PB12_OPT_BUDDY,          NULL }
+};
+
+#define PB12_BENCH_ALLOC_COUNT ((int)(sizeof(pb12BenchAllocs) / sizeof(pb12BenchAllocs[0])))
+
+/* Memory being replayed into, and what happened to it */
+typedef struct S_PB12_BenchReplay {
+    const PB12_BenchAlloc *alloc;   /* Allocator replayed against */
+    PB12_Config config;             /* Settings that choose it */
+    PB12_MemList list;              /* Free memory, unless it is buddy */
+    PB12_Buddy buddy;               /* Free memory with buddy */
+    PB12_MemBlock **blocks;         /* Block of each process, or NULL */
+    int ids;                        /* Entries in blocks */
+    long failed;                    /* Allocations and resizes it could not make */
+    long fits;                      /* Waits it would have had room for */
+} PB12_BenchReplay;
+
+
+/**
+    Reads every event of a trace file.  A trace with a process id that is
+    negative or not below PB12_BENCH_MAX_IDS is not read.
+
+    @param const char *path - Trace file.
+    @param PB12_TraceEvent **events - Set to the events.
+    @param long *count - Set to the number of events.
+    @param int *size - Set to the words of memory.
+    @param int *ids - Set to one more than the largest process id.
+
+    @return int - PB12_SUCCESS or PB12_FAILURE
+*/
+static int pb12BenchLoad(const char *path, PB12_TraceEvent **events, long *count,
+                         int *size, int *ids) {
+    PB12_Trace trace;
+    PB12_TraceEvent event;
+    PB12_TraceEvent *grown;
+    long room;
+
+    if (pb12OpenTraceRead(&trace, path) == PB12_FAILURE)
+        return PB12_FAILURE;
+
+    *events = NULL;
+    *count = 0;
+    *ids = 1;
+    room = 0;
+    while (pb12TraceRead(&trace, &event) == PB12_SUCCESS) {
+        if (*count == room) {
+            room = room > 0 ? 2 * room : 1024;
+            grown = (PB12_TraceEvent*) realloc(*events, room * sizeof(PB12_TraceEvent));
+            if (grown == NULL) {
+                free(*events);
+                pb12CloseTrace(&trace);
+                return PB12_FAILURE;
+            }
+            *events = grown;
+        }
+        if (event.id < 0 || event.id >= PB12_BENCH_MAX_IDS) {
+            free(*events);
+            pb12CloseTrace(&trace);
+            return PB12_FAILURE;
+        }
+        (*events)[(*count)++] = event;
+        if (event.id >= *ids)
+            *ids = event.id + 1;
+    }
+    *size = trace.size;
+    pb12CloseTrace(&trace);
+    return PB12_SUCCESS;
+}
+
+
+/**
+    Starts a replay with all of memory free.
+
+    @param PB12_BenchReplay *replay - Replay.
+    @param const PB12_BenchAlloc *alloc - Allocator to replay against.
+    @param int size - Words of memory.
+    @param int ids - One more than the largest process id.
+
+    @return int - PB12_SUCCESS or PB12_FAILURE
+*/
+static int pb12BenchStart(PB12_BenchReplay *replay, const PB12_BenchAlloc *alloc,
+                          int size, int ids) {
+    int ret_val;
+
+    replay->alloc = alloc;
+    pb12InitConfig(&replay->config);
+    replay->config.options = alloc->options;
+    replay->ids = ids;
+    replay->failed = 0;
+    replay->fits = 0;
+    replay->blocks = (PB12_MemBlock**) calloc(ids, sizeof(PB12_MemBlock*));
+    if (replay->blocks == NULL)
+        return PB12_FAILURE;
+
+    if (alloc->fit == NULL)
+        ret_val = pb12InitBuddy(&replay->buddy, size, &replay->config);
+    else
+        ret_val = pb12AllocInit(&replay->list, size, &replay->config);
+    if (ret_val == PB12_FAILURE)
+        free(replay->blocks);
+    return ret_val;
+}
+
+
+/**
+    Ends a replay.
+
+    @param PB12_BenchReplay *replay - Replay.
+*/
+static void pb12BenchEnd(PB12_BenchReplay *replay) {
+    if (replay->alloc->fit == NULL)
+        pb12DestroyBuddy(&replay->buddy);
+    else
+        pb12AllocDestroy(&replay->list);
+    free(replay->blocks);
+}
+
+
+/**
+    Looks at the free memory of a replay.
+
+    @param PB12_BenchReplay *replay - Replay.
+    @param int *largest - Set to the words in the largest free block.
+
+    @return int - Words free.
+*/
+static int pb12BenchFree(PB12_BenchReplay *replay, int *largest) {
+    int holes;
+
+    if (replay->alloc->fit == NULL)
+        return pb12BuddyCensus(&replay->buddy, &holes, largest);
+    return pb12AllocCensus(&replay->list, &holes, largest);
+}
+
+
+/**
+    Orders blocks by address.
+
+    @param const void *a - PB12_MemBlock** of one block.
+    @param const void *b - PB12_MemBlock** of the other.
+
+    @return int - Negative, zero or positive, as for qsort().
+*/
+static int pb12BenchCompareAddress(const void *a, const void *b) {
+    return (*(PB12_MemBlock* const*)a)->address - (*(PB12_MemBlock* const*)b)->address;
+}
+
+
+/**
+    Slides every block down to address 0, as compaction did when the trace
+    was recorded.  The buddy allocator cannot be compacted, so it is not.
+
+    @param PB12_BenchReplay *replay - Replay.
+*/
+static void pb12BenchCompact(PB12_BenchReplay *replay) {
+    PB12_MemBlock **live;
+    int count;
+    int address;
+    int i;
+
+    if (replay->alloc->fit == NULL)
+        return;
+
+    live = (PB12_MemBlock**) malloc(replay->ids * sizeof(PB12_MemBlock*));
+    if (live == NULL)
+        return;
+    count = 0;
+    for (i=0; i<replay->ids; i++) {
+        if (replay->blocks[i] != NULL)
+            live[count++] = replay->blocks[i];
+    }
+    qsort(live, count, sizeof(PB12_MemBlock*), pb12BenchCompareAddress);
+
+    address = 0;
+    for (i=0; i<count; i++) {
+        live[i]->address = address;
+        address += live[i]->length;
+    }
+    pb12AllocCompacted(&replay->list, address);
+    free(live);
+}
+
+
+/**
+    Replays one event.
+
+    @param PB12_BenchReplay *replay - Replay.
+    @param const PB12_TraceEvent *event - Event.
+*/
+static void pb12BenchEvent(PB12_BenchReplay *replay, const PB12_TraceEvent *event) {
+    PB12_MemBlock **block;
+    PB12_MemBlock *moved;
+    int largest;
+    int length;
+
+    block = &replay->blocks[event->id];
+    switch (event->op) {
+    case PB12_TRACE_ALLOC:
+        if (*block != NULL)
+            break;
+        if (replay->alloc->fit == NULL)
+            *block = pb12BuddyAlloc(&replay->buddy, event->length);
+        else
+            *block = replay->alloc->fit(&replay->list, event->length);
+        if (*block == NULL)
+            ++replay->failed;
+        break;
+
+    case PB12_TRACE_FREE:
+        if (*block == NULL)
+            break;
+        if (replay->alloc->fit == NULL)
+            pb12BuddyFree(&replay->buddy, *block);
+        else
+            pb12AllocMerge(&replay->list, *block);
+        *block = NULL;
+        break;
+
+    case PB12_TRACE_WAIT:
+        /* Only looked at, so the replay goes on as the recorded run did. */
+        length = event->length;
+        if (replay->alloc->fit == NULL)
+            length = pb12BuddySize(length);
+        pb12BenchFree(replay, &largest);
+        if (largest >= length)
+            ++replay->fits;
+        break;
+
+    case PB12_TRACE_COMPACT:
+        pb12BenchCompact(replay);
+        break;
+
+    case PB12_TRACE_RESIZE:
+        /* Where it is if it can be, as the OS does, and moved if not. */
+        if (*block == NULL)
+            break;
+        if (replay->alloc->fit == NULL) {
+            if (pb12BuddyResize(&replay->buddy, *block, event->length) == PB12_SUCCESS)
+                break;
+            moved = pb12BuddyAlloc(&replay->buddy, event->length);
+            if (moved != NULL)
+                pb12BuddyFree(&replay->buddy, *block);
+        }
+        else {
+            if (pb12AllocResize(&replay->list, *block, event->length) == PB12_SUCCESS)
+                break;
+            moved = replay->alloc->fit(&replay->list, event->length);
+            if (moved != NULL)
+                pb12AllocMerge(&replay->list, *block);
+        }
+        if (moved != NULL)
+            *block = moved;
+        else
+            ++replay->failed;
+        break;
+    }
+}
+
+
+/**
+    Gives the external fragmentation of free memory: how much of it is not
+    in the largest free block.
+
+    @param PB12_BenchReplay *replay - Replay.
+
+    @return double - Percent of free memory.
+*/
+static double pb12BenchFragmentation(PB12_BenchReplay *replay) {
+    int free_words;
+    int largest;
+
+    free_words = pb12BenchFree(replay, &largest);
+    return free_words > 0 ? 100.0 * (free_words - largest) / free_words : 0.0;
+}
+
+
+/**
+    Replays a trace against every allocator, timing each over many replays
+    and then replaying it once more to measure search lengths, failures and
+    fragmentation after every event.
+
+    Usage: pb12_bench_replay [-n N] [-s S] trace
+
+    -n N  Replay the trace N times for the timing (default 100)
+    -s S  Show fragmentation at S points of the trace (default 10)
+*/
+int main(int argc, char **argv) {
+    PB12_BenchReplay replay;
+    PB12_TraceEvent *events;
+    double frag[PB12_BENCH_ALLOC_COUNT];
+    double peak[PB12_BENCH_ALLOC_COUNT];
+    double *samples;
+    double percent;
+    double seconds;
+    clock_t start;
+    const char *path;
+    long op_count[256];
+    long count;
+    long attempts;
+    unsigned long visited;
+    long e;
+    int repeats;
+    int sample_count;
+    int size;
+    int ids;
+    int a;
+    int r;
+    int i;
+
+    repeats = PB12_BENCH_REPEATS;
+    sample_count = PB12_BENCH_SAMPLES;
+    path = NULL;
+    for (i=1; i<argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+            repeats = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+            sample_count = atoi(argv[++i]);
+        else
+            path = argv[i];
+    }
+    if (path == NULL || repeats < 1 || sample_count < 1) {
+        printf("Usage: pb12_bench_replay [-n N] [-s S] trace\n");
+        return EXIT_FAILURE;
+    }
+
+    if (pb12BenchLoad(path, &events, &count, &size, &ids) == PB12_FAILURE) {
+        printf("ERROR: Could not read trace '%s'.\n", path);
+        return EXIT_FAILURE;
+    }
+    if (count < sample_count)
+        sample_count = count > 0 ? (int)count : 1;
+    samples = (double*) calloc(sample_count * PB12_BENCH_ALLOC_COUNT, sizeof(double));
+    if (samples == NULL) {
+        free(events);
+        return EXIT_FAILURE;
+    }
+
+    memset(op_count, 0, sizeof(op_count));
+    for (e=0; e<count; e++)
+        ++op_count[events[e].op & 0xff];
+    printf("Trace %s: %d words, %ld events (%ld allocations, %ld frees, %ld waits, "
+           "%ld compactions, %ld resizes)\n\n", path, size, count, op_count[PB12_TRACE_ALLOC],
+           op_count[PB12_TRACE_FREE], op_count[PB12_TRACE_WAIT],
+           op_count[PB12_TRACE_COMPACT], op_count[PB12_TRACE_RESIZE]);
+
+    printf("%-15s %14s %11s %7s %10s %13s %14s\n", "Allocator", "Events/sec",
+           "Avg search", "Failed", "Would fit", "Avg ext frag", "Peak ext frag");
+    for (a=0; a<PB12_BENCH_ALLOC_COUNT; a++) {
+        seconds = 0;
+        for (r=0; r<repeats; r++) {
+            if (pb12BenchStart(&replay, &pb12BenchAllocs[a], size, ids) == PB12_FAILURE) {
+                printf("ERROR: Could not start replay.\n");
+                return EXIT_FAILURE;
+            }
+            start = clock();
+            for (e=0; e<count; e++)
+                pb12BenchEvent(&replay, &events[e]);
+            seconds += (double)(clock() - start) / CLOCKS_PER_SEC;
+            pb12BenchEnd(&replay);
+        }
+
+        /* Once more, looking at memory after every event. */
+        if (pb12BenchStart(&replay, &pb12BenchAllocs[a], size, ids) == PB12_FAILURE) {
+            printf("ERROR: Could not start replay.\n");
+            return EXIT_FAILURE;
+        }
+        frag[a] = 0;
+        peak[a] = 0;
+        i = 0;
+        for (e=0; e<count; e++) {
+            pb12BenchEvent(&replay, &events[e]);
+            percent = pb12BenchFragmentation(&replay);
+            frag[a] += percent;
+            if (percent > peak[a])
+                peak[a] = percent;
+            while (i < sample_count && e == (long)(i + 1) * count / sample_count - 1)
+                samples[i++ * PB12_BENCH_ALLOC_COUNT + a] = percent;
+        }
+
+        /* Waits are only looked at, so only allocations and resizes search. */
+        attempts = op_count[PB12_TRACE_ALLOC] + op_count[PB12_TRACE_RESIZE];
+        visited = pb12BenchAllocs[a].fit == NULL ? replay.buddy.visited : replay.list.visited;
+        printf("%-15s %14.0f %11.2f %7ld %10ld %12.2f%% %13.2f%%\n",
+               pb12BenchAllocs[a].name,
+               seconds > 0 ? count * (double)repeats / seconds : 0.0,
+               attempts > 0 ? (double)visited / attempts : 0.0,
+               replay.failed, replay.fits,
+               count > 0 ? frag[a] / count : 0.0, peak[a]);
+        pb12BenchEnd(&replay);
+    }
+
+    printf("\nExternal fragmentation over the trace (%% of free memory not in the largest block):\n");
+    printf("%8s %8s", "Event", "Tick");
+    for (a=0; a<PB12_BENCH_ALLOC_COUNT; a++)
+        printf(" %7s", pb12BenchAllocs[a].column);
+    printf("\n");
+    for (i=0; i<sample_count; i++) {
+        e = (long)(i + 1) * count / sample_count - 1;
+        if (e < 0)
+            continue;
+        printf("%8ld %8lu", e + 1, events[e].tick);
+        for (a=0; a<PB12_BENCH_ALLOC_COUNT; a++)
+            printf(" %7.2f", samples[i * PB12_BENCH_ALLOC_COUNT + a]);
+        printf("\n");
+    }
+
+    free(samples);
+    free(events);
+    return EXIT_SUCCESS;
+}
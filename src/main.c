@@ -10,6 +10,7 @@
 
 int main(int argc, char **argv) {
     PB12_PBrain pbrain;
+    PB12_Config config;
     int i;
     int flag_count;
     bool folder_loader;
@@ -19,6 +20,7 @@ int main(int argc, char **argv) {
     struct stat s;
 
     folder_loader = false;
+    pb12InitConfig(&config);
 
     flag_count = 0;
 
@@ -36,44 +38,139 @@ int main(int argc, char **argv) {
             puts(" -v    Verbose output");
             puts(" -m    Display messages");
             puts(" -t N  Set time step to N instructions");
+            puts(" -e E  Execution engine E: switch (default), threaded, jit, aot or loop");
             puts(" -ff   First fit allocation");
+            puts(" -nf   Next fit allocation");
             puts(" -bf   Best fit allocation");
             puts(" -wf   Worst fit allocation");
+            puts(" -sf   Segregated fit allocation");
+            puts(" -bd   Buddy allocation");
+            puts(" -tlsf Two-level segregated fit allocation");
+            puts(" -c N  Compact memory for a program that does not fit, moving at most N words");
+            puts(" -pg   Paged memory, loading pages when they are first used");
+            puts(" -sw   Swap blocked processes out when a program does not fit");
+            puts(" -r F  Record allocations and frees to trace file F");
+            puts(" -a F  Write allocator telemetry to F, as JSON if it ends in .json, else CSV");
+            puts(" -s    Report memory accesses verified when programs load");
             puts(" -d D  Load all programs that are in directory D");
             return EXIT_SUCCESS;
         }
 
         else if (strcmp(argv[i], "-v") == 0) {
             ++flag_count;
-            pb12Options |= PB12_OPT_VERBOSE;
+            config.options |= PB12_OPT_VERBOSE;
         }
 
         else if (strcmp(argv[i], "-m") == 0) {
             ++flag_count;
-            pb12Options |= PB12_OPT_MESSAGES;
+            config.options |= PB12_OPT_MESSAGES;
         }
 
         else if (strcmp(argv[i], "-t") == 0) {
             flag_count += 2;
-            pb12Options |= PB12_OPT_TIMESTEP;
+            config.options |= PB12_OPT_TIMESTEP;
 
             i++;
-            sscanf(argv[i], "%d", &pb12TimeStep);
+            sscanf(argv[i], "%d", &config.time_step);
+        }
+
+        else if (strcmp(argv[i], "-e") == 0) {
+            flag_count += 2;
+
+            i++;
+            if (strcmp(argv[i], "switch") == 0) {
+                config.engine = PB12_ENGINE_SWITCH;
+            }
+            else if (strcmp(argv[i], "threaded") == 0) {
+                config.engine = PB12_ENGINE_THREADED;
+            }
+            else if (strcmp(argv[i], "jit") == 0) {
+                config.engine = PB12_ENGINE_JIT;
+            }
+            else if (strcmp(argv[i], "aot") == 0) {
+                config.engine = PB12_ENGINE_AOT;
+            }
+            else if (strcmp(argv[i], "loop") == 0) {
+                config.engine = PB12_ENGINE_LOOP;
+            }
+            else {
+                printf("ERROR: Unknown execution engine '%s'.\n", argv[i]);
+                return EXIT_FAILURE;
+            }
         }
 
         else if (strcmp(argv[i], "-ff") == 0) {
             ++flag_count;
-            pb12Options |= PB12_OPT_FIRST_FIT;
+            config.options |= PB12_OPT_FIRST_FIT;
+        }
+
+        else if (strcmp(argv[i], "-nf") == 0) {
+            ++flag_count;
+            config.options |= PB12_OPT_NEXT_FIT;
         }
 
         else if (strcmp(argv[i], "-bf") == 0) {
             ++flag_count;
-            pb12Options |= PB12_OPT_BEST_FIT;
+            config.options |= PB12_OPT_BEST_FIT;
         }
 
         else if (strcmp(argv[i], "-wf") == 0) {
             ++flag_count;
-            pb12Options |= PB12_OPT_WORST_FIT;
+            config.options |= PB12_OPT_WORST_FIT;
+        }
+
+        else if (strcmp(argv[i], "-sf") == 0) {
+            ++flag_count;
+            config.options |= PB12_OPT_SEGREGATED_FIT;
+        }
+
+        else if (strcmp(argv[i], "-bd") == 0) {
+            ++flag_count;
+            config.options |= PB12_OPT_BUDDY;
+        }
+
+        else if (strcmp(argv[i], "-tlsf") == 0) {
+            ++flag_count;
+            config.options |= PB12_OPT_TLSF;
+        }
+
+        else if (strcmp(argv[i], "-c") == 0) {
+            flag_count += 2;
+            config.options |= PB12_OPT_COMPACT;
+
+            i++;
+            sscanf(argv[i], "%d", &config.compact_limit);
+        }
+
+        else if (strcmp(argv[i], "-pg") == 0) {
+            ++flag_count;
+            config.options |= PB12_OPT_PAGED;
+        }
+
+        else if (strcmp(argv[i], "-r") == 0) {
+            flag_count += 2;
+            config.options |= PB12_OPT_TRACE;
+
+            i++;
+            config.trace_path = argv[i];
+        }
+
+        else if (strcmp(argv[i], "-a") == 0) {
+            flag_count += 2;
+            config.options |= PB12_OPT_TELEMETRY;
+
+            i++;
+            config.telemetry_path = argv[i];
+        }
+
+        else if (strcmp(argv[i], "-sw") == 0) {
+            ++flag_count;
+            config.options |= PB12_OPT_SWAP;
+        }
+
+        else if (strcmp(argv[i], "-s") == 0) {
+            ++flag_count;
+            config.options |= PB12_OPT_VERIFY;
         }
 
         else if (strcmp(argv[i], "-d") == 0) {
@@ -82,7 +179,7 @@ int main(int argc, char **argv) {
         }
     }
 
-    if (pb12InitPBrain(&pbrain, PB12_MEM_SIZE) == PB12_FAILURE) {
+    if (pb12InitPBrain(&pbrain, PB12_MEM_SIZE, &config) == PB12_FAILURE) {
         puts("Error initializing PBrain12");
         return EXIT_FAILURE;
     }
@@ -123,6 +220,20 @@ int main(int argc, char **argv) {
 
     printf("\n");
     pb12PrintStats(pbrain.os.stats, pbrain.os.next_pid);
+    if (config.options & PB12_OPT_PAGED)
+        pb12MmuPrint(&pbrain.os.mmu);
+    else if (config.options & PB12_OPT_BUDDY)
+        pb12PoolPrint(&pbrain.os.buddy.pool);
+    else
+        pb12PoolPrint(&pbrain.os.free_list.pool);
+    if (config.options & PB12_OPT_COMPACT) {
+        printf("Compactions: %d, %ld words moved\n",
+               pbrain.os.compactions, pbrain.os.words_moved);
+    }
+    if (config.options & PB12_OPT_TELEMETRY &&
+        pb12WriteTelemetry(&pbrain.os.telemetry, config.telemetry_path) == PB12_FAILURE) {
+        printf("Error writing telemetry to %s\n", config.telemetry_path);
+    }
 
     pb12DestroyPBrain(&pbrain);
 
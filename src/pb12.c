@@ -2,19 +2,34 @@
 #include <stdarg.h>
 #include "pb12.h"
 
-unsigned int pb12Options = 0;
-int pb12TimeStep = 0;
+/**
+    Fill in the default settings: no options, the switch engine and the
+    time slices the C library's unseeded rand() would give.
+
+    @param PB12_Config *config - Settings.
+*/
+void pb12InitConfig(PB12_Config *config) {
+    config->options = 0;
+    config->time_step = 0;
+    config->engine = PB12_ENGINE_SWITCH;
+    config->seed = 1;
+    config->compact_limit = 0;
+    config->trace_path = NULL;
+    config->telemetry_path = NULL;
+}
+
 
 /**
     Called when an error occurs.  Only displayed if using -m flag.
 
+    @param const PB12_Config *config - Settings of the VM.
     @param const char *format - Format string, like printf
     @param ... - Variable arguments, like printf
 */
-void pb12ErrorMsg(const char *format, ...) {
+void pb12ErrorMsg(const PB12_Config *config, const char *format, ...) {
     va_list args;
 
-    if (pb12Options & PB12_OPT_MESSAGES) {
+    if (config->options & PB12_OPT_MESSAGES) {
         va_start(args, format);
         vfprintf(stderr, format, args);
         va_end(args);
@@ -5,6 +5,7 @@
 #define PB12_SUCCESS        0
 #define PB12_FAILURE        1
 #define PB12_TERMINATE      2
+#define PB12_NOT_RUN        -1  /* No native code ran, interpret instead */
 
 /* Options */
 #define PB12_OPT_VERBOSE    1
@@ -13,6 +14,23 @@
 #define PB12_OPT_FIRST_FIT  8
 #define PB12_OPT_BEST_FIT   16
 #define PB12_OPT_WORST_FIT  32
+#define PB12_OPT_VERIFY     64  /* Report what was proved about each program */
+#define PB12_OPT_SEGREGATED_FIT 128 /* Allocate from size class bins */
+#define PB12_OPT_BUDDY      256 /* Binary buddy allocation */
+#define PB12_OPT_NEXT_FIT   512 /* First fit, from where the last search ended */
+#define PB12_OPT_TLSF       1024 /* Two-level segregated fit */
+#define PB12_OPT_COMPACT    2048 /* Compact memory when a program will not fit */
+#define PB12_OPT_PAGED      4096 /* Paged memory instead of one block per process */
+#define PB12_OPT_SWAP       8192 /* Swap blocked processes out to make room */
+#define PB12_OPT_TRACE      16384 /* Record allocations to a trace file */
+#define PB12_OPT_TELEMETRY  32768 /* Sample the allocator for a time series */
+
+/* Execution engines */
+#define PB12_ENGINE_SWITCH      0
+#define PB12_ENGINE_THREADED    1
+#define PB12_ENGINE_JIT         2
+#define PB12_ENGINE_AOT         3
+#define PB12_ENGINE_LOOP        4   /* Interpreter, skipping counting loops */
 
 #define PB12_MEM_SIZE       1000
 #define PB12_PROC_SIZE      100
@@ -41,21 +59,49 @@ typedef enum S_PB12_ERROR {
     PB12_ERORR_INIT_MEM,
     PB12_ERROR_INIT_OS,
     PB12_ERROR_PCB_NOT_FOUND,
-    PB12_ERROR_MOVING_PCB
+    PB12_ERROR_MOVING_PCB,
+    PB12_ERROR_INIT_JIT,
+    PB12_ERROR_INIT_NATIVE,
+    PB12_ERROR_TRANSLATING,
+    PB12_ERROR_INIT_LOOP,
+    PB12_ERROR_PAGE_FAULT,
+    PB12_ERROR_SWAP
 } PB12_ERROR;
 
 
-extern unsigned int pb12Options;
-extern int pb12TimeStep;
+/*
+    Settings of one virtual machine.  Everything a VM needs to know about
+    how it was started is kept here instead of in globals, so that any
+    number of them can run in the same process.
+*/
+typedef struct S_PB12_Config {
+    unsigned int options;   /* PB12_OPT_* flags */
+    int time_step;          /* Time slice with PB12_OPT_TIMESTEP */
+    int engine;             /* PB12_ENGINE_* used to execute instructions */
+    unsigned long seed;     /* Seed for random time slices */
+    int compact_limit;      /* Most words one compaction may move */
+    const char *trace_path; /* File allocations are recorded to with PB12_OPT_TRACE */
+    const char *telemetry_path; /* File samples are written to with PB12_OPT_TELEMETRY */
+} PB12_Config;
+
+
+/**
+    Fill in the default settings: no options, the switch engine and the
+    time slices the C library's unseeded rand() would give.
+
+    @param PB12_Config *config - Settings.
+*/
+void pb12InitConfig(PB12_Config *config);
 
 
 /**
     Called when an error occurs.  Only displayed if using -m flag.
 
+    @param const PB12_Config *config - Settings of the VM.
     @param const char *format - Format string, like printf
     @param ... - Variable arguments, like printf
 */
-void pb12ErrorMsg(const char *format, ...);
+void pb12ErrorMsg(const PB12_Config *config, const char *format, ...);
 
 
 #endif /* PB12_H */
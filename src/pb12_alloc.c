@@ -5,20 +5,634 @@
 #include "pb12.h"
 #include "pb12_alloc.h"
 
+/**
+    Makes a slab of memory blocks and puts them on the free list of a pool.
+
+    @param PB12_MemPool *pool - Pool of memory blocks.
+
+    @return int - PB12_SUCCESS or PB12_FAILURE
+*/
+static int pb12PoolGrow(PB12_MemPool *pool) {
+    PB12_MemBlock *slab;
+    int i;
+
+    /* The first block only links the slabs together. */
+    slab = (PB12_MemBlock*) malloc((pool->slab_size + 1) * sizeof(PB12_MemBlock));
+    if (slab == NULL)
+        return PB12_FAILURE;
+    slab[0].next = pool->slabs;
+    pool->slabs = slab;
+    ++pool->slab_count;
+
+    for (i=pool->slab_size; i>=1; i--) {
+        slab[i].next = pool->free;
+        pool->free = &slab[i];
+    }
+    return PB12_SUCCESS;
+}
+
+
+/**
+    Initializes a pool of memory blocks, making its first slab.
+
+    @param PB12_MemPool *pool - Pool to initialize.
+    @param int blocks - Most blocks that will be in use at once.
+
+    @return int - PB12_SUCCESS or PB12_FAILURE
+*/
+int pb12InitPool(PB12_MemPool *pool, int blocks) {
+    pool->free = NULL;
+    pool->slabs = NULL;
+    pool->slab_count = 0;
+    pool->used = 0;
+    pool->high = 0;
+
+    /* Only lists far larger than the VM's need more than one slab. */
+    pool->slab_size = blocks < 1 ? 1 : blocks;
+    if (pool->slab_size > PB12_POOL_SLAB)
+        pool->slab_size = PB12_POOL_SLAB;
+
+    return pb12PoolGrow(pool);
+}
+
+
+/**
+    Frees a pool and every block that came from it.
+
+    @param PB12_MemPool *pool - Pool of memory blocks.
+*/
+void pb12DestroyPool(PB12_MemPool *pool) {
+    PB12_MemBlock *slab;
+
+    while (pool->slabs != NULL) {
+        slab = pool->slabs;
+        pool->slabs = slab[0].next;
+        free(slab);
+    }
+    pool->free = NULL;
+    pool->used = 0;
+}
+
+
+/**
+    Takes a memory block from a pool, making a new slab if it has run out.
+
+    @param PB12_MemPool *pool - Pool of memory blocks.
+
+    @return PB12_MemBlock* - Memory block, or NULL if out of memory
+*/
+PB12_MemBlock* pb12PoolGet(PB12_MemPool *pool) {
+    PB12_MemBlock *mem_block;
+
+    if (pool->free == NULL && pb12PoolGrow(pool) == PB12_FAILURE)
+        return NULL;
+
+    mem_block = pool->free;
+    pool->free = mem_block->next;
+    if (++pool->used > pool->high)
+        pool->high = pool->used;
+    return mem_block;
+}
+
+
+/**
+    Gives a memory block back to the pool it came from.
+
+    @param PB12_MemPool *pool - Pool of memory blocks.
+    @param PB12_MemBlock *mem_block - Memory block from pb12PoolGet().
+*/
+void pb12PoolPut(PB12_MemPool *pool, PB12_MemBlock *mem_block) {
+    mem_block->next = pool->free;
+    pool->free = mem_block;
+    --pool->used;
+}
+
+
+/**
+    Prints the high-water mark of a pool.
+
+    @param const PB12_MemPool *pool - Pool of memory blocks.
+*/
+void pb12PoolPrint(const PB12_MemPool *pool) {
+    printf("Memory block pool: %d of %d blocks in use at most, in %d slab%s\n",
+           pool->high, pool->slab_size * pool->slab_count, pool->slab_count,
+           pool->slab_count == 1 ? "" : "s");
+}
+
+
+/**
+    Get the power of two a length is at least.
+
+    @param int length - Length of a block, at least 1.
+
+    @return int - Largest k with 2^k no more than length.
+*/
+static int pb12AllocLog2(int length) {
+    int k;
+
+#ifdef __GNUC__
+    k = (int)(sizeof(unsigned int) * CHAR_BIT - 1) - __builtin_clz((unsigned int)length);
+#else
+    for (k=0; (length >> k) > 1; k++)
+        ;
+#endif
+    return k;
+}
+
+
+/**
+    Find the first bin that is not empty.
+
+    @param unsigned long map - Bins that are not empty, not 0.
+
+    @return int - Lowest bin in map.
+*/
+static int pb12AllocLowestBin(unsigned long map) {
+    int k;
+
+#ifdef __GNUC__
+    k = __builtin_ctzl(map);
+#else
+    for (k=0; !(map & 1); k++)
+        map >>= 1;
+#endif
+    return k;
+}
+
+
+/**
+    Get the size class of a length, the bin a block that long belongs in.
+
+    @param int length - Length of a block.
+    @param int *fl - Set to the row of the bin, the power of two.
+    @param int *sl - Set to the bin in that row.
+*/
+static void pb12AllocClass(int length, int *fl, int *sl) {
+    int k;
+
+    if (length < PB12_ALLOC_SL) {
+        *fl = 0;
+        *sl = length < 0 ? 0 : length;
+    }
+    else {
+        k = pb12AllocLog2(length);
+        *fl = k - PB12_ALLOC_SL_BITS + 1;
+        *sl = (length >> (k - PB12_ALLOC_SL_BITS)) - PB12_ALLOC_SL;
+    }
+}
+
+
+/**
+    Get the first size class whose blocks all have at least length words.
+
+    @param int length - Required size of memory
+    @param int *fl - Set to the row of the bin.
+    @param int *sl - Set to the bin in that row.
+
+    @return int - Nonzero if there is such a class.
+*/
+static int pb12AllocFitClass(int length, int *fl, int *sl) {
+    int smallest;
+
+    pb12AllocClass(length, fl, sl);
+
+    /* Shortest block the class can hold */
+    if (*fl == 0)
+        smallest = *sl;
+    else
+        smallest = (PB12_ALLOC_SL + *sl) << (*fl - 1);
+
+    if (smallest < length && ++*sl == PB12_ALLOC_SL) {
+        *sl = 0;
+        ++*fl;
+    }
+    return *fl < PB12_ALLOC_FL;
+}
+
+
+/**
+    Find the first bin that is not empty at or after a size class.
+
+    @param const PB12_MemList *mem_list - List of memory blocks
+    @param int fl - Row of the first bin to look in.
+    @param int sl - First bin to look in, in that row.
+
+    @return PB12_MemBlock* - First block of that bin, else NULL
+*/
+static PB12_MemBlock* pb12AllocFindBin(const PB12_MemList *mem_list, int fl, int sl) {
+    unsigned long map;
+
+    map = mem_list->sl_map[fl] & (~0UL << sl);
+    if (map == 0) {
+        if (fl + 1 >= PB12_ALLOC_FL)
+            return NULL;
+        map = mem_list->fl_map & (~0UL << (fl + 1));
+        if (map == 0)
+            return NULL;
+        fl = pb12AllocLowestBin(map);
+        map = mem_list->sl_map[fl];
+    }
+    return mem_list->bin[fl][pb12AllocLowestBin(map)];
+}
+
+
+/**
+    Puts a free block into the bin of its size class.
+
+    @param PB12_MemList *mem_list - List of memory blocks
+    @param PB12_MemBlock *mem_block - Memory block
+*/
+static void pb12AllocBin(PB12_MemList *mem_list, PB12_MemBlock *mem_block) {
+    int fl;
+    int sl;
+
+    pb12AllocClass(mem_block->length, &fl, &sl);
+    mem_block->bin_prev = NULL;
+    mem_block->bin_next = mem_list->bin[fl][sl];
+    if (mem_list->bin[fl][sl] != NULL)
+        mem_list->bin[fl][sl]->bin_prev = mem_block;
+    mem_list->bin[fl][sl] = mem_block;
+    mem_list->sl_map[fl] |= 1UL << sl;
+    mem_list->fl_map |= 1UL << fl;
+}
+
+
+/**
+    Takes a block out of the bin of its size class.
+
+    @param PB12_MemList *mem_list - List of memory blocks
+    @param PB12_MemBlock *mem_block - Memory block
+*/
+static void pb12AllocUnbin(PB12_MemList *mem_list, PB12_MemBlock *mem_block) {
+    int fl;
+    int sl;
+
+    pb12AllocClass(mem_block->length, &fl, &sl);
+    if (mem_block->bin_prev == NULL)
+        mem_list->bin[fl][sl] = mem_block->bin_next;
+    else
+        mem_block->bin_prev->bin_next = mem_block->bin_next;
+    if (mem_block->bin_next != NULL)
+        mem_block->bin_next->bin_prev = mem_block->bin_prev;
+
+    if (mem_list->bin[fl][sl] == NULL) {
+        mem_list->sl_map[fl] &= ~(1UL << sl);
+        if (mem_list->sl_map[fl] == 0)
+            mem_list->fl_map &= ~(1UL << fl);
+    }
+}
+
+
+/**
+    Check whether a block comes before another in the size tree: it is
+    smaller, or as long and pushed later.
+
+    @param const PB12_MemBlock *a - Memory block
+    @param const PB12_MemBlock *b - Memory block
+
+    @return int - Nonzero if a comes first.
+*/
+static int pb12AllocBefore(const PB12_MemBlock *a, const PB12_MemBlock *b) {
+    return a->length < b->length || (a->length == b->length && a->seq > b->seq);
+}
+
+
+/**
+    Get the height of a subtree of the size tree.
+
+    @param const PB12_MemBlock *node - Root of the subtree, or NULL.
+
+    @return int - Height, 0 for an empty subtree.
+*/
+static int pb12AllocHeight(const PB12_MemBlock *node) {
+    return node == NULL ? 0 : node->height;
+}
+
+
+/**
+    Work out the height of a node from its children.
+
+    @param PB12_MemBlock *node - Node of the size tree.
+*/
+static void pb12AllocUpdate(PB12_MemBlock *node) {
+    int left;
+    int right;
+
+    left = pb12AllocHeight(node->left);
+    right = pb12AllocHeight(node->right);
+    node->height = (left > right ? left : right) + 1;
+}
+
+
+/**
+    Rotate a subtree so its left child becomes its root.
+
+    @param PB12_MemBlock *node - Root of the subtree.
+
+    @return PB12_MemBlock* - New root of the subtree.
+*/
+static PB12_MemBlock* pb12AllocRotateRight(PB12_MemBlock *node) {
+    PB12_MemBlock *top;
+
+    top = node->left;
+    node->left = top->right;
+    top->right = node;
+    pb12AllocUpdate(node);
+    pb12AllocUpdate(top);
+    return top;
+}
+
+
+/**
+    Rotate a subtree so its right child becomes its root.
+
+    @param PB12_MemBlock *node - Root of the subtree.
+
+    @return PB12_MemBlock* - New root of the subtree.
+*/
+static PB12_MemBlock* pb12AllocRotateLeft(PB12_MemBlock *node) {
+    PB12_MemBlock *top;
+
+    top = node->right;
+    node->right = top->left;
+    top->left = node;
+    pb12AllocUpdate(node);
+    pb12AllocUpdate(top);
+    return top;
+}
+
+
+/**
+    Restore the balance of a subtree whose children differ in height by at
+    most two.
+
+    @param PB12_MemBlock *node - Root of the subtree.
+
+    @return PB12_MemBlock* - New root of the subtree.
+*/
+static PB12_MemBlock* pb12AllocBalance(PB12_MemBlock *node) {
+    int skew;
+
+    pb12AllocUpdate(node);
+    skew = pb12AllocHeight(node->left) - pb12AllocHeight(node->right);
+
+    if (skew > 1) {
+        if (pb12AllocHeight(node->left->left) < pb12AllocHeight(node->left->right))
+            node->left = pb12AllocRotateLeft(node->left);
+        return pb12AllocRotateRight(node);
+    }
+    if (skew < -1) {
+        if (pb12AllocHeight(node->right->right) < pb12AllocHeight(node->right->left))
+            node->right = pb12AllocRotateRight(node->right);
+        return pb12AllocRotateLeft(node);
+    }
+    return node;
+}
+
+
+/**
+    Put a block into the size tree.
+
+    @param PB12_MemBlock *node - Root of the subtree, or NULL.
+    @param PB12_MemBlock *mem_block - Memory block
+
+    @return PB12_MemBlock* - New root of the subtree.
+*/
+static PB12_MemBlock* pb12AllocTreeInsert(PB12_MemBlock *node, PB12_MemBlock *mem_block) {
+    if (node == NULL) {
+        mem_block->left = NULL;
+        mem_block->right = NULL;
+        mem_block->height = 1;
+        return mem_block;
+    }
+
+    if (pb12AllocBefore(mem_block, node))
+        node->left = pb12AllocTreeInsert(node->left, mem_block);
+    else
+        node->right = pb12AllocTreeInsert(node->right, mem_block);
+    return pb12AllocBalance(node);
+}
+
+
+/**
+    Take the first block out of a subtree of the size tree.
+
+    @param PB12_MemBlock *node - Root of the subtree.
+    @param PB12_MemBlock **first - Set to the block taken out.
+
+    @return PB12_MemBlock* - New root of the subtree.
+*/
+static PB12_MemBlock* pb12AllocTreeFirst(PB12_MemBlock *node, PB12_MemBlock **first) {
+    if (node->left == NULL) {
+        *first = node;
+        return node->right;
+    }
+
+    node->left = pb12AllocTreeFirst(node->left, first);
+    return pb12AllocBalance(node);
+}
+
+
+/**
+    Take a block out of the size tree.
+
+    @param PB12_MemBlock *node - Root of the subtree holding the block.
+    @param PB12_MemBlock *mem_block - Memory block
+
+    @return PB12_MemBlock* - New root of the subtree.
+*/
+static PB12_MemBlock* pb12AllocTreeDelete(PB12_MemBlock *node, PB12_MemBlock *mem_block) {
+    PB12_MemBlock *next;
+
+    if (node == mem_block) {
+        if (node->left == NULL)
+            return node->right;
+        if (node->right == NULL)
+            return node->left;
+
+        /* The block after it takes its place. */
+        node->right = pb12AllocTreeFirst(node->right, &next);
+        next->left = node->left;
+        next->right = node->right;
+        return pb12AllocBalance(next);
+    }
+
+    if (pb12AllocBefore(mem_block, node))
+        node->left = pb12AllocTreeDelete(node->left, mem_block);
+    else
+        node->right = pb12AllocTreeDelete(node->right, mem_block);
+    return pb12AllocBalance(node);
+}
+
+
+/**
+    Find the first block in the size tree that is at least a given length.
+
+    @param PB12_MemList *mem_list - List of memory blocks
+    @param int length - Required size of memory
+
+    @return PB12_MemBlock* - Smallest block at least length long, else NULL
+*/
+static PB12_MemBlock* pb12AllocTreeFind(PB12_MemList *mem_list, int length) {
+    PB12_MemBlock *node;
+    PB12_MemBlock *found;
+
+    found = NULL;
+    node = mem_list->root;
+    while (node != NULL) {
+        ++mem_list->visited;
+        if (node->length >= length) {
+            found = node;
+            node = node->left;
+        }
+        else {
+            node = node->right;
+        }
+    }
+    return found;
+}
+
+
+/**
+    Check whether a block can be tagged: it has words, all of them in the
+    memory the list manages.
+
+    @param const PB12_MemList *mem_list - List of memory blocks
+    @param const PB12_MemBlock *mem_block - Memory block
+
+    @return int - Nonzero if the block is tagged while it is free.
+*/
+static int pb12AllocTagged(const PB12_MemList *mem_list, const PB12_MemBlock *mem_block) {
+    return mem_block->length > 0 && mem_block->address >= 0 &&
+           mem_block->address <= mem_list->size - mem_block->length;
+}
+
+
+/**
+    Tags both ends of a free block.
+
+    @param PB12_MemList *mem_list - List of memory blocks
+    @param PB12_MemBlock *mem_block - Memory block
+*/
+static void pb12AllocTag(PB12_MemList *mem_list, PB12_MemBlock *mem_block) {
+    if (pb12AllocTagged(mem_list, mem_block)) {
+        mem_list->starts[mem_block->address] = mem_block;
+        mem_list->ends[mem_block->address + mem_block->length] = mem_block;
+    }
+}
+
+
+/**
+    Removes the tags of a block that is no longer free.
+
+    @param PB12_MemList *mem_list - List of memory blocks
+    @param PB12_MemBlock *mem_block - Memory block
+*/
+static void pb12AllocUntag(PB12_MemList *mem_list, PB12_MemBlock *mem_block) {
+    if (pb12AllocTagged(mem_list, mem_block)) {
+        mem_list->starts[mem_block->address] = NULL;
+        mem_list->ends[mem_block->address + mem_block->length] = NULL;
+    }
+}
+
+
+/**
+    Joins a free neighbor onto a block being freed, and frees the neighbor.
+
+    @param PB12_MemList *mem_list - List of memory blocks
+    @param PB12_MemBlock *mem_block - Memory block being freed
+    @param PB12_MemBlock *neighbor - Free block just before or after it
+*/
+static void pb12AllocJoin(PB12_MemList *mem_list, PB12_MemBlock *mem_block,
+                          PB12_MemBlock *neighbor) {
+    if (mem_list->config->options & PB12_OPT_VERBOSE) {
+        printf("Merging memory [%d-%d:%d] with [%d-%d:%d] making ",
+               mem_block->address, mem_block->address + mem_block->length - 1, mem_block->length,
+               neighbor->address, neighbor->address + neighbor->length - 1, neighbor->length);
+    }
+
+    if (neighbor->address < mem_block->address)
+        mem_block->address = neighbor->address;
+    mem_block->length += neighbor->length;
+    pb12PoolPut(&mem_list->pool, pb12AllocRemove(mem_list, neighbor->prev, neighbor));
+    ++mem_list->merges;
+
+    if (mem_list->config->options & PB12_OPT_VERBOSE) {
+        printf("[%d-%d:%d].\n", mem_block->address,
+               mem_block->address + mem_block->length - 1, mem_block->length);
+    }
+}
+
+
 /**
     Initializes a memory list.
 
     @param PB12_MemBlock *mem_block - Memory block to initialize.
     @param int length - Size of the block of memory.
+    @param const PB12_Config *config - Settings of the VM.
+
+    @return int - PB12_SUCCESS or PB12_FAILURE
 */
-void pb12AllocInit(PB12_MemList *mem_list, int length) {
+int pb12AllocInit(PB12_MemList *mem_list, int length, const PB12_Config *config) {
     PB12_MemBlock* mem_block;
+    int fl;
+    int sl;
+
+    mem_list->size = length;
+    mem_list->starts = (PB12_MemBlock**) calloc(length + 1, sizeof(PB12_MemBlock*));
+    mem_list->ends = (PB12_MemBlock**) calloc(length + 1, sizeof(PB12_MemBlock*));
+    if (!mem_list->starts || !mem_list->ends ||
+        pb12InitPool(&mem_list->pool, length + 1) == PB12_FAILURE) {
+        free(mem_list->starts);
+        free(mem_list->ends);
+        return PB12_FAILURE;
+    }
+    mem_block = pb12PoolGet(&mem_list->pool);
+
+    mem_list->head = NULL;
+    mem_list->free_words = 0;
+    mem_list->root = NULL;
+    mem_list->rover = NULL;
+    mem_list->searched = 0;
+    mem_list->visited = 0;
+    mem_list->merges = 0;
+    mem_list->pushes = 0;
+    for (fl=0; fl<PB12_ALLOC_FL; fl++) {
+        for (sl=0; sl<PB12_ALLOC_SL; sl++)
+            mem_list->bin[fl][sl] = NULL;
+        mem_list->sl_map[fl] = 0;
+    }
+    mem_list->fl_map = 0;
+    mem_list->config = config;
+
+    /* Only best fit and worst fit use the size tree. */
+    mem_list->tree = (config->options & PB12_OPT_WORST_FIT) ||
+                     !(config->options & (PB12_OPT_FIRST_FIT | PB12_OPT_NEXT_FIT |
+                                          PB12_OPT_SEGREGATED_FIT | PB12_OPT_BUDDY |
+                                          PB12_OPT_TLSF));
 
-    mem_block = (PB12_MemBlock*) malloc(sizeof(PB12_MemBlock));
-    mem_block->next = NULL;
     mem_block->address = 0;
     mem_block->length = length;
-    mem_list->head = mem_block;
+    pb12AllocPush(mem_list, mem_block);
+    return PB12_SUCCESS;
+}
+
+
+/**
+    Frees a memory list and all of its blocks, free or not.
+
+    @param PB12_MemList *mem_list - List of memory blocks
+*/
+void pb12AllocDestroy(PB12_MemList *mem_list) {
+    pb12DestroyPool(&mem_list->pool);
+    mem_list->head = NULL;
+    mem_list->root = NULL;
+    mem_list->rover = NULL;
+
+    free(mem_list->starts);
+    mem_list->starts = NULL;
+    free(mem_list->ends);
+    mem_list->ends = NULL;
 }
 
 
@@ -40,6 +654,29 @@ void pb12AllocPrint(PB12_MemList *mem_list) {
 }
 
 
+/**
+    Counts the free blocks of a memory list.
+
+    @param const PB12_MemList *mem_list - List of memory blocks
+    @param int *holes - Set to the number of free blocks.
+    @param int *largest - Set to the words in the largest of them.
+
+    @return int - Words free.
+*/
+int pb12AllocCensus(const PB12_MemList *mem_list, int *holes, int *largest) {
+    const PB12_MemBlock *current;
+
+    *holes = 0;
+    *largest = 0;
+    for (current = mem_list->head; current != NULL; current = current->next) {
+        ++*holes;
+        if (current->length > *largest)
+            *largest = current->length;
+    }
+    return mem_list->free_words;
+}
+
+
 /**
     Pushes a memory block onto the beginning of the list.
 
@@ -48,7 +685,17 @@ void pb12AllocPrint(PB12_MemList *mem_list) {
 */
 void pb12AllocPush(PB12_MemList *mem_list, PB12_MemBlock *mem_block) {
     mem_block->next = mem_list->head;
+    mem_block->prev = NULL;
+    if (mem_list->head != NULL)
+        mem_list->head->prev = mem_block;
     mem_list->head = mem_block;
+    mem_list->free_words += mem_block->length;
+    pb12AllocBin(mem_list, mem_block);
+    pb12AllocTag(mem_list, mem_block);
+
+    mem_block->seq = mem_list->pushes++;
+    if (mem_list->tree)
+        mem_list->root = pb12AllocTreeInsert(mem_list->root, mem_block);
 }
 
 
@@ -71,6 +718,15 @@ PB12_MemBlock* pb12AllocRemove(PB12_MemList *mem_list, PB12_MemBlock *prev, PB12
     else {
         prev->next = current->next;
     }
+    if (current->next != NULL)
+        current->next->prev = prev;
+    if (mem_list->rover == current)
+        mem_list->rover = current->next;
+    mem_list->free_words -= current->length;
+    pb12AllocUnbin(mem_list, current);
+    pb12AllocUntag(mem_list, current);
+    if (mem_list->tree)
+        mem_list->root = pb12AllocTreeDelete(mem_list->root, current);
 
     return tmp;
 }
@@ -91,28 +747,31 @@ void pb12AllocSplit(PB12_MemList *mem_list, PB12_MemBlock* mem_block, int length
 
     difference = mem_block->length - length;
 
-    if (difference == 0)
+    /* Without a block for the remainder, it all goes to the process. */
+    new_block = NULL;
+    if (difference != 0)
+        new_block = pb12PoolGet(&mem_list->pool);
+    if (new_block == NULL)
         return;
 
-    if (pb12Options & PB12_OPT_VERBOSE) {
+    if (mem_list->config->options & PB12_OPT_VERBOSE) {
         printf("Splitting memory [%d-%d:%d] into ",
                mem_block->address, mem_block->address + mem_block->length - 1, mem_block->length);
     }
 
     mem_block->length = length;
 
-    new_block = (PB12_MemBlock*) malloc(sizeof(PB12_MemBlock));
     new_block->address = mem_block->address + length;
     new_block->length = difference;
     pb12AllocPush(mem_list, new_block);
 
-    if (pb12Options & PB12_OPT_VERBOSE) {
+    if (mem_list->config->options & PB12_OPT_VERBOSE) {
         printf("[%d-%d:%d] and [%d-%d:%d].\n",
                mem_block->address, mem_block->address + mem_block->length - 1, mem_block->length,
                new_block->address, new_block->address + new_block->length - 1, new_block->length);
     }
 
-    if (pb12Options & PB12_OPT_VERBOSE) {
+    if (mem_list->config->options & PB12_OPT_VERBOSE) {
         printf("Memory allocated.  Memory list now:\n");
         pb12AllocPrint(mem_list);
     }
@@ -122,80 +781,146 @@ void pb12AllocSplit(PB12_MemList *mem_list, PB12_MemBlock* mem_block, int length
 /**
     Merges this block with neighboring blocks in the list.
 
+    The free blocks just before and after it are found by their tags.  They
+    are joined onto it in the order they are in the list, then it is pushed
+    onto the beginning of the list.
+
     @param PB12_MemList *mem_list - List of memory blocks
     @param PB12_MemBlock *mem_block - Memory block
 */
 void pb12AllocMerge(PB12_MemList *mem_list, PB12_MemBlock *mem_block) {
-    PB12_MemBlock *prev;
-    PB12_MemBlock *current;
-    PB12_MemBlock *tmp;
+    PB12_MemBlock *before;
+    PB12_MemBlock *after;
     int end_addr;
+    int rover;
 
     if (mem_list->head == NULL) {
-        mem_list->head = mem_block;
+        pb12AllocPush(mem_list, mem_block);
         return;
     }
 
     end_addr = mem_block->address + mem_block->length;
 
-    prev = NULL;
-    current = mem_list->head;
-    while (current != NULL) {
-        /* TODO: Make sure merging first block doesn't cause any problems */
-
-        if (current->address == end_addr) {
-            /* Merge mem_block with one after it */
-            if (pb12Options & PB12_OPT_VERBOSE) {
-                printf("Merging memory [%d-%d:%d] with [%d-%d:%d] making ",
-                       mem_block->address, mem_block->address + mem_block->length - 1, mem_block->length,
-                       current->address, current->address + current->length - 1, current->length);
-            }
-
-            mem_block->length += current->length;
-            tmp = pb12AllocRemove(mem_list, prev, current);
-            current = current->next;
-            free(tmp);
-
-            if (pb12Options & PB12_OPT_VERBOSE) {
-                printf("[%d-%d:%d].\n", mem_block->address,
-                       mem_block->address + mem_block->length - 1, mem_block->length);
-            }
-        }
-        else if (current->address + current->length == mem_block->address) {
-            /* Merge mem_block with one before it */
-            if (pb12Options & PB12_OPT_VERBOSE) {
-                printf("Merging memory [%d-%d:%d] with [%d-%d:%d] making ",
-                       mem_block->address, mem_block->address + mem_block->length - 1, mem_block->length,
-                       current->address, current->address + current->length - 1, current->length);
-            }
-
-            mem_block->address = current->address;
-            mem_block->length += current->length;
-            tmp = pb12AllocRemove(mem_list, prev, current);
-            current = current->next;
-            free(tmp);
-
-            if (pb12Options & PB12_OPT_VERBOSE) {
-                printf("[%d-%d:%d].\n", mem_block->address,
-                       mem_block->address + mem_block->length - 1, mem_block->length);
-            }
-        }
-        else {
-            prev = current;
-            current = current->next;
-        }
+    before = NULL;
+    after = NULL;
+    if (mem_block->address >= 0 && mem_block->address <= mem_list->size)
+        before = mem_list->ends[mem_block->address];
+    if (end_addr >= 0 && end_addr <= mem_list->size)
+        after = mem_list->starts[end_addr];
+
+    /* Next fit carries on from the merged block if it was on a neighbor. */
+    rover = mem_list->rover != NULL &&
+            (mem_list->rover == before || mem_list->rover == after);
+
+    /* The block pushed last is nearer the head of the list. */
+    if (before != NULL && after != NULL && before->seq > after->seq) {
+        pb12AllocJoin(mem_list, mem_block, before);
+        before = NULL;
     }
+    if (after != NULL)
+        pb12AllocJoin(mem_list, mem_block, after);
+    if (before != NULL)
+        pb12AllocJoin(mem_list, mem_block, before);
 
-    mem_block->next = mem_list->head;
-    mem_list->head = mem_block;
+    pb12AllocPush(mem_list, mem_block);
+    if (rover)
+        mem_list->rover = mem_block;
 
-    if (pb12Options & PB12_OPT_VERBOSE) {
+    if (mem_list->config->options & PB12_OPT_VERBOSE) {
         printf("Memory deallocated.  Memory list now:\n");
         pb12AllocPrint(mem_list);
     }
 }
 
 
+/**
+    Grows or shrinks an allocated block where it is.  Shrinking frees the
+    words at its end, merged with the free block after them.  Growing takes
+    words from the start of the free block just after it, found by its tag,
+    so it only works if that block has enough.
+
+    @param PB12_MemList *mem_list - List of memory blocks
+    @param PB12_MemBlock *mem_block - Allocated memory block
+    @param int length - Words it should have.
+
+    @return int - PB12_SUCCESS, or PB12_FAILURE if it is left as it was
+*/
+int pb12AllocResize(PB12_MemList *mem_list, PB12_MemBlock *mem_block, int length) {
+    PB12_MemBlock *after;
+    PB12_MemBlock *tail;
+    int end_addr;
+    int extra;
+
+    if (length <= 0)
+        return PB12_FAILURE;
+    if (length == mem_block->length)
+        return PB12_SUCCESS;
+
+    if (length < mem_block->length) {
+        tail = pb12PoolGet(&mem_list->pool);
+        if (tail == NULL)
+            return PB12_FAILURE;
+        tail->address = mem_block->address + length;
+        tail->length = mem_block->length - length;
+        mem_block->length = length;
+        pb12AllocMerge(mem_list, tail);
+        return PB12_SUCCESS;
+    }
+
+    extra = length - mem_block->length;
+    end_addr = mem_block->address + mem_block->length;
+    after = NULL;
+    if (end_addr >= 0 && end_addr <= mem_list->size)
+        after = mem_list->starts[end_addr];
+    if (after == NULL || after->length < extra)
+        return PB12_FAILURE;
+
+    /* What is left of the free block goes back as a block of its own. */
+    pb12AllocRemove(mem_list, after->prev, after);
+    mem_block->length = length;
+    if (after->length > extra) {
+        after->address += extra;
+        after->length -= extra;
+        pb12AllocPush(mem_list, after);
+    }
+    else {
+        pb12PoolPut(&mem_list->pool, after);
+    }
+
+    if (mem_list->config->options & PB12_OPT_VERBOSE) {
+        printf("Memory grown to [%d-%d:%d].  Memory list now:\n",
+               mem_block->address, mem_block->address + mem_block->length - 1,
+               mem_block->length);
+        pb12AllocPrint(mem_list);
+    }
+    return PB12_SUCCESS;
+}
+
+
+/**
+    Replaces every free block with one running from an address to the end
+    of memory, once compaction has moved all allocated blocks below it.
+
+    @param PB12_MemList *mem_list - List of memory blocks
+    @param int address - First word that is free.
+*/
+void pb12AllocCompacted(PB12_MemList *mem_list, int address) {
+    PB12_MemBlock *mem_block;
+
+    while (mem_list->head != NULL)
+        pb12PoolPut(&mem_list->pool, pb12AllocRemove(mem_list, NULL, mem_list->head));
+
+    if (address < mem_list->size) {
+        mem_block = pb12PoolGet(&mem_list->pool);
+        if (mem_block != NULL) {
+            mem_block->address = address;
+            mem_block->length = mem_list->size - address;
+            pb12AllocPush(mem_list, mem_block);
+        }
+    }
+}
+
+
 /**
     First fit allocation scheme.
 
@@ -213,6 +938,8 @@ PB12_MemBlock* pb12AllocFirstFit(PB12_MemList *mem_list, int length) {
     prev = NULL;
     current = mem_list->head;
     while (current != NULL) {
+        ++mem_list->searched;
+        ++mem_list->visited;
         if (current->length >= length) {
             mem_block = pb12AllocRemove(mem_list, prev, current);
             pb12AllocSplit(mem_list, mem_block, length);
@@ -227,15 +954,141 @@ PB12_MemBlock* pb12AllocFirstFit(PB12_MemList *mem_list, int length) {
 }
 
 
+/**
+    Next fit allocation scheme.
+
+    The search starts at the rover, where the last one ended, and wraps
+    around to the head of the list until it is back where it started.  When
+    the block found is split, the rover is left on what is left of it, so
+    the next search starts there.  Removing the block the rover is on moves
+    the rover to the one after it, and merging it into a freed block moves
+    it to the merged block.
+
+    @param PB12_MemList *mem_list - List of memory blocks
+    @param int length - Required size of memory
+
+    @return PB12_MemBlock* - Block of memory meeting requirements, else NULL
+*/
+PB12_MemBlock* pb12AllocNextFit(PB12_MemList *mem_list, int length) {
+    PB12_MemBlock* mem_block;
+    PB12_MemBlock* start;
+    PB12_MemBlock* current;
+    int split;
+
+    start = mem_list->rover;
+    if (start == NULL)
+        start = mem_list->head;
+
+    mem_block = NULL;
+    current = start;
+    while (current != NULL) {
+        ++mem_list->searched;
+        ++mem_list->visited;
+        if (current->length >= length) {
+            mem_block = current;
+            break;
+        }
+
+        current = current->next;
+        if (current == NULL)
+            current = mem_list->head;
+        if (current == start)
+            break;
+    }
+
+    if (mem_block != NULL) {
+        split = mem_block->length > length;
+        mem_block = pb12AllocRemove(mem_list, mem_block->prev, mem_block);
+        pb12AllocSplit(mem_list, mem_block, length);
+        if (split)
+            mem_list->rover = mem_list->head;
+        mem_block->next = NULL;
+    }
+
+    return mem_block;
+}
+
+
 /**
     Best fit allocation scheme.
 
+    The smallest block that is big enough is the first one in the size
+    tree at least length long.  Of blocks as long as each other, the tree
+    puts the one nearest the head of the list first, as a walk of the list
+    would find it.
+
     @param PB12_MemList *mem_list - List of memory blocks
     @param int length - Required size of memory
 
     @return PB12_MemBlock* - Block of memory meeting requirements, else NULL
 */
 PB12_MemBlock* pb12AllocBestFit(PB12_MemList *mem_list, int length) {
+    PB12_MemBlock* mem_block;
+
+    if (!mem_list->tree)
+        return pb12AllocBestFitList(mem_list, length);
+
+    mem_block = pb12AllocTreeFind(mem_list, length);
+
+    if (mem_block != NULL) {
+        mem_block = pb12AllocRemove(mem_list, mem_block->prev, mem_block);
+        pb12AllocSplit(mem_list, mem_block, length);
+        mem_block->next = NULL;
+    }
+
+    return mem_block;
+}
+
+
+/**
+    Worst fit allocation scheme.
+
+    The largest block is the last one in the size tree, and the first of
+    that length is the one nearest the head of the list.  As always, it is
+    only taken if it is bigger than length.
+
+    @param PB12_MemList *mem_list - List of memory blocks
+    @param int length - Required size of memory
+
+    @return PB12_MemBlock* - Block of memory meeting requirements, else NULL
+*/
+PB12_MemBlock* pb12AllocWorstFit(PB12_MemList *mem_list, int length) {
+    PB12_MemBlock* mem_block;
+
+    if (!mem_list->tree)
+        return pb12AllocWorstFitList(mem_list, length);
+
+    mem_block = mem_list->root;
+    while (mem_block != NULL && mem_block->right != NULL) {
+        ++mem_list->visited;
+        mem_block = mem_block->right;
+    }
+
+    if (mem_block != NULL && mem_block->length > length)
+        mem_block = pb12AllocTreeFind(mem_list, mem_block->length);
+    else
+        mem_block = NULL;
+
+    if (mem_block != NULL) {
+        mem_block = pb12AllocRemove(mem_list, mem_block->prev, mem_block);
+        pb12AllocSplit(mem_list, mem_block, length);
+        mem_block->next = NULL;
+    }
+
+    return mem_block;
+}
+
+
+/**
+    Best fit allocation scheme that walks the whole list.  Picks the same
+    block as pb12AllocBestFit(), which is timed against it.
+
+    @param PB12_MemList *mem_list - List of memory blocks
+    @param int length - Required size of memory
+
+    @return PB12_MemBlock* - Block of memory meeting requirements, else NULL
+*/
+PB12_MemBlock* pb12AllocBestFitList(PB12_MemList *mem_list, int length) {
     PB12_MemBlock* mem_prev;
     PB12_MemBlock* mem_block;
     PB12_MemBlock* prev;
@@ -249,6 +1102,7 @@ PB12_MemBlock* pb12AllocBestFit(PB12_MemList *mem_list, int length) {
     prev = NULL;
     current = mem_list->head;
     while (current != NULL) {
+        ++mem_list->visited;
         difference = current->length - length;
 
         if (difference >= 0 && difference < best) {
@@ -270,15 +1124,17 @@ PB12_MemBlock* pb12AllocBestFit(PB12_MemList *mem_list, int length) {
     return mem_block;
 }
 
+
 /**
-    Worst fit allocation scheme.
+    Worst fit allocation scheme that walks the whole list.  Picks the same
+    block as pb12AllocWorstFit(), which is timed against it.
 
     @param PB12_MemList *mem_list - List of memory blocks
     @param int length - Required size of memory
 
     @return PB12_MemBlock* - Block of memory meeting requirements, else NULL
 */
-PB12_MemBlock* pb12AllocWorstFit(PB12_MemList *mem_list, int length) {
+PB12_MemBlock* pb12AllocWorstFitList(PB12_MemList *mem_list, int length) {
     PB12_MemBlock* mem_prev;
     PB12_MemBlock* mem_block;
     PB12_MemBlock* prev;
@@ -292,6 +1148,7 @@ PB12_MemBlock* pb12AllocWorstFit(PB12_MemList *mem_list, int length) {
     prev = NULL;
     current = mem_list->head;
     while (current != NULL) {
+        ++mem_list->visited;
         difference = current->length - length;
 
         if (difference >= 0 && difference > worst) {
@@ -312,3 +1169,79 @@ PB12_MemBlock* pb12AllocWorstFit(PB12_MemList *mem_list, int length) {
 
     return mem_block;
 }
+
+
+/**
+    Segregated fit allocation scheme.
+
+    Every block in a bin at or after the first size class whose blocks are
+    all long enough fits, and the first such bin that is not empty is found
+    with two bit scans.  Only if all of them are empty is the bin that length
+    falls in searched for a block that fits.
+
+    @param PB12_MemList *mem_list - List of memory blocks
+    @param int length - Required size of memory
+
+    @return PB12_MemBlock* - Block of memory meeting requirements, else NULL
+*/
+PB12_MemBlock* pb12AllocSegregatedFit(PB12_MemList *mem_list, int length) {
+    PB12_MemBlock* mem_block;
+    int fl;
+    int sl;
+
+    mem_block = NULL;
+    if (pb12AllocFitClass(length, &fl, &sl))
+        mem_block = pb12AllocFindBin(mem_list, fl, sl);
+
+    if (mem_block == NULL) {
+        pb12AllocClass(length, &fl, &sl);
+        mem_block = mem_list->bin[fl][sl];
+        while (mem_block != NULL && mem_block->length < length) {
+            ++mem_list->visited;
+            mem_block = mem_block->bin_next;
+        }
+    }
+
+    if (mem_block != NULL) {
+        ++mem_list->visited;
+        mem_block = pb12AllocRemove(mem_list, mem_block->prev, mem_block);
+        pb12AllocSplit(mem_list, mem_block, length);
+        mem_block->next = NULL;
+    }
+
+    return mem_block;
+}
+
+
+/**
+    Two-level segregated fit (TLSF) allocation scheme.
+
+    Takes the first block of the first bin, at or after the first size
+    class whose blocks are all long enough, that is not empty.  Nothing is
+    ever searched, so allocating takes constant time, as freeing does with
+    the size tree left out.  A block in the class length falls in that
+    would have fit is not looked at.
+
+    @param PB12_MemList *mem_list - List of memory blocks
+    @param int length - Required size of memory
+
+    @return PB12_MemBlock* - Block of memory meeting requirements, else NULL
+*/
+PB12_MemBlock* pb12AllocTlsf(PB12_MemList *mem_list, int length) {
+    PB12_MemBlock* mem_block;
+    int fl;
+    int sl;
+
+    mem_block = NULL;
+    if (pb12AllocFitClass(length, &fl, &sl))
+        mem_block = pb12AllocFindBin(mem_list, fl, sl);
+
+    if (mem_block != NULL) {
+        ++mem_list->visited;
+        mem_block = pb12AllocRemove(mem_list, mem_block->prev, mem_block);
+        pb12AllocSplit(mem_list, mem_block, length);
+        mem_block->next = NULL;
+    }
+
+    return mem_block;
+}
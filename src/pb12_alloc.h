@@ -1,25 +1,147 @@
 #ifndef PB12_ALLOC_H
 #define PB12_ALLOC_H
 
+struct S_PB12_Config;
+
+#define PB12_ALLOC_SL_BITS  4       /* log2 of PB12_ALLOC_SL */
+#define PB12_ALLOC_SL       16      /* Size classes per power of two */
+#define PB12_ALLOC_FL       28      /* Powers of two, up to 2^30 words */
+#define PB12_POOL_SLAB      4096    /* Most memory blocks in one slab */
+
 typedef struct S_PB12_MemBlock {
     struct S_PB12_MemBlock *next;
+    struct S_PB12_MemBlock *prev;       /* Previous block in the list */
+    struct S_PB12_MemBlock *bin_next;   /* Next block of the same size class */
+    struct S_PB12_MemBlock *bin_prev;   /* Previous block of the same size class */
+    struct S_PB12_MemBlock *left;       /* Smaller blocks in the size tree */
+    struct S_PB12_MemBlock *right;      /* Larger blocks in the size tree */
+    int height;                         /* Height of the subtree it roots */
+    unsigned long seq;                  /* When it was pushed onto the list */
     int address;
     int length;
 } PB12_MemBlock;
 
 
+/*
+    Memory blocks for a memory list or buddy allocator, so that splitting
+    and merging do not go to malloc() and free().  Blocks are handed out
+    from slabs, kept on a list through the first block of each, and the
+    unused ones are kept on a free list through next.  A slab is sized
+    from the memory managed, since there can never be more blocks than
+    words, so the pool of the VM is one slab made when it starts.
+*/
+typedef struct S_PB12_MemPool {
+    PB12_MemBlock *free;                /* Blocks not in use */
+    PB12_MemBlock *slabs;               /* Slabs, each starting with a link to the next */
+    int slab_size;                      /* Blocks in each slab */
+    int slab_count;                     /* Slabs made so far */
+    int used;                           /* Blocks in use */
+    int high;                           /* Most blocks that have been in use at once */
+} PB12_MemPool;
+
+
+/*
+    Free memory.  Besides the list itself, every free block is kept in the
+    bin of its size class, two levels deep as in TLSF.  Blocks shorter than
+    PB12_ALLOC_SL words have a bin of their own length in row 0.  Longer
+    ones go in row fl = k - PB12_ALLOC_SL_BITS + 1 for the power of two
+    2^k they are at least, and that range is split into PB12_ALLOC_SL bins
+    of equal width.  Bit fl of fl_map is set when row fl has a bin that is
+    not empty, and bit sl of sl_map[fl] when bin sl of it is not empty.
+
+    While best or worst fit may be used (tree is set), they are also kept
+    in an AVL tree ordered by length.  Blocks of the same length are
+    ordered the way they are in the list, most recently pushed first, so
+    the tree finds the same block a walk of the list would.
+
+    Every free block is tagged at both of its ends in starts and ends, so
+    the free neighbours of a block are found without walking the list.
+*/
 typedef struct S_PB12_MemList {
     PB12_MemBlock *head;
+    int size;                               /* Words of memory managed */
+    int free_words;                         /* Words in the free blocks */
+    PB12_MemBlock **starts;                 /* Free block starting at each address */
+    PB12_MemBlock **ends;                   /* Free block ending before each address */
+    PB12_MemBlock *root;                    /* Size tree of the free blocks */
+    int tree;                               /* Nonzero if the size tree is kept */
+    PB12_MemBlock *rover;                   /* Where next fit starts, or NULL */
+    unsigned long searched;                 /* Blocks first and next fit looked at */
+    unsigned long visited;                  /* Blocks any fit looked at, in the list, tree or bins */
+    unsigned long merges;                   /* Free neighbors joined onto freed blocks */
+    unsigned long pushes;                   /* Blocks pushed so far */
+    PB12_MemBlock *bin[PB12_ALLOC_FL][PB12_ALLOC_SL];  /* Free blocks of each size class */
+    unsigned long fl_map;                   /* Rows with bins that are not empty */
+    unsigned long sl_map[PB12_ALLOC_FL];    /* Bins of each row that are not empty */
+    PB12_MemPool pool;                      /* Where the blocks come from */
+    const struct S_PB12_Config *config;     /* Settings of the VM */
 } PB12_MemList;
 
 
+/**
+    Initializes a pool of memory blocks, making its first slab.
+
+    @param PB12_MemPool *pool - Pool to initialize.
+    @param int blocks - Most blocks that will be in use at once.
+
+    @return int - PB12_SUCCESS or PB12_FAILURE
+*/
+int pb12InitPool(PB12_MemPool *pool, int blocks);
+
+
+/**
+    Frees a pool and every block that came from it.
+
+    @param PB12_MemPool *pool - Pool of memory blocks.
+*/
+void pb12DestroyPool(PB12_MemPool *pool);
+
+
+/**
+    Takes a memory block from a pool, making a new slab if it has run out.
+
+    @param PB12_MemPool *pool - Pool of memory blocks.
+
+    @return PB12_MemBlock* - Memory block, or NULL if out of memory
+*/
+PB12_MemBlock* pb12PoolGet(PB12_MemPool *pool);
+
+
+/**
+    Gives a memory block back to the pool it came from.
+
+    @param PB12_MemPool *pool - Pool of memory blocks.
+    @param PB12_MemBlock *mem_block - Memory block from pb12PoolGet().
+*/
+void pb12PoolPut(PB12_MemPool *pool, PB12_MemBlock *mem_block);
+
+
+/**
+    Prints the high-water mark of a pool.
+
+    @param const PB12_MemPool *pool - Pool of memory blocks.
+*/
+void pb12PoolPrint(const PB12_MemPool *pool);
+
+
 /**
     Initializes a memory list.
 
     @param PB12_MemBlock *mem_block - Memory block to initialize.
     @param int length - Size of the block of memory.
+    @param const struct S_PB12_Config *config - Settings of the VM.
+
+    @return int - PB12_SUCCESS or PB12_FAILURE
 */
-void pb12AllocInit(PB12_MemList *mem_list, int length);
+int pb12AllocInit(PB12_MemList *mem_list, int length, const struct S_PB12_Config *config);
+
+
+/**
+    Frees a memory list and all of its blocks, free or not.
+
+    @param PB12_MemList *mem_list - List of memory blocks
+*/
+void pb12AllocDestroy(PB12_MemList *mem_list);
 
 
 /**
@@ -30,6 +152,18 @@ void pb12AllocInit(PB12_MemList *mem_list, int length);
 void pb12AllocPrint(PB12_MemList *mem_list);
 
 
+/**
+    Counts the free blocks of a memory list.
+
+    @param const PB12_MemList *mem_list - List of memory blocks
+    @param int *holes - Set to the number of free blocks.
+    @param int *largest - Set to the words in the largest of them.
+
+    @return int - Words free.
+*/
+int pb12AllocCensus(const PB12_MemList *mem_list, int *holes, int *largest);
+
+
 /**
     Pushes a memory block onto the beginning of the list.
 
@@ -61,7 +195,8 @@ void pb12AllocSplit(PB12_MemList *mem_list, PB12_MemBlock* mem_block, int length
 
 
 /**
-    Merges this block with neighboring blocks in the list.
+    Merges this block with neighboring blocks in the list.  The neighbors
+    are found by their tags, in constant time.
 
     @param PB12_MemList *mem_list - List of memory blocks
     @param PB12_MemBlock *mem_block - Memory block
@@ -69,6 +204,31 @@ void pb12AllocSplit(PB12_MemList *mem_list, PB12_MemBlock* mem_block, int length
 void pb12AllocMerge(PB12_MemList *mem_list, PB12_MemBlock *mem_block);
 
 
+/**
+    Grows or shrinks an allocated block where it is.  Shrinking frees the
+    words at its end, merged with the free block after them.  Growing takes
+    words from the start of the free block just after it, found by its tag,
+    so it only works if that block has enough.
+
+    @param PB12_MemList *mem_list - List of memory blocks
+    @param PB12_MemBlock *mem_block - Allocated memory block
+    @param int length - Words it should have.
+
+    @return int - PB12_SUCCESS, or PB12_FAILURE if it is left as it was
+*/
+int pb12AllocResize(PB12_MemList *mem_list, PB12_MemBlock *mem_block, int length);
+
+
+/**
+    Replaces every free block with one running from an address to the end
+    of memory, once compaction has moved all allocated blocks below it.
+
+    @param PB12_MemList *mem_list - List of memory blocks
+    @param int address - First word that is free.
+*/
+void pb12AllocCompacted(PB12_MemList *mem_list, int address);
+
+
 /**
     First fit allocation scheme.
 
@@ -81,7 +241,20 @@ PB12_MemBlock* pb12AllocFirstFit(PB12_MemList *mem_list, int length);
 
 
 /**
-    Best fit allocation scheme.
+    Next fit allocation scheme.  Like first fit, but the search starts where
+    the last one ended and wraps around to the head of the list.
+
+    @param PB12_MemList *mem_list - List of memory blocks
+    @param int length - Required size of memory
+
+    @return PB12_MemBlock* - Block of memory meeting requirements, else NULL
+*/
+PB12_MemBlock* pb12AllocNextFit(PB12_MemList *mem_list, int length);
+
+
+/**
+    Best fit allocation scheme.  The smallest block that is big enough is
+    found in the size tree.
 
     @param PB12_MemList *mem_list - List of memory blocks
     @param int length - Required size of memory
@@ -92,7 +265,8 @@ PB12_MemBlock* pb12AllocBestFit(PB12_MemList *mem_list, int length);
 
 
 /**
-    Worst fit allocation scheme.
+    Worst fit allocation scheme.  The largest block is found in the size
+    tree, and taken if it is bigger than length.
 
     @param PB12_MemList *mem_list - List of memory blocks
     @param int length - Required size of memory
@@ -101,4 +275,56 @@ PB12_MemBlock* pb12AllocBestFit(PB12_MemList *mem_list, int length);
 */
 PB12_MemBlock* pb12AllocWorstFit(PB12_MemList *mem_list, int length);
 
+
+/**
+    Best fit allocation scheme that walks the whole list.  Picks the same
+    block as pb12AllocBestFit(), which is timed against it.
+
+    @param PB12_MemList *mem_list - List of memory blocks
+    @param int length - Required size of memory
+
+    @return PB12_MemBlock* - Block of memory meeting requirements, else NULL
+*/
+PB12_MemBlock* pb12AllocBestFitList(PB12_MemList *mem_list, int length);
+
+
+/**
+    Worst fit allocation scheme that walks the whole list.  Picks the same
+    block as pb12AllocWorstFit(), which is timed against it.
+
+    @param PB12_MemList *mem_list - List of memory blocks
+    @param int length - Required size of memory
+
+    @return PB12_MemBlock* - Block of memory meeting requirements, else NULL
+*/
+PB12_MemBlock* pb12AllocWorstFitList(PB12_MemList *mem_list, int length);
+
+
+/**
+    Segregated fit allocation scheme.  Takes a block from the smallest size
+    class whose blocks are all big enough, found with bit scans instead of
+    a walk of the list.  Only when every such class is empty is the class
+    the length itself falls in searched, so that memory is found whenever
+    any free block is big enough.
+
+    @param PB12_MemList *mem_list - List of memory blocks
+    @param int length - Required size of memory
+
+    @return PB12_MemBlock* - Block of memory meeting requirements, else NULL
+*/
+PB12_MemBlock* pb12AllocSegregatedFit(PB12_MemList *mem_list, int length);
+
+
+/**
+    Two-level segregated fit (TLSF) allocation scheme.  Like segregated
+    fit, but the class length falls in is never searched, so allocating
+    and freeing take constant time.
+
+    @param PB12_MemList *mem_list - List of memory blocks
+    @param int length - Required size of memory
+
+    @return PB12_MemBlock* - Block of memory meeting requirements, else NULL
+*/
+PB12_MemBlock* pb12AllocTlsf(PB12_MemList *mem_list, int length);
+
 #endif /* PB12_ALLOC_H */
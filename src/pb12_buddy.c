@@ -0,0 +1,325 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "pb12.h"
+#include "pb12_buddy.h"
+
+/**
+    Get the order of the block that holds length words.
+
+    @param int length - Required size of memory.
+
+    @return int - Smallest k with 2^k at least length.
+*/
+static int pb12BuddyOrder(int length) {
+    int k;
+
+    for (k=0; k < PB12_BUDDY_ORDERS - 1 && (1 << k) < length; k++)
+        ;
+    return k;
+}
+
+
+/**
+    Put a free block on the list of its order.
+
+    @param PB12_Buddy *buddy - Buddy allocator.
+    @param int address - Address of the block.
+    @param int k - Order of the block.
+*/
+static void pb12BuddyPush(PB12_Buddy *buddy, int address, int k) {
+    buddy->order[address] = (signed char)k;
+    buddy->prev[address] = -1;
+    buddy->next[address] = buddy->head[k];
+    if (buddy->head[k] != -1)
+        buddy->prev[buddy->head[k]] = address;
+    buddy->head[k] = address;
+}
+
+
+/**
+    Take a free block off the list of its order.
+
+    @param PB12_Buddy *buddy - Buddy allocator.
+    @param int address - Address of the block.
+*/
+static void pb12BuddyUnlink(PB12_Buddy *buddy, int address) {
+    int k;
+
+    k = buddy->order[address];
+    if (buddy->prev[address] == -1)
+        buddy->head[k] = buddy->next[address];
+    else
+        buddy->next[buddy->prev[address]] = buddy->next[address];
+    if (buddy->next[address] != -1)
+        buddy->prev[buddy->next[address]] = buddy->prev[address];
+    buddy->order[address] = -1;
+}
+
+
+/**
+    Initialize a buddy allocator with all of memory free.
+
+    @param PB12_Buddy *buddy - Buddy allocator.
+    @param int size - Words of memory.
+    @param const PB12_Config *config - Settings of the VM.
+
+    @return int - PB12_SUCCESS or PB12_FAILURE
+*/
+int pb12InitBuddy(PB12_Buddy *buddy, int size, const PB12_Config *config) {
+    int address;
+    int k;
+
+    buddy->size = size;
+    buddy->config = config;
+    buddy->visited = 0;
+    buddy->merges = 0;
+    buddy->next = (int*) malloc(size * sizeof(int));
+    buddy->prev = (int*) malloc(size * sizeof(int));
+    buddy->order = (signed char*) malloc(size);
+    buddy->pool.slabs = NULL;
+    if (!buddy->next || !buddy->prev || !buddy->order ||
+        pb12InitPool(&buddy->pool, size) == PB12_FAILURE) {
+        pb12DestroyBuddy(buddy);
+        return PB12_FAILURE;
+    }
+
+    for (k=0; k<PB12_BUDDY_ORDERS; k++)
+        buddy->head[k] = -1;
+    for (address=0; address<size; address++)
+        buddy->order[address] = -1;
+
+    /* The largest aligned block that fits at each address, in turn. */
+    address = 0;
+    while (address < size) {
+        k = PB12_BUDDY_ORDERS - 1;
+        while (address % (1 << k) != 0 || (1 << k) > size - address)
+            --k;
+        pb12BuddyPush(buddy, address, k);
+        address += 1 << k;
+    }
+
+    return PB12_SUCCESS;
+}
+
+
+/**
+    Destroy a buddy allocator, and the blocks it has allocated.
+
+    @param PB12_Buddy *buddy - Buddy allocator.
+*/
+void pb12DestroyBuddy(PB12_Buddy *buddy) {
+    free(buddy->next);
+    buddy->next = NULL;
+    free(buddy->prev);
+    buddy->prev = NULL;
+    free(buddy->order);
+    buddy->order = NULL;
+    pb12DestroyPool(&buddy->pool);
+}
+
+
+/**
+    Get the size of the block the buddy allocator gives for a length.
+
+    @param int length - Required size of memory.
+
+    @return int - Words in the block, the power of two length rounds up to.
+*/
+int pb12BuddySize(int length) {
+    return 1 << pb12BuddyOrder(length);
+}
+
+
+/**
+    Prints the free blocks of each order.
+
+    @param PB12_Buddy *buddy - Buddy allocator.
+*/
+void pb12BuddyPrint(PB12_Buddy *buddy) {
+    int address;
+    int k;
+
+    for (k=0; k<PB12_BUDDY_ORDERS; k++) {
+        for (address = buddy->head[k]; address != -1; address = buddy->next[address]) {
+            printf("  [%d-%d:%d]\n", address, address + (1 << k) - 1, 1 << k);
+        }
+    }
+}
+
+
+/**
+    Counts the free blocks of a buddy allocator.
+
+    @param const PB12_Buddy *buddy - Buddy allocator.
+    @param int *holes - Set to the number of free blocks.
+    @param int *largest - Set to the words in the largest of them.
+
+    @return int - Words free.
+*/
+int pb12BuddyCensus(const PB12_Buddy *buddy, int *holes, int *largest) {
+    int free_words;
+    int address;
+    int k;
+
+    free_words = 0;
+    *holes = 0;
+    *largest = 0;
+    for (k=0; k<PB12_BUDDY_ORDERS; k++) {
+        for (address = buddy->head[k]; address != -1; address = buddy->next[address]) {
+            ++*holes;
+            free_words += 1 << k;
+            *largest = 1 << k;
+        }
+    }
+    return free_words;
+}
+
+
+/**
+    Allocate the smallest block that holds length words, splitting a larger
+    block in halves until it is that size.  The block returned is length
+    words long, the rest of it is internal fragmentation.
+
+    @param PB12_Buddy *buddy - Buddy allocator.
+    @param int length - Required size of memory.
+
+    @return PB12_MemBlock* - Block of memory meeting requirements, else NULL
+*/
+PB12_MemBlock* pb12BuddyAlloc(PB12_Buddy *buddy, int length) {
+    PB12_MemBlock *mem_block;
+    int address;
+    int want;
+    int k;
+
+    want = pb12BuddyOrder(length);
+    if ((1 << want) < length)
+        return NULL;
+
+    for (k = want; k < PB12_BUDDY_ORDERS; k++) {
+        ++buddy->visited;
+        if (buddy->head[k] != -1)
+            break;
+    }
+    if (k == PB12_BUDDY_ORDERS)
+        return NULL;
+
+    mem_block = pb12PoolGet(&buddy->pool);
+    if (mem_block == NULL)
+        return NULL;
+
+    address = buddy->head[k];
+    pb12BuddyUnlink(buddy, address);
+
+    /* Keep the lower half, and free the upper half, until it is small enough. */
+    while (k > want) {
+        --k;
+        if (buddy->config->options & PB12_OPT_VERBOSE) {
+            printf("Splitting memory [%d-%d:%d] into [%d-%d:%d] and [%d-%d:%d].\n",
+                   address, address + (2 << k) - 1, 2 << k,
+                   address, address + (1 << k) - 1, 1 << k,
+                   address + (1 << k), address + (2 << k) - 1, 1 << k);
+        }
+        pb12BuddyPush(buddy, address + (1 << k), k);
+    }
+
+    mem_block->next = NULL;
+    mem_block->address = address;
+    mem_block->length = length;
+
+    if (buddy->config->options & PB12_OPT_VERBOSE) {
+        printf("Memory allocated.  Memory list now:\n");
+        pb12BuddyPrint(buddy);
+    }
+
+    return mem_block;
+}
+
+
+/**
+    Free a block, merging it with its buddy for as long as the buddy is
+    free.  The memory block itself goes back to the pool.
+
+    @param PB12_Buddy *buddy - Buddy allocator.
+    @param PB12_MemBlock *mem_block - Block from pb12BuddyAlloc().
+*/
+void pb12BuddyFree(PB12_Buddy *buddy, PB12_MemBlock *mem_block) {
+    int address;
+    int other;
+    int k;
+
+    address = mem_block->address;
+    k = pb12BuddyOrder(mem_block->length);
+    pb12PoolPut(&buddy->pool, mem_block);
+
+    while (k < PB12_BUDDY_ORDERS - 1) {
+        other = address ^ (1 << k);
+        if (other > buddy->size - (1 << k) || buddy->order[other] != k)
+            break;
+
+        if (buddy->config->options & PB12_OPT_VERBOSE) {
+            printf("Merging memory [%d-%d:%d] with its buddy [%d-%d:%d].\n",
+                   address, address + (1 << k) - 1, 1 << k,
+                   other, other + (1 << k) - 1, 1 << k);
+        }
+
+        pb12BuddyUnlink(buddy, other);
+        ++buddy->merges;
+        if (other < address)
+            address = other;
+        ++k;
+    }
+    pb12BuddyPush(buddy, address, k);
+
+    if (buddy->config->options & PB12_OPT_VERBOSE) {
+        printf("Memory deallocated.  Memory list now:\n");
+        pb12BuddyPrint(buddy);
+    }
+}
+
+
+/**
+    Grow or shrink an allocated block where it is.  Shrinking to a smaller
+    order frees the upper halves it no longer needs.  Growing to a larger
+    order takes its buddies, so it only works while the block is the lower
+    half of each larger block and every one of those buddies is free.
+
+    @param PB12_Buddy *buddy - Buddy allocator.
+    @param PB12_MemBlock *mem_block - Block from pb12BuddyAlloc().
+    @param int length - Words it should have.
+
+    @return int - PB12_SUCCESS, or PB12_FAILURE if it is left as it was
+*/
+int pb12BuddyResize(PB12_Buddy *buddy, PB12_MemBlock *mem_block, int length) {
+    int address;
+    int have;
+    int want;
+    int k;
+
+    have = pb12BuddyOrder(mem_block->length);
+    want = pb12BuddyOrder(length);
+    if (length <= 0 || (1 << want) < length)
+        return PB12_FAILURE;
+
+    address = mem_block->address;
+    for (k = have; k < want; k++) {
+        if (address % (2 << k) != 0 || address + (1 << k) > buddy->size - (1 << k) ||
+            buddy->order[address + (1 << k)] != k)
+            return PB12_FAILURE;
+    }
+
+    for (k = have; k < want; k++) {
+        pb12BuddyUnlink(buddy, address + (1 << k));
+        ++buddy->merges;
+    }
+    for (k = have; k > want; k--)
+        pb12BuddyPush(buddy, address + (1 << (k - 1)), k - 1);
+    mem_block->length = length;
+
+    if (buddy->config->options & PB12_OPT_VERBOSE) {
+        printf("Memory resized to [%d-%d:%d].  Memory list now:\n",
+               address, address + length - 1, length);
+        pb12BuddyPrint(buddy);
+    }
+
+    return PB12_SUCCESS;
+}
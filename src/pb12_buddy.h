@@ -0,0 +1,121 @@
+#ifndef PB12_BUDDY_H
+#define PB12_BUDDY_H
+
+#include "pb12_alloc.h"
+
+struct S_PB12_Config;
+
+#define PB12_BUDDY_ORDERS   31      /* Block sizes, 2^0 to 2^30 words */
+
+/*
+    Binary buddy allocator.  Memory is handed out in aligned blocks of 2^k
+    words, k being the order of the block.  A block's buddy is the block of
+    the same order its address differs from in bit k only, and the two are
+    merged back into one block of order k + 1 whenever both are free.
+
+    Memory that is not a power of two long starts out as the aligned
+    blocks it is made of, largest first; their buddies lie past the end of
+    memory and are never free.  Free blocks are kept on one list per order,
+    linked through next and prev by address, so no block has to be
+    allocated to keep track of them.
+*/
+typedef struct S_PB12_Buddy {
+    int size;                           /* Words of memory managed */
+    int head[PB12_BUDDY_ORDERS];        /* First free block of each order, or -1 */
+    int *next;                          /* Next free block of the same order, or -1 */
+    int *prev;                          /* Previous free block of the same order, or -1 */
+    signed char *order;                 /* Order of the free block at each address, or -1 */
+    unsigned long visited;              /* Free lists allocation looked at */
+    unsigned long merges;               /* Blocks merged with their buddies */
+    PB12_MemPool pool;                  /* Where allocated blocks come from */
+    const struct S_PB12_Config *config; /* Settings of the VM */
+} PB12_Buddy;
+
+
+/**
+    Initialize a buddy allocator with all of memory free.
+
+    @param PB12_Buddy *buddy - Buddy allocator.
+    @param int size - Words of memory.
+    @param const struct S_PB12_Config *config - Settings of the VM.
+
+    @return int - PB12_SUCCESS or PB12_FAILURE
+*/
+int pb12InitBuddy(PB12_Buddy *buddy, int size, const struct S_PB12_Config *config);
+
+
+/**
+    Destroy a buddy allocator, and the blocks it has allocated.
+
+    @param PB12_Buddy *buddy - Buddy allocator.
+*/
+void pb12DestroyBuddy(PB12_Buddy *buddy);
+
+
+/**
+    Get the size of the block the buddy allocator gives for a length.
+
+    @param int length - Required size of memory.
+
+    @return int - Words in the block, the power of two length rounds up to.
+*/
+int pb12BuddySize(int length);
+
+
+/**
+    Prints the free blocks of each order.
+
+    @param PB12_Buddy *buddy - Buddy allocator.
+*/
+void pb12BuddyPrint(PB12_Buddy *buddy);
+
+
+/**
+    Counts the free blocks of a buddy allocator.
+
+    @param const PB12_Buddy *buddy - Buddy allocator.
+    @param int *holes - Set to the number of free blocks.
+    @param int *largest - Set to the words in the largest of them.
+
+    @return int - Words free.
+*/
+int pb12BuddyCensus(const PB12_Buddy *buddy, int *holes, int *largest);
+
+
+/**
+    Allocate the smallest block that holds length words, splitting a larger
+    block in halves until it is that size.  The block returned is length
+    words long, the rest of it is internal fragmentation.
+
+    @param PB12_Buddy *buddy - Buddy allocator.
+    @param int length - Required size of memory.
+
+    @return PB12_MemBlock* - Block of memory meeting requirements, else NULL
+*/
+PB12_MemBlock* pb12BuddyAlloc(PB12_Buddy *buddy, int length);
+
+
+/**
+    Free a block, merging it with its buddy for as long as the buddy is
+    free.  The memory block itself goes back to the pool.
+
+    @param PB12_Buddy *buddy - Buddy allocator.
+    @param PB12_MemBlock *mem_block - Block from pb12BuddyAlloc().
+*/
+void pb12BuddyFree(PB12_Buddy *buddy, PB12_MemBlock *mem_block);
+
+/**
+    Grow or shrink an allocated block where it is.  Shrinking to a smaller
+    order frees the upper halves it no longer needs.  Growing to a larger
+    order takes its buddies, so it only works while the block is the lower
+    half of each larger block and every one of those buddies is free.
+
+    @param PB12_Buddy *buddy - Buddy allocator.
+    @param PB12_MemBlock *mem_block - Block from pb12BuddyAlloc().
+    @param int length - Words it should have.
+
+    @return int - PB12_SUCCESS, or PB12_FAILURE if it is left as it was
+*/
+int pb12BuddyResize(PB12_Buddy *buddy, PB12_MemBlock *mem_block, int length);
+
+#endif /* PB12_BUDDY_H */
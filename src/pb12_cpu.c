@@ -4,6 +4,7 @@
 #include "pb12_cpu.h"
 #include "pb12_hw.h"
 #include "pb12_mem.h"
+#include "pb12_page.h"
 #include "pb12_inst.h"
 #include "pb12_strings.h"
 
@@ -119,7 +120,8 @@ void pb12SetPswCmp(PB12_CPU *cpu, int value) {
 
 /**
     Used with operands that get memory.  This ensures that the effective
-    address remains within bounds of base address and limit register.
+    address remains within bounds of base address and limit register, and
+    translates it through the page tables if memory is paged.
 
     @param PB12_CPU *cpu - CPU.
     @param PB12_MEM *mem - Memory in hardware.
@@ -128,16 +130,19 @@ void pb12SetPswCmp(PB12_CPU *cpu, int value) {
 int pb12GetMemOp(PB12_CPU *cpu, PB12_MEM *mem, int addr) {
     cpu->ear = cpu->bar + addr;
     if (cpu->ear < cpu->bar || cpu->ear > cpu->lr) {
-        pb12ErrorMsg(pb12ErrorStr[PB12_ERROR_ADDRESS_RANGE],
+        pb12ErrorMsg(mem->config, pb12ErrorStr[PB12_ERROR_ADDRESS_RANGE],
                      cpu->ear, cpu->bar, cpu->lr);
     }
+    if (mem->mmu != NULL)
+        cpu->ear = pb12Translate(mem, cpu->ear);
     return pb12GetMemValue(mem, cpu->ear);
 }
 
 
 /**
     Used with operands that write to memory.  This ensure that the effective
-    address remains within the bounds of base address and limit register.
+    address remains within the bounds of base address and limit register,
+    and translates it through the page tables if memory is paged.
 
     @param PB12_CPU *cpu - CPU.
     @param PB12_MEM *mem - Memory in hardware.
@@ -147,9 +152,42 @@ int pb12GetMemOp(PB12_CPU *cpu, PB12_MEM *mem, int addr) {
 void pb12PutMemOp(PB12_CPU *cpu, PB12_MEM *mem, int addr, int value) {
     cpu->ear = cpu->bar + addr;
     if (cpu->ear < cpu->bar || cpu->ear > cpu->lr) {
-        pb12ErrorMsg(pb12ErrorStr[PB12_ERROR_ADDRESS_RANGE],
+        pb12ErrorMsg(mem->config, pb12ErrorStr[PB12_ERROR_ADDRESS_RANGE],
                      cpu->ear, cpu->bar, cpu->lr);
     }
+    if (mem->mmu != NULL)
+        cpu->ear = pb12Translate(mem, cpu->ear);
+    pb12PutMemValue(mem, cpu->ear, value);
+}
+
+
+/**
+    Reads memory for an instruction whose address was proved to be in range
+    when its program was loaded (see pb12VerifyProgram()), so the bounds
+    are not checked again.
+
+    @param PB12_CPU *cpu - CPU.
+    @param PB12_MEM *mem - Memory in hardware.
+    @param int addr - Relative address to read memory from.
+*/
+int pb12GetMemOpUnchecked(PB12_CPU *cpu, PB12_MEM *mem, int addr) {
+    cpu->ear = cpu->bar + addr;
+    return pb12GetMemValue(mem, cpu->ear);
+}
+
+
+/**
+    Writes memory for an instruction whose address was proved to be in
+    range when its program was loaded (see pb12VerifyProgram()), so the
+    bounds are not checked again.
+
+    @param PB12_CPU *cpu - CPU.
+    @param PB12_MEM *mem - Memory in hardware.
+    @param int addr - Relative address to write memory to.
+    @param int value - Value to write to memory.
+*/
+void pb12PutMemOpUnchecked(PB12_CPU *cpu, PB12_MEM *mem, int addr, int value) {
+    cpu->ear = cpu->bar + addr;
     pb12PutMemValue(mem, cpu->ear, value);
 }
 
@@ -283,416 +321,86 @@ void pb12DumpCPU(PB12_CPU *cpu) {
 
 
 /**
-    Fetch next instruction.
+    Print the trace line for the instruction in the instruction register.
+
+    @param PB12_CPU *cpu - CPU.
+    @param int opcode - Opcode of the instruction.
+*/
+void pb12TraceInst(PB12_CPU *cpu, int opcode) {
+    printf("PC=%02d IC=%02d IR=%.6s: ", cpu->pc, cpu->ic, cpu->ir);
+    if (opcode < PB12_MAX_OPCODE)
+        printf("%s.\n", pb12InstDesc[opcode]);
+    else if (opcode == PB12_HLT)
+        printf("%s.\n", pb12InstDesc[PB12_MAX_OPCODE]);
+    else
+        printf("INVALID OPCODE\n");
+}
+
+
+/**
+    Fetch next instruction.  This also makes sure the decoded instruction
+    cache has a valid entry for the fetched word.
 
     PB12_CPU *cpu - CPU.
 */
 void pb12Fetch(PB12_CPU *cpu, PB12_MEM *mem) {
     cpu->ear = cpu->bar + cpu->pc;
-    memcpy(cpu->ir, mem->mem[cpu->ear], 6);
+    if (mem->mmu != NULL)
+        cpu->ear = pb12Translate(mem, cpu->ear);
+    memcpy(cpu->ir, pb12GetDecoded(mem, cpu->ear)->text, 6);
     --cpu->ic;
 }
 
 
+/*
+    pb12_execute.inc is compiled once for untraced runs and once for traced
+    runs.  PB12_TRACED is a constant in each, so untraced execution has no
+    trace checks at all.
+*/
+#define PB12_TRACED 0
+#define PB12_EXECUTE pb12ExecuteUntraced
+#define PB12_RUN_CPU pb12RunCpuUntraced
+#include "pb12_execute.inc"
+#undef PB12_TRACED
+#undef PB12_EXECUTE
+#undef PB12_RUN_CPU
+
+#define PB12_TRACED 1
+#define PB12_EXECUTE pb12ExecuteTraced
+#define PB12_RUN_CPU pb12RunCpuTraced
+#include "pb12_execute.inc"
+#undef PB12_TRACED
+#undef PB12_EXECUTE
+#undef PB12_RUN_CPU
+
+
 /**
-    Execute current instruction.
+    Execute current instruction.  Operands come from the decoded instruction
+    cache entry that pb12Fetch() validated.
 
     PB12_CPU *cpu - CPU.
 
     @return int  PB12_SUCCESS, PB12_FAILURE, or PB12_TERMINATE
 */
 int pb12Execute(PB12_CPU *cpu, PB12_HW *hw) {
-    /* All of these are static for assumed slight performance reasons. */
-    static int opcode;
-    static short int *ptrReg1;
-    static short int *ptrReg2;
-    static int *genReg1;
-    static int *genReg2;
-    static int addr;
-    PB12_MEM *mem;
-
-    mem = &hw->mem;
-
-    opcode = pb12GetOpcode(cpu);
-
-    /* TODO: Figure out what I want to do about error messages */
-    if (pb12Options & PB12_OPT_VERBOSE) {
-        printf("PC=%02d IC=%02d IR=%.6s: ", cpu->pc, cpu->ic, cpu->ir);
-        if (opcode < PB12_MAX_OPCODE)
-            printf("%s.\n", pb12InstDesc[opcode]);
-        else if (opcode == PB12_HLT)
-            printf("%s.\n", pb12InstDesc[PB12_MAX_OPCODE]);
-        else
-            printf("INVALID OPCODE\n");
-    }
-
-    if (opcode != PB12_HLT)
-        ++cpu->pc;
-
-    switch (opcode) {
-    case PB12_LOD_PTR_I:    /* 0 - Load Pointer Immediate */
-        ptrReg1 = pb12GetPointerRegister(cpu, 0);
-        if (!ptrReg1) {
-            pb12ErrorMsg(pb12ErrorStr[PB12_ERROR_INVALID_PTR_1]);
-            return PB12_FAILURE;
-        }
-        *ptrReg1 = pb12GetOperand(cpu, 1);
-        break;
-
-    case PB12_ADD_PTR_I:    /* 1 - Add to Pointer Immediate */
-        ptrReg1 = pb12GetPointerRegister(cpu, 0);
-        if (!ptrReg1) {
-            pb12ErrorMsg(pb12ErrorStr[PB12_ERROR_INVALID_PTR_1]);
-            return PB12_FAILURE;
-        }
-        *ptrReg1 += pb12GetOperand(cpu, 1);
-        if (*ptrReg1 > 99)
-            *ptrReg1 -= 100;
-        break;
-
-    case PB12_SUB_PTR_I:    /* 2 - Subtract from Pointer Immediate */
-        ptrReg1 = pb12GetPointerRegister(cpu, 0);
-        if (!ptrReg1) {
-            pb12ErrorMsg(pb12ErrorStr[PB12_ERROR_INVALID_PTR_1]);
-            return PB12_FAILURE;
-        }
-        *ptrReg1 -= pb12GetOperand(cpu, 1);
-        if (*ptrReg1 < 0)
-            *ptrReg1 += 100;
-        break;
-
-    case PB12_LOD_ACC_I:    /* 3 - Load Accumulator Immediate */
-        cpu->acc = pb12GetInstValue(cpu);
-        break;
-
-    case PB12_LOD_ACC_R:    /* 4 - Load Accumulator Register Addressing */
-        ptrReg1 = pb12GetPointerRegister(cpu, 0);
-        if (!ptrReg1) {
-            pb12ErrorMsg(pb12ErrorStr[PB12_ERROR_INVALID_PTR_1]);
-            return PB12_FAILURE;
-        }
-        cpu->acc = pb12GetMemOp(cpu, mem, *ptrReg1);
-        break;
-
-    case PB12_LOD_ACC_D:    /* 5 - Load Accumulator Direct Addressing */
-        addr = pb12GetOperand(cpu, 0);
-        if (addr >= mem->mem_size) {
-            pb12ErrorMsg(pb12ErrorStr[PB12_ERROR_INVALID_ADDR]);
-            return PB12_FAILURE;
-        }
-        cpu->acc = pb12GetMemOp(cpu, mem, addr);
-        break;
-
-    case PB12_STO_ACC_R:    /* 6 - Store Accumulator Register Addressing */
-        ptrReg1 = pb12GetPointerRegister(cpu, 0);
-        if (!ptrReg1) {
-            pb12ErrorMsg(pb12ErrorStr[PB12_ERROR_INVALID_PTR_1]);
-            return PB12_FAILURE;
-        }
-        pb12PutMemOp(cpu, mem, *ptrReg1, cpu->acc);
-        break;
-
-    case PB12_STO_ACC_D:    /* 7 - Store Accumulator Direct Addressing */
-        addr = pb12GetOperand(cpu, 0);
-        if (addr >= mem->mem_size) {
-            pb12ErrorMsg(pb12ErrorStr[PB12_ERROR_INVALID_ADDR]);
-            return PB12_FAILURE;
-        }
-        pb12PutMemOp(cpu, mem, addr, cpu->acc);
-        break;
-
-    case PB12_STO_REG_R:    /* 8 - Store Register to Memory: Register Addressing */
-        genReg1 = pb12GetGeneralRegister(cpu, 0);
-        if (!genReg1) {
-            pb12ErrorMsg(pb12ErrorStr[PB12_ERROR_INVALID_REG_1]);
-            return PB12_FAILURE;
-        }
-        ptrReg2 = pb12GetPointerRegister(cpu, 1);
-        if (!ptrReg2) {
-            pb12ErrorMsg(pb12ErrorStr[PB12_ERROR_INVALID_PTR_2]);
-            return PB12_FAILURE;
-        }
-        pb12PutMemOp(cpu, mem, *ptrReg2, *genReg1);
-        break;
-
-    case PB12_STO_REG_D:    /* 9 - Store Register to Memory: Direct Addressing */
-        genReg1 = pb12GetGeneralRegister(cpu, 0);
-        if (!genReg1) {
-            pb12ErrorMsg(pb12ErrorStr[PB12_ERROR_INVALID_REG_1]);
-            return PB12_FAILURE;
-        }
-        addr = pb12GetOperand(cpu, 1);
-        if (addr >= mem->mem_size) {
-            pb12ErrorMsg(pb12ErrorStr[PB12_ERROR_INVALID_ADDR]);
-            return PB12_FAILURE;
-        }
-        pb12PutMemOp(cpu, mem, addr, *genReg1);
-        break;
-
-    case PB12_LOD_REG_R:    /* 10 - Load Register from Memory: Register Addressing */
-        genReg1 = pb12GetGeneralRegister(cpu, 0);
-        if (!genReg1) {
-            pb12ErrorMsg(pb12ErrorStr[PB12_ERROR_INVALID_REG_1]);
-            return PB12_FAILURE;
-        }
-        ptrReg2 = pb12GetPointerRegister(cpu, 1);
-        if (!ptrReg2) {
-            pb12ErrorMsg(pb12ErrorStr[PB12_ERROR_INVALID_PTR_2]);
-            return PB12_FAILURE;
-        }
-        *genReg1 = pb12GetMemOp(cpu, mem, *ptrReg2);
-        break;
-
-    case PB12_LOD_REG_D:    /* 11 - Load Register from Memory: Direct Addressing */
-        genReg1 = pb12GetGeneralRegister(cpu, 0);
-        if (!genReg1) {
-            pb12ErrorMsg(pb12ErrorStr[PB12_ERROR_INVALID_REG_1]);
-            return PB12_FAILURE;
-        }
-        addr = pb12GetOperand(cpu, 1);
-        if (addr >= mem->mem_size) {
-            pb12ErrorMsg(pb12ErrorStr[PB12_ERROR_INVALID_ADDR]);
-            return PB12_FAILURE;
-        }
-        *genReg1 = pb12GetMemOp(cpu, mem, addr);
-        break;
-
-    case PB12_LOD_REG_R0_I: /* 12 - Load Register R0 Immediate */
-        cpu->r0 = pb12GetInstValue(cpu);
-        break;
-
-    case PB12_TRA_REG_REG:  /* 13 - Register to Register Transfer */
-        genReg1 = pb12GetGeneralRegister(cpu, 0);
-        if (!genReg1) {
-            pb12ErrorMsg(pb12ErrorStr[PB12_ERROR_INVALID_REG_1]);
-            return PB12_FAILURE;
-        }
-        genReg2 = pb12GetGeneralRegister(cpu, 1);
-        if (!genReg2) {
-            pb12ErrorMsg(pb12ErrorStr[PB12_ERROR_INVALID_REG_2]);
-            return PB12_FAILURE;
-        }
-        *genReg1 = *genReg2;
-        break;
-
-    case PB12_LOD_ACC_REG:  /* 14 - Load Accumulator from Register */
-        genReg1 = pb12GetGeneralRegister(cpu, 0);
-        if (!genReg1) {
-            pb12ErrorMsg(pb12ErrorStr[PB12_ERROR_INVALID_REG_1]);
-            return PB12_FAILURE;
-        }
-        cpu->acc = *genReg1;
-        break;
-
-    case PB12_LOD_REG_ACC:  /* 15 - Load Register from Accumulator */
-        genReg1 = pb12GetGeneralRegister(cpu, 0);
-        if (!genReg1) {
-            pb12ErrorMsg(pb12ErrorStr[PB12_ERROR_INVALID_REG_1]);
-            return PB12_FAILURE;
-        }
-        *genReg1 = cpu->acc;
-        break;
-
-    case PB12_ADD_ACC_I:    /* 16 - Add Accumulator Immediate */
-        cpu->acc += pb12GetInstValue(cpu);
-        if (cpu->acc > 9999)
-            cpu->acc -= 10000;
-        break;
-
-    case PB12_SUB_ACC_I:    /* 17 - Subtract Accumulator Immediate */
-        cpu->acc -= pb12GetInstValue(cpu);
-        if (cpu->acc < 0000)
-            cpu->acc += 10000;
-        break;
-
-    case PB12_ADD_ACC_REG:  /* 18 - Add contents of Register from Accumulator */
-        genReg1 = pb12GetGeneralRegister(cpu, 0);
-        if (!genReg1) {
-            pb12ErrorMsg(pb12ErrorStr[PB12_ERROR_INVALID_REG_1]);
-            return PB12_FAILURE;
-        }
-        cpu->acc += *genReg1;
-        if (cpu->acc > 9999)
-            cpu->acc -= 10000;
-        break;
-
-    case PB12_SUB_ACC_REG:  /* 19 - Subtract contents of Register from Accumulator */
-        genReg1 = pb12GetGeneralRegister(cpu, 0);
-        if (!genReg1) {
-            pb12ErrorMsg(pb12ErrorStr[PB12_ERROR_INVALID_REG_1]);
-            return PB12_FAILURE;
-        }
-        cpu->acc -= *genReg1;
-        if (cpu->acc < 0)
-            cpu->acc += 10000;
-        break;
-
-    case PB12_ADD_ACC_R:    /* 20 - Add Accumulator Register Addressing */
-        ptrReg1 = pb12GetPointerRegister(cpu, 0);
-        if (!ptrReg1) {
-            pb12ErrorMsg(pb12ErrorStr[PB12_ERROR_INVALID_PTR_1]);
-            return PB12_FAILURE;
-        }
-        cpu->acc += pb12GetMemOp(cpu, mem, *ptrReg1);
-        if (cpu->acc > 9999)
-            cpu->acc -= 9999;
-        break;
-
-    case PB12_ADD_ACC_D:    /* 21 - Add Accumulator Direct Addressing */
-        addr = pb12GetOperand(cpu, 0);
-        if (addr >= mem->mem_size) {
-            pb12ErrorMsg(pb12ErrorStr[PB12_ERROR_INVALID_ADDR]);
-            return PB12_FAILURE;
-        }
-        cpu->acc += pb12GetMemOp(cpu, mem, addr);
-        if (cpu->acc > 9999)
-            cpu->acc -= 10000;
-        break;
-
-    case PB12_SUB_ACC_R:    /* 22 - Subtract from Accumulator Register Addressing */
-        ptrReg1 = pb12GetPointerRegister(cpu, 0);
-        if (!ptrReg1) {
-            pb12ErrorMsg(pb12ErrorStr[PB12_ERROR_INVALID_PTR_1]);
-            return PB12_FAILURE;
-        }
-        cpu->acc -= pb12GetMemOp(cpu, mem, *ptrReg1);
-        if (cpu->acc < 0)
-            cpu->acc += 10000;
-        break;
-
-    case PB12_SUB_ACC_D:    /* 23 - Subtract from Accumulator Direct Addressing */
-        addr = pb12GetOperand(cpu, 0);
-        if (addr >= mem->mem_size) {
-            pb12ErrorMsg(pb12ErrorStr[PB12_ERROR_INVALID_ADDR]);
-            return PB12_FAILURE;
-        }
-        cpu->acc -= pb12GetMemOp(cpu, mem, addr);
-        if (cpu->acc < 0)
-            cpu->acc += 10000;
-        break;
-
-    case PB12_EQU_R:        /* 24 - Compare Equal Register Addressing */
-        ptrReg1 = pb12GetPointerRegister(cpu, 0);
-        if (!ptrReg1) {
-            pb12ErrorMsg(pb12ErrorStr[PB12_ERROR_INVALID_PTR_1]);
-            return PB12_FAILURE;
-        }
-        pb12SetPswCmp(cpu, cpu->acc == pb12GetMemOp(cpu, mem, *ptrReg1));
-        break;
-
-    case PB12_LES_R:        /* 25 - Compare Less Register Addressing */
-        ptrReg1 = pb12GetPointerRegister(cpu, 0);
-        if (!ptrReg1) {
-            pb12ErrorMsg(pb12ErrorStr[PB12_ERROR_INVALID_PTR_1]);
-            return PB12_FAILURE;
-        }
-        pb12SetPswCmp(cpu, cpu->acc < pb12GetMemOp(cpu, mem, *ptrReg1));
-        break;
-
-    case PB12_GRE_R:        /* 26 - Compare Greater Register Addressing */
-        ptrReg1 = pb12GetPointerRegister(cpu, 0);
-        if (!ptrReg1) {
-            pb12ErrorMsg(pb12ErrorStr[PB12_ERROR_INVALID_PTR_1]);
-            return PB12_FAILURE;
-        }
-        pb12SetPswCmp(cpu, cpu->acc > pb12GetMemOp(cpu, mem, *ptrReg1));
-        break;
-
-    case PB12_GRE_I:        /* 27 - Compare Greater Immediate */
-        pb12SetPswCmp(cpu, cpu->acc > pb12GetInstValue(cpu));
-        break;
-
-    case PB12_EQU_I:        /* 28 - Compare Equal Immediate */
-        pb12SetPswCmp(cpu, cpu->acc == pb12GetInstValue(cpu));
-        break;
-
-    case PB12_LES_I:        /* 29 - Compare Less Immediate */
-        pb12SetPswCmp(cpu, cpu->acc < pb12GetInstValue(cpu));
-        break;
-
-    case PB12_EQU_REG:      /* 30 - Compare Register Equal */
-        genReg1 = pb12GetGeneralRegister(cpu, 0);
-        if (!genReg1) {
-            pb12ErrorMsg(pb12ErrorStr[PB12_ERROR_INVALID_REG_1]);
-            return PB12_FAILURE;
-        }
-        pb12SetPswCmp(cpu, cpu->acc == *genReg1);
-        break;
-
-    case PB12_LES_REG:      /* 31 - Compare Register Less */
-        genReg1 = pb12GetGeneralRegister(cpu, 0);
-        if (!genReg1) {
-            pb12ErrorMsg(pb12ErrorStr[PB12_ERROR_INVALID_REG_1]);
-            return PB12_FAILURE;
-        }
-        pb12SetPswCmp(cpu, cpu->acc < *genReg1);
-        break;
-
-    case PB12_GRE_REG:      /* 32 - Compare Register Greater */
-        genReg1 = pb12GetGeneralRegister(cpu, 0);
-        if (!genReg1) {
-            pb12ErrorMsg(pb12ErrorStr[PB12_ERROR_INVALID_REG_1]);
-            return PB12_FAILURE;
-        }
-        pb12SetPswCmp(cpu, cpu->acc > *genReg1);
-        break;
-
-    case PB12_BRT:          /* 33 - Branch Condition True */
-        if (cpu->psw[0] == 'T') {
-            cpu->pc = pb12GetOperand(cpu, 0);
-        }
-        break;
-
-    case PB12_BRF:          /* 34 - Branch Condition False */
-        if (cpu->psw[0] == 'F') {
-            cpu->pc = pb12GetOperand(cpu, 0);
-        }
-        break;
-
-    case PB12_BRU:          /* 35 - Branch Unconditional */
-        cpu->pc = pb12GetOperand(cpu, 0);
-        break;
-
-    case PB12_HLT:          /* 99 - Halt */
-        return PB12_TERMINATE;
-        break;
-
-    case PB12_TRAP:         /* 36 - OS Trap Instruction */
-        genReg1 = pb12GetGeneralRegister(cpu, 0);
-        if (!genReg1) {
-            pb12ErrorMsg(pb12ErrorStr[PB12_ERROR_INVALID_REG_1]);
-            return PB12_FAILURE;
-        }
-
-        hw->trap_num = *genReg1;
-        hw->trap_op = pb12GetRegisterNumber(cpu, 1);
-
-        break;
-
-    case PB12_MOD:          /* 37 - Modulo Operator */
-        genReg1 = pb12GetGeneralRegister(cpu, 0);
-        if (!genReg1) {
-            pb12ErrorMsg(pb12ErrorStr[PB12_ERROR_INVALID_REG_1]);
-            return PB12_FAILURE;
-        }
-
-        genReg2 = pb12GetGeneralRegister(cpu, 1);
-        if (!genReg2) {
-            pb12ErrorMsg(pb12ErrorStr[PB12_ERROR_INVALID_REG_2]);
-            return PB12_FAILURE;
-        }
-
-        cpu->acc = *genReg1 % *genReg2;
+    if (hw->config->options & PB12_OPT_VERBOSE)
+        return pb12ExecuteTraced(cpu, hw);
+    return pb12ExecuteUntraced(cpu, hw);
+}
 
-        /* printf("%d MOD %d = %d\n", *genReg1, *genReg2, cpu->acc); */
 
-        break;
+/**
+    Runs instructions one at a time, traced if the VM was started with
+    PB12_OPT_VERBOSE.
 
-    default:
-        pb12ErrorMsg(pb12ErrorStr[PB12_ERROR_INVALID_OPCODE]);
-        return PB12_FAILURE;
-        /*return PB12_TERMINATE;*/
-    }
+    @param PB12_CPU *cpu - CPU.
+    @param PB12_HW *hw - Hardware.
+    @param int count - Maximum number of instructions, or 0.
 
-    return PB12_SUCCESS;
+    @return int - PB12_SUCCESS, PB12_FAILURE, or PB12_TERMINATE
+*/
+int pb12RunCpu(PB12_CPU *cpu, PB12_HW *hw, int count) {
+    if (hw->config->options & PB12_OPT_VERBOSE)
+        return pb12RunCpuTraced(cpu, hw, count);
+    return pb12RunCpuUntraced(cpu, hw, count);
 }
@@ -78,7 +78,8 @@ void pb12SetPswCmp(PB12_CPU *cpu, int value);
 
 /**
     Used with operands that get memory.  This ensures that the effective
-    address remains within bounds of base address and limit register.
+    address remains within bounds of base address and limit register, and
+    translates it through the page tables if memory is paged.
 
     @param PB12_CPU *cpu - CPU.
     @param PB12_MEM *mem - Memory in hardware.
@@ -89,7 +90,8 @@ int pb12GetMemOp(PB12_CPU *cpu, struct S_PB12_MEM *mem, int addr);
 
 /**
     Used with operands that write to memory.  This ensure that the effective
-    address remains within the bounds of base address and limit register.
+    address remains within the bounds of base address and limit register,
+    and translates it through the page tables if memory is paged.
 
     @param PB12_CPU *cpu - CPU.
     @param PB12_MEM *mem - Memory in hardware.
@@ -99,6 +101,31 @@ int pb12GetMemOp(PB12_CPU *cpu, struct S_PB12_MEM *mem, int addr);
 void pb12PutMemOp(PB12_CPU *cpu, struct S_PB12_MEM *mem, int addr, int value);
 
 
+/**
+    Reads memory for an instruction whose address was proved to be in range
+    when its program was loaded (see pb12VerifyProgram()), so the bounds
+    are not checked again.
+
+    @param PB12_CPU *cpu - CPU.
+    @param PB12_MEM *mem - Memory in hardware.
+    @param int addr - Relative address to read memory from.
+*/
+int pb12GetMemOpUnchecked(PB12_CPU *cpu, struct S_PB12_MEM *mem, int addr);
+
+
+/**
+    Writes memory for an instruction whose address was proved to be in
+    range when its program was loaded (see pb12VerifyProgram()), so the
+    bounds are not checked again.
+
+    @param PB12_CPU *cpu - CPU.
+    @param PB12_MEM *mem - Memory in hardware.
+    @param int addr - Relative address to write memory to.
+    @param int value - Value to write to memory.
+*/
+void pb12PutMemOpUnchecked(PB12_CPU *cpu, struct S_PB12_MEM *mem, int addr, int value);
+
+
 /**
     Gets the register number from the instruction.
 
@@ -165,7 +192,17 @@ void pb12DumpCPU(PB12_CPU *cpu);
 
 
 /**
-    Fetch next instruction.
+    Print the trace line for the instruction in the instruction register.
+
+    @param PB12_CPU *cpu - CPU.
+    @param int opcode - Opcode of the instruction.
+*/
+void pb12TraceInst(PB12_CPU *cpu, int opcode);
+
+
+/**
+    Fetch next instruction.  This also makes sure the decoded instruction
+    cache has a valid entry for the fetched word.
 
     PB12_CPU *cpu - CPU.
 */
@@ -173,7 +210,8 @@ void pb12Fetch(PB12_CPU *cpu, struct S_PB12_MEM *mem);
 
 
 /**
-    Execute current instruction.
+    Execute current instruction.  Operands come from the decoded instruction
+    cache entry that pb12Fetch() validated.
 
     PB12_CPU *cpu - CPU.
 
@@ -181,4 +219,45 @@ void pb12Fetch(PB12_CPU *cpu, struct S_PB12_MEM *mem);
 */
 int pb12Execute(PB12_CPU *cpu, struct S_PB12_HW *hw);
 
+
+/**
+    Runs instructions one at a time with pb12Fetch() and pb12Execute().
+    Execution stops after count instructions (0 for no limit), when the time
+    slice runs out (ic reaches 0), when a trap is raised, or when an
+    instruction halts or fails.  The number of instructions executed is left
+    in hw->retired.  Instructions are traced if the VM was started with
+    PB12_OPT_VERBOSE.
+
+    @param PB12_CPU *cpu - CPU.
+    @param struct S_PB12_HW *hw - Hardware.
+    @param int count - Maximum number of instructions, or 0.
+
+    @return int - PB12_SUCCESS, PB12_FAILURE, or PB12_TERMINATE
+*/
+int pb12RunCpu(PB12_CPU *cpu, struct S_PB12_HW *hw, int count);
+
+
+/**
+    pb12RunCpu() compiled for untraced runs, with no trace checks.
+
+    @param PB12_CPU *cpu - CPU.
+    @param struct S_PB12_HW *hw - Hardware.
+    @param int count - Maximum number of instructions, or 0.
+
+    @return int - PB12_SUCCESS, PB12_FAILURE, or PB12_TERMINATE
+*/
+int pb12RunCpuUntraced(PB12_CPU *cpu, struct S_PB12_HW *hw, int count);
+
+
+/**
+    pb12RunCpu() compiled for traced runs.  Every instruction is printed.
+
+    @param PB12_CPU *cpu - CPU.
+    @param struct S_PB12_HW *hw - Hardware.
+    @param int count - Maximum number of instructions, or 0.
+
+    @return int - PB12_SUCCESS, PB12_FAILURE, or PB12_TERMINATE
+*/
+int pb12RunCpuTraced(PB12_CPU *cpu, struct S_PB12_HW *hw, int count);
+
 #endif /* PB12_CPU_H */
@@ -0,0 +1,54 @@
+#include <string.h>
+#include "pb12_decode.h"
+#include "pb12_mem.h"
+
+
+/**
+    Gets the register number for an operand if it names a register of the
+    requested kind.
+
+    @param const char *operand - Two character operand.
+    @param char kind - 'P' for pointer registers or 'R' for general registers.
+
+    @return signed char - Register number 0-3, or -1 if there is none.
+*/
+static signed char pb12DecodeRegister(const char *operand, char kind) {
+    int num;
+
+    if (operand[0] != kind)
+        return -1;
+
+    num = (int)(operand[1] - '0');
+    if (num < 0 || num > 3)
+        return -1;
+
+    return (signed char)num;
+}
+
+
+/**
+    Decode an instruction word.
+
+    @param const char *word - Six character instruction word.
+    @param PB12_Decoded *dec - Decoded instruction to fill in.
+*/
+void pb12Decode(const char *word, PB12_Decoded *dec) {
+    memcpy(dec->text, word, 6);
+    dec->opcode = pb12CharsToInt(word, 2);
+    if (dec->opcode >= 0 && dec->opcode < PB12_MAX_OPCODE)
+        dec->op = (unsigned char)dec->opcode;
+    else if (dec->opcode == PB12_HLT)
+        dec->op = PB12_DEC_OP_HLT;
+    else
+        dec->op = PB12_DEC_OP_INVALID;
+    dec->xop = dec->op;
+    dec->operand[0] = pb12CharsToInt(&word[2], 2);
+    dec->operand[1] = pb12CharsToInt(&word[4], 2);
+    dec->value = pb12CharsToInt(&word[2], 4);
+    dec->reg = (int)(word[5] - '0');
+    dec->ptr[0] = pb12DecodeRegister(&word[2], 'P');
+    dec->ptr[1] = pb12DecodeRegister(&word[4], 'P');
+    dec->gen[0] = pb12DecodeRegister(&word[2], 'R');
+    dec->gen[1] = pb12DecodeRegister(&word[4], 'R');
+    dec->flags = PB12_DEC_VALID;
+}
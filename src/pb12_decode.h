@@ -0,0 +1,71 @@
+#ifndef PB12_DECODE_H
+#define PB12_DECODE_H
+
+#include "pb12_inst.h"
+
+/* Dispatch indexes for opcodes that are not below PB12_MAX_OPCODE */
+#define PB12_DEC_OP_HLT     PB12_MAX_OPCODE         /* Halt */
+#define PB12_DEC_OP_INVALID (PB12_MAX_OPCODE + 1)   /* Any invalid opcode */
+
+/* Dispatch indexes for superinstructions (see pb12FuseDecoded()) */
+#define PB12_DEC_OP_GRE_I_BR    (PB12_MAX_OPCODE + 2)   /* 27 then 33/34 */
+#define PB12_DEC_OP_EQU_I_BR    (PB12_MAX_OPCODE + 3)   /* 28 then 33/34 */
+#define PB12_DEC_OP_LES_I_BR    (PB12_MAX_OPCODE + 4)   /* 29 then 33/34 */
+#define PB12_DEC_OP_REG_ADD_I   (PB12_MAX_OPCODE + 5)   /* 14 then 16 then 15 */
+#define PB12_DEC_OP_REG_SUB_I   (PB12_MAX_OPCODE + 6)   /* 14 then 17 then 15 */
+
+/* Dispatch indexes for memory instructions proved in range (see pb12_verify.h) */
+#define PB12_DEC_OP_LOD_ACC_R_U (PB12_MAX_OPCODE + 7)   /* 4 */
+#define PB12_DEC_OP_LOD_ACC_D_U (PB12_MAX_OPCODE + 8)   /* 5 */
+#define PB12_DEC_OP_STO_ACC_R_U (PB12_MAX_OPCODE + 9)   /* 6 */
+#define PB12_DEC_OP_STO_ACC_D_U (PB12_MAX_OPCODE + 10)  /* 7 */
+#define PB12_DEC_OP_STO_REG_R_U (PB12_MAX_OPCODE + 11)  /* 8 */
+#define PB12_DEC_OP_STO_REG_D_U (PB12_MAX_OPCODE + 12)  /* 9 */
+#define PB12_DEC_OP_LOD_REG_R_U (PB12_MAX_OPCODE + 13)  /* 10 */
+#define PB12_DEC_OP_LOD_REG_D_U (PB12_MAX_OPCODE + 14)  /* 11 */
+#define PB12_DEC_OP_ADD_ACC_R_U (PB12_MAX_OPCODE + 15)  /* 20 */
+#define PB12_DEC_OP_ADD_ACC_D_U (PB12_MAX_OPCODE + 16)  /* 21 */
+#define PB12_DEC_OP_SUB_ACC_R_U (PB12_MAX_OPCODE + 17)  /* 22 */
+#define PB12_DEC_OP_SUB_ACC_D_U (PB12_MAX_OPCODE + 18)  /* 23 */
+#define PB12_DEC_OP_EQU_R_U     (PB12_MAX_OPCODE + 19)  /* 24 */
+#define PB12_DEC_OP_LES_R_U     (PB12_MAX_OPCODE + 20)  /* 25 */
+#define PB12_DEC_OP_GRE_R_U     (PB12_MAX_OPCODE + 21)  /* 26 */
+#define PB12_DEC_OP_COUNT       (PB12_MAX_OPCODE + 22)
+
+/* Decoded instruction flags */
+#define PB12_DEC_VALID      1   /* Entry matches the word in memory */
+#define PB12_DEC_FUSED      2   /* xop has been worked out for this word */
+#define PB12_DEC_JIT        4   /* Word is part of a JIT compiled block */
+#define PB12_DEC_NATIVE     8   /* Word is part of a translated program */
+#define PB12_DEC_VERIFIED   16  /* Word a load-time proof depends on */
+#define PB12_DEC_UNCHECKED  32  /* Memory operand proved to be in range */
+#define PB12_DEC_LOOP       64  /* Word is part of a summarized loop */
+
+/*
+    An instruction word that has already been parsed.  Decoding is done once
+    per word (when it is loaded or first fetched) instead of every time the
+    instruction is executed.
+*/
+typedef struct S_PB12_Decoded {
+    int opcode;                 /* Opcode, as pb12GetOpcode() */
+    int operand[2];             /* Two digit operands, as pb12GetOperand() */
+    int value;                  /* Four digit value, as pb12GetInstValue() */
+    int reg;                    /* Second register number, as pb12GetRegisterNumber() */
+    char text[6];               /* The word itself, for the instruction register */
+    signed char ptr[2];         /* Pointer register of each operand, -1 if none */
+    signed char gen[2];         /* General register of each operand, -1 if none */
+    unsigned char op;           /* Dispatch index, opcode or PB12_DEC_OP_* */
+    unsigned char xop;          /* Superinstruction starting here, else op */
+    unsigned char flags;        /* PB12_DEC_* flags */
+} PB12_Decoded;
+
+
+/**
+    Decode an instruction word.
+
+    @param const char *word - Six character instruction word.
+    @param PB12_Decoded *dec - Decoded instruction to fill in.
+*/
+void pb12Decode(const char *word, PB12_Decoded *dec);
+
+#endif /* PB12_DECODE_H */
@@ -1,6 +1,7 @@
 #ifndef PB12_HW_H
 #define PB12_HW_H
 
+#include "pb12.h"
 #include "pb12_mem.h"
 #include "pb12_cpu.h"
 
@@ -11,6 +12,10 @@ typedef struct S_PB12_HW {
     /* Because interrupt vectors cannot really be implemented... */
     int trap_num;
     int trap_op;
+
+    int retired;    /* Instructions executed by the last CPU step */
+
+    const PB12_Config *config;  /* Settings of the VM */
 } PB12_HW;
 
 #endif /* PB12_HW_H */
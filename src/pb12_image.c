@@ -0,0 +1,303 @@
+#if defined(__SSE2__)
+    #define PB12_IMAGE_SSE2
+    #include <emmintrin.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pb12.h"
+#include "pb12_image.h"
+#include "pb12_mem.h"
+
+#define PB12_IMAGE_BLOCK    16      /* Bytes classified at once */
+#define PB12_IMAGE_CHUNK    255     /* Most bytes fgets() returns of a line */
+#define PB12_IMAGE_READ     4096    /* Bytes read from the file at once */
+
+/* Bitmaps of a file, one bit per byte, PB12_IMAGE_BLOCK bits per entry */
+typedef struct S_PB12_ImageMaps {
+    unsigned short *newline;    /* Byte is '\n' */
+    unsigned short *nul;        /* Byte is '\0' */
+    unsigned short *digit;      /* Byte is '0' to '9' */
+} PB12_ImageMaps;
+
+
+/**
+    Find the line ends, NULs and digits among PB12_IMAGE_BLOCK bytes.
+    Register letters are not looked for: a tail that is not four digits is
+    kept as text whatever it holds, and register operands are checked when
+    the word is first decoded, as they are for words a program writes.
+
+    @param const char *p - Bytes to classify.
+    @param PB12_ImageMaps *maps - Bitmaps to fill in.
+    @param size_t b - Entry of the bitmaps the bytes belong in.
+*/
+static void pb12ClassifyBlock(const char *p, PB12_ImageMaps *maps, size_t b) {
+#ifdef PB12_IMAGE_SSE2
+    __m128i bytes;
+    __m128i digits;
+
+    bytes = _mm_loadu_si128((const __m128i*) p);
+    digits = _mm_sub_epi8(bytes, _mm_set1_epi8('0'));
+
+    maps->newline[b] = (unsigned short)_mm_movemask_epi8(
+        _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\n')));
+    maps->nul[b] = (unsigned short)_mm_movemask_epi8(
+        _mm_cmpeq_epi8(bytes, _mm_setzero_si128()));
+
+    /* Digits are the bytes that are no more than 9 above '0', unsigned. */
+    maps->digit[b] = (unsigned short)_mm_movemask_epi8(
+        _mm_cmpeq_epi8(_mm_min_epu8(digits, _mm_set1_epi8(9)), digits));
+#else
+    unsigned int newline;
+    unsigned int nul;
+    unsigned int digit;
+    int i;
+
+    newline = nul = digit = 0;
+    for (i=0; i<PB12_IMAGE_BLOCK; i++) {
+        if (p[i] == '\n')
+            newline |= 1u << i;
+        if (p[i] == '\0')
+            nul |= 1u << i;
+        if (p[i] >= '0' && p[i] <= '9')
+            digit |= 1u << i;
+    }
+    maps->newline[b] = (unsigned short)newline;
+    maps->nul[b] = (unsigned short)nul;
+    maps->digit[b] = (unsigned short)digit;
+#endif
+}
+
+
+/**
+    Get up to sixteen bits of a bitmap.
+
+    @param const unsigned short *map - Bitmap.
+    @param size_t pos - First bit.
+    @param int n - Number of bits.
+
+    @return unsigned int - The bits, the first one lowest.
+*/
+static unsigned int pb12ImageBits(const unsigned short *map, size_t pos, int n) {
+    unsigned long bits;
+
+    bits = map[pos / PB12_IMAGE_BLOCK] |
+           ((unsigned long)map[pos / PB12_IMAGE_BLOCK + 1] << PB12_IMAGE_BLOCK);
+    return (unsigned int)(bits >> (pos % PB12_IMAGE_BLOCK)) & ((1u << n) - 1);
+}
+
+
+/**
+    Add the words of one line to an image, splitting it the way fgets()
+    with a 256 byte buffer would.
+
+    @param PB12_Image *image - Image.
+    @param const char *data - The whole file.
+    @param const PB12_ImageMaps *maps - Bitmaps of the file.
+    @param size_t start - First byte of the line.
+    @param size_t end - Byte after the line, past its '\n'.
+*/
+static void pb12ImageLine(PB12_Image *image, const char *data,
+                          const PB12_ImageMaps *maps, size_t start, size_t end) {
+    const char *word;
+    size_t len;
+    unsigned short tail;
+    int i;
+
+    while (start < end) {
+        len = end - start;
+        if (len > PB12_IMAGE_CHUNK)
+            len = PB12_IMAGE_CHUNK;
+
+        /* strlen() of the piece has to be at least six. */
+        if (len >= 6 && pb12ImageBits(maps->nul, start, 6) == 0) {
+            word = &data[start];
+            memcpy(image->words[image->length], word, 6);
+
+            tail = PB12_WORD_DIGITS;
+            if (pb12ImageBits(maps->digit, start + 2, 4) == 0xF) {
+                tail = 0;
+                for (i=2; i<6; i++)
+                    tail = (unsigned short)(tail * 10 + (word[i] - '0'));
+            }
+            image->tails[image->length] = tail;
+            ++image->length;
+        }
+        start += len;
+    }
+}
+
+
+/**
+    Read all of a file.  The data is followed by PB12_IMAGE_BLOCK zeros, so
+    that whole blocks can be classified.
+
+    @param const char *filename - Path to file.
+    @param size_t *size - Set to the number of bytes in the file.
+
+    @return char* - Contents of the file (to be freed), or NULL.
+*/
+static char *pb12ReadFile(const char *filename, size_t *size) {
+    FILE *fp;
+    char *data;
+    char *more;
+    size_t alloc;
+    size_t got;
+
+    fp = fopen(filename, "rt");
+    if (!fp)
+        return NULL;
+
+    alloc = PB12_IMAGE_READ;
+    data = (char*) malloc(alloc + PB12_IMAGE_BLOCK);
+    *size = 0;
+    while (data) {
+        got = fread(&data[*size], 1, alloc - *size, fp);
+        *size += got;
+        if (*size < alloc)
+            break;
+
+        alloc *= 2;
+        more = (char*) realloc(data, alloc + PB12_IMAGE_BLOCK);
+        if (!more)
+            free(data);
+        data = more;
+    }
+    fclose(fp);
+
+    if (data)
+        memset(&data[*size], 0, PB12_IMAGE_BLOCK);
+    return data;
+}
+
+
+/**
+    Read a program file and convert all of its words.
+
+    @param PB12_Image *image - Image to fill in.
+    @param const char *filename - Path to program file.
+
+    @return int - PB12_SUCCESS, or PB12_FAILURE if the file could not be read.
+*/
+int pb12ReadImage(PB12_Image *image, const char *filename) {
+    PB12_ImageMaps maps;
+    char buffer[PB12_IMAGE_CHUNK + 1];
+    char *data;
+    size_t size;
+    size_t blocks;
+    size_t start;
+    size_t b;
+    unsigned int bits;
+    int bit;
+
+    image->mem_req = 0;
+    image->length = 0;
+    image->words = NULL;
+    image->tails = NULL;
+
+    data = pb12ReadFile(filename, &size);
+    if (!data)
+        return PB12_FAILURE;
+
+    /* One more entry than needed, so pb12ImageBits() can read past the end. */
+    blocks = (size + PB12_IMAGE_BLOCK - 1) / PB12_IMAGE_BLOCK;
+    maps.newline = (unsigned short*) malloc(3 * (blocks + 1) * sizeof(unsigned short));
+
+    /* Every word takes at least six bytes of the file. */
+    image->words = (char (*)[6]) malloc((size / 6 + 1) * sizeof(char[6]));
+    image->tails = (unsigned short*) malloc((size / 6 + 1) * sizeof(unsigned short));
+
+    if (!maps.newline || !image->words || !image->tails) {
+        free(maps.newline);
+        free(data);
+        pb12FreeImage(image);
+        return PB12_FAILURE;
+    }
+    maps.nul = &maps.newline[blocks + 1];
+    maps.digit = &maps.nul[blocks + 1];
+    maps.newline[blocks] = maps.nul[blocks] = maps.digit[blocks] = 0;
+
+    for (b=0; b<blocks; b++)
+        pb12ClassifyBlock(&data[b * PB12_IMAGE_BLOCK], &maps, b);
+
+    /* The first line is read the way pb12QueueProgram() used to read it. */
+    start = 0;
+    while (start < size && start < PB12_IMAGE_CHUNK && data[start] != '\n')
+        ++start;
+    if (start < size && start < PB12_IMAGE_CHUNK)
+        ++start;
+    memcpy(buffer, data, start);
+    buffer[start] = '\0';
+    sscanf(buffer, "%d", &image->mem_req);
+
+    start = 0;
+    for (b=0; b<blocks; b++) {
+        for (bits = maps.newline[b], bit = 0; bits != 0; bits >>= 1, bit++) {
+            if (bits & 1) {
+                pb12ImageLine(image, data, &maps, start, b * PB12_IMAGE_BLOCK + bit + 1);
+                start = b * PB12_IMAGE_BLOCK + bit + 1;
+            }
+        }
+    }
+    if (start < size)
+        pb12ImageLine(image, data, &maps, start, size);
+
+    free(maps.newline);
+    free(data);
+    return PB12_SUCCESS;
+}
+
+
+/**
+    Free the words of an image.  Freeing an image twice is harmless.
+
+    @param PB12_Image *image - Image.
+*/
+void pb12FreeImage(PB12_Image *image) {
+    free(image->words);
+    image->words = NULL;
+    free(image->tails);
+    image->tails = NULL;
+    image->length = 0;
+}
+
+
+/**
+    Put the words of an image into memory, as pb12Load() would.
+
+    @param PB12_MEM *mem - Memory.
+    @param int addr - Address to begin loading into.
+    @param const PB12_Image *image - Image.
+*/
+void pb12LoadImage(PB12_MEM *mem, int addr, const PB12_Image *image) {
+    pb12LoadImageRange(mem, addr, image, 0, image->length);
+}
+
+
+/**
+    Put some of the words of an image into memory, as for a page.
+
+    @param PB12_MEM *mem - Memory.
+    @param int addr - Address to begin loading into.
+    @param const PB12_Image *image - Image.
+    @param int first - First word of the image to load.
+    @param int count - Number of words to load.
+*/
+void pb12LoadImageRange(PB12_MEM *mem, int addr, const PB12_Image *image, int first, int count) {
+    PB12_Word *word;
+    int i;
+
+    for (i=first; i<first+count && i<image->length && addr < mem->mem_size; i++, addr++) {
+        if (image->tails[i] < PB12_WORD_DIGITS) {
+            word = &mem->mem[addr];
+            word->op[0] = image->words[i][0];
+            word->op[1] = image->words[i][1];
+            word->tail = image->tails[i];
+            pb12InvalidateDecoded(mem, addr);
+        }
+        else {
+            pb12PutMemWord(mem, addr, image->words[i]);
+        }
+    }
+}
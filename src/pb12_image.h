@@ -0,0 +1,70 @@
+#ifndef PB12_IMAGE_H
+#define PB12_IMAGE_H
+
+#include "pb12_mem.h"
+
+/*
+    A program file read into memory all at once and already converted to
+    the packed form memory keeps words in, so loading it only has to copy
+    it.  Words are decoded when they are first fetched, like any other
+    word written to memory.
+
+    Words are found the same way pb12Load() finds them: every piece of a
+    line that fgets() would return with a 256 byte buffer and that is at
+    least six characters long is one word.
+*/
+typedef struct S_PB12_Image {
+    int mem_req;                /* Memory the program asks for, on its first line */
+    int length;                 /* Number of words */
+    char (*words)[6];           /* Each word */
+    unsigned short *tails;      /* Last four characters of each word as a
+                                   number, or PB12_WORD_DIGITS if they are
+                                   not all digits */
+} PB12_Image;
+
+
+/**
+    Read a program file and convert all of its words.  The whole file is
+    read with one pass over it, which finds line ends and checks which
+    characters are digits sixteen bytes at a time where SSE2 is available.
+    Only digits matter to the packed form; register operands are left to
+    the decoder.
+
+    @param PB12_Image *image - Image to fill in.
+    @param const char *filename - Path to program file.
+
+    @return int - PB12_SUCCESS, or PB12_FAILURE if the file could not be read.
+*/
+int pb12ReadImage(PB12_Image *image, const char *filename);
+
+
+/**
+    Free the words of an image.  Freeing an image twice is harmless.
+
+    @param PB12_Image *image - Image.
+*/
+void pb12FreeImage(PB12_Image *image);
+
+
+/**
+    Put the words of an image into memory, as pb12Load() would.
+
+    @param PB12_MEM *mem - Memory.
+    @param int addr - Address to begin loading into.
+    @param const PB12_Image *image - Image.
+*/
+void pb12LoadImage(PB12_MEM *mem, int addr, const PB12_Image *image);
+
+
+/**
+    Put some of the words of an image into memory, as for a page.
+
+    @param PB12_MEM *mem - Memory.
+    @param int addr - Address to begin loading into.
+    @param const PB12_Image *image - Image.
+    @param int first - First word of the image to load.
+    @param int count - Number of words to load.
+*/
+void pb12LoadImageRange(PB12_MEM *mem, int addr, const PB12_Image *image, int first, int count);
+
+#endif /* PB12_IMAGE_H */
@@ -0,0 +1,908 @@
+#if defined(__x86_64__) && (defined(__unix__) || defined(__APPLE__))
+    #define PB12_JIT_X86_64
+    #define _DEFAULT_SOURCE     /* MAP_ANONYMOUS is not part of ANSI C */
+    #include <sys/mman.h>
+    #ifndef MAP_ANONYMOUS
+        #define MAP_ANONYMOUS MAP_ANON
+    #endif
+#endif
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include "pb12.h"
+#include "pb12_jit.h"
+#include "pb12_cpu.h"
+#include "pb12_hw.h"
+#include "pb12_mem.h"
+#include "pb12_decode.h"
+#include "pb12_inst.h"
+
+/* Counter value of an address that no block can start at */
+#define PB12_JIT_NEVER      0xFFFF
+
+/* Most bytes of native code one block can need */
+#define PB12_JIT_BLOCK_BYTES    (PB12_JIT_MAX_BLOCK * 192 + 64)
+
+
+#ifdef PB12_JIT_X86_64
+
+/*
+    Compiled blocks are functions
+
+        int block(PB12_CPU *cpu, PB12_MEM *mem)
+
+    returning the number of instructions they executed.  While a block runs
+    rbx holds cpu, rbp holds mem, r12d holds mem->code_writes from when the
+    block started and r13d holds the instruction counter from when the block
+    started.  Registers of the virtual CPU are kept in the PB12_CPU structure,
+    so every exit leaves it exactly as the interpreter would have.  Memory
+    operands go through pb12GetMemOp() and pb12PutMemOp(), which do the base
+    and limit checks, unless the word was proved to be in range when its
+    program was loaded.
+*/
+typedef int (*PB12_JitBlock)(PB12_CPU *cpu, PB12_MEM *mem);
+
+/* x86-64 registers, as used in the ModRM byte */
+#define PB12_X86_EAX    0
+#define PB12_X86_ECX    1
+#define PB12_X86_EDX    2
+
+/* Condition codes for setcc (0x0F 0x90+cc) */
+#define PB12_X86_CC_E   0x4
+#define PB12_X86_CC_L   0xC
+#define PB12_X86_CC_G   0xF
+
+/* What an instruction left behind once it has been compiled */
+#define PB12_JIT_STOP   0   /* Could not be compiled, nothing was emitted */
+#define PB12_JIT_NEXT   1   /* Compiled, the block goes on */
+#define PB12_JIT_STORE  2   /* Compiled store, followed by a code write check */
+#define PB12_JIT_BRANCH 3   /* Branch that ends the block, nothing emitted */
+
+#define PB12_CPU_OFF(field) ((int)offsetof(PB12_CPU, field))
+
+
+/**
+    Emit one byte of native code.
+
+    @param unsigned char **p - Where to write, moved past the byte.
+    @param int byte - Byte to write.
+*/
+static void pb12EmitByte(unsigned char **p, int byte) {
+    *(*p)++ = (unsigned char)byte;
+}
+
+
+/**
+    Emit a little endian immediate value.
+
+    @param unsigned char **p - Where to write, moved past the value.
+    @param long value - Value to write.
+    @param int size - Number of bytes to write.
+*/
+static void pb12EmitImm(unsigned char **p, long value, int size) {
+    int i;
+
+    for (i=0; i<size; i++)
+        pb12EmitByte(p, (int)((unsigned long)value >> (i * 8)) & 0xFF);
+}
+
+
+/**
+    Emit the ModRM byte and displacement of a [rbx + offset] operand, which
+    is a field of the virtual CPU.
+
+    @param unsigned char **p - Where to write.
+    @param int reg - Register (or opcode extension) of the ModRM byte.
+    @param int offset - Offset of the field in PB12_CPU.
+*/
+static void pb12EmitCpuField(unsigned char **p, int reg, int offset) {
+    pb12EmitByte(p, 0x80 | (reg << 3) | 3);
+    pb12EmitImm(p, offset, 4);
+}
+
+
+/**
+    Emit a call to a C function with cpu and mem as the first two arguments.
+    The other arguments have to be in edx and ecx already.
+
+    @param unsigned char **p - Where to write.
+    @param const void *func - Function pointer variable holding the address.
+    @param size_t size - Size of the function pointer.
+*/
+static void pb12EmitCall(unsigned char **p, const void *func, size_t size) {
+    pb12EmitByte(p, 0x48); pb12EmitByte(p, 0x89); pb12EmitByte(p, 0xDF);    /* mov rdi, rbx */
+    pb12EmitByte(p, 0x48); pb12EmitByte(p, 0x89); pb12EmitByte(p, 0xEE);    /* mov rsi, rbp */
+    pb12EmitByte(p, 0x48); pb12EmitByte(p, 0xB8);                           /* mov rax, func */
+    memcpy(*p, func, size);
+    *p += size;
+    pb12EmitByte(p, 0xFF); pb12EmitByte(p, 0xD0);                           /* call rax */
+}
+
+
+/**
+    Emit a call to pb12GetMemOp(), or pb12GetMemOpUnchecked() if the address
+    was proved to be in range, leaving the value in eax.
+
+    @param unsigned char **p - Where to write.
+    @param PB12_Decoded *dec - Instruction.
+    @param int n - Operand holding the address.
+    @param int direct - Nonzero for direct addressing, else register.
+*/
+static void pb12EmitGetMem(unsigned char **p, PB12_Decoded *dec, int n, int direct) {
+    int (*get)(PB12_CPU *, PB12_MEM *, int);
+    PB12_CPU cpu;
+
+    get = pb12GetMemOp;
+    if (dec->flags & PB12_DEC_UNCHECKED)
+        get = pb12GetMemOpUnchecked;
+    if (direct) {
+        pb12EmitByte(p, 0xBA);                                              /* mov edx, addr */
+        pb12EmitImm(p, dec->operand[n], 4);
+    }
+    else {
+        pb12EmitByte(p, 0x0F); pb12EmitByte(p, 0xBF);                       /* movsx edx, word [ptr] */
+        pb12EmitCpuField(p, PB12_X86_EDX,
+                         (int)((char *)pb12GetPtrReg(&cpu, dec->ptr[n]) - (char *)&cpu));
+    }
+    pb12EmitCall(p, &get, sizeof(get));
+}
+
+
+/**
+    Emit a call to pb12PutMemOp(), or pb12PutMemOpUnchecked() if the address
+    was proved to be in range.
+
+    @param unsigned char **p - Where to write.
+    @param PB12_Decoded *dec - Instruction.
+    @param int n - Operand holding the address.
+    @param int direct - Nonzero for direct addressing, else register.
+    @param int value - Offset in PB12_CPU of the register to store.
+*/
+static void pb12EmitPutMem(unsigned char **p, PB12_Decoded *dec, int n, int direct, int value) {
+    void (*put)(PB12_CPU *, PB12_MEM *, int, int);
+    PB12_CPU cpu;
+
+    put = pb12PutMemOp;
+    if (dec->flags & PB12_DEC_UNCHECKED)
+        put = pb12PutMemOpUnchecked;
+    if (direct) {
+        pb12EmitByte(p, 0xBA);                                              /* mov edx, addr */
+        pb12EmitImm(p, dec->operand[n], 4);
+    }
+    else {
+        pb12EmitByte(p, 0x0F); pb12EmitByte(p, 0xBF);                       /* movsx edx, word [ptr] */
+        pb12EmitCpuField(p, PB12_X86_EDX,
+                         (int)((char *)pb12GetPtrReg(&cpu, dec->ptr[n]) - (char *)&cpu));
+    }
+    pb12EmitByte(p, 0x8B);                                                  /* mov ecx, [value] */
+    pb12EmitCpuField(p, PB12_X86_ECX, value);
+    pb12EmitCall(p, &put, sizeof(put));
+}
+
+
+/**
+    Point the rel32 of a jump at a target.
+
+    @param unsigned char *jump - End of the jump instruction, or NULL.
+    @param unsigned char *target - Where to jump to.
+*/
+static void pb12PatchJump(unsigned char *jump, unsigned char *target) {
+    unsigned char *p;
+
+    if (!jump)
+        return;
+    p = jump - 4;
+    pb12EmitImm(&p, (long)(target - jump), 4);
+}
+
+
+/**
+    Emit the wrap around of eax after an addition: if eax > 9999 it has
+    limit subtracted.
+
+    @param unsigned char **p - Where to write.
+    @param int limit - Amount to subtract.
+*/
+static void pb12EmitWrapAdd(unsigned char **p, int limit) {
+    pb12EmitByte(p, 0x3D); pb12EmitImm(p, 9999, 4);                         /* cmp eax, 9999 */
+    pb12EmitByte(p, 0x7E); pb12EmitByte(p, 5);                              /* jle +5 */
+    pb12EmitByte(p, 0x2D); pb12EmitImm(p, limit, 4);                        /* sub eax, limit */
+}
+
+
+/**
+    Emit the wrap around of eax after a subtraction: if eax < 0 it has 10000
+    added.
+
+    @param unsigned char **p - Where to write.
+*/
+static void pb12EmitWrapSub(unsigned char **p) {
+    pb12EmitByte(p, 0x85); pb12EmitByte(p, 0xC0);                           /* test eax, eax */
+    pb12EmitByte(p, 0x79); pb12EmitByte(p, 5);                              /* jns +5 */
+    pb12EmitByte(p, 0x05); pb12EmitImm(p, 10000, 4);                        /* add eax, 10000 */
+}
+
+
+/**
+    Emit the store of eax into a 32 bit field of the virtual CPU.
+
+    @param unsigned char **p - Where to write.
+    @param int offset - Offset of the field in PB12_CPU.
+*/
+static void pb12EmitStore(unsigned char **p, int offset) {
+    pb12EmitByte(p, 0x89);                                                  /* mov [field], eax */
+    pb12EmitCpuField(p, PB12_X86_EAX, offset);
+}
+
+
+/**
+    Emit the load of a 32 bit field of the virtual CPU into eax.
+
+    @param unsigned char **p - Where to write.
+    @param int offset - Offset of the field in PB12_CPU.
+*/
+static void pb12EmitLoad(unsigned char **p, int offset) {
+    pb12EmitByte(p, 0x8B);                                                  /* mov eax, [field] */
+    pb12EmitCpuField(p, PB12_X86_EAX, offset);
+}
+
+
+/**
+    Emit setting the comparison flag of the PSW from the flags of the last
+    cmp: 'T' if the condition holds, else 'F'.
+
+    @param unsigned char **p - Where to write.
+    @param int cc - PB12_X86_CC_* condition.
+*/
+static void pb12EmitSetPsw(unsigned char **p, int cc) {
+    pb12EmitByte(p, 0x0F); pb12EmitByte(p, 0x90 | cc); pb12EmitByte(p, 0xC0);  /* setcc al */
+    pb12EmitByte(p, 0x0F); pb12EmitByte(p, 0xB6); pb12EmitByte(p, 0xC0);       /* movzx eax, al */
+    pb12EmitByte(p, 0x6B); pb12EmitByte(p, 0xC0); pb12EmitByte(p, 'T' - 'F');  /* imul eax, eax, 'T'-'F' */
+    pb12EmitByte(p, 0x83); pb12EmitByte(p, 0xC0); pb12EmitByte(p, 'F');        /* add eax, 'F' */
+    pb12EmitByte(p, 0x88);                                                     /* mov [psw], al */
+    pb12EmitCpuField(p, PB12_X86_EAX, PB12_CPU_OFF(psw));
+}
+
+
+/**
+    Emit the comparison of the accumulator with a value returned in eax.
+
+    @param unsigned char **p - Where to write.
+    @param int cc - PB12_X86_CC_* condition of acc against the value.
+*/
+static void pb12EmitCompareMem(unsigned char **p, int cc) {
+    pb12EmitByte(p, 0x89); pb12EmitByte(p, 0xC1);                           /* mov ecx, eax */
+    pb12EmitLoad(p, PB12_CPU_OFF(acc));
+    pb12EmitByte(p, 0x39); pb12EmitByte(p, 0xC8);                           /* cmp eax, ecx */
+    pb12EmitSetPsw(p, cc);
+}
+
+
+/**
+    Emit the comparison of the accumulator with a general register.
+
+    @param unsigned char **p - Where to write.
+    @param int gen - Offset of the general register.
+    @param int cc - PB12_X86_CC_* condition of acc against the register.
+*/
+static void pb12EmitCompareReg(unsigned char **p, int gen, int cc) {
+    pb12EmitLoad(p, PB12_CPU_OFF(acc));
+    pb12EmitByte(p, 0x3B);                                                  /* cmp eax, [gen] */
+    pb12EmitCpuField(p, PB12_X86_EAX, gen);
+    pb12EmitSetPsw(p, cc);
+}
+
+
+/**
+    Emit the comparison of the accumulator with an immediate value.
+
+    @param unsigned char **p - Where to write.
+    @param int value - Immediate value.
+    @param int cc - PB12_X86_CC_* condition of acc against the value.
+*/
+static void pb12EmitCompareImm(unsigned char **p, int value, int cc) {
+    pb12EmitLoad(p, PB12_CPU_OFF(acc));
+    pb12EmitByte(p, 0x3D); pb12EmitImm(p, value, 4);                        /* cmp eax, value */
+    pb12EmitSetPsw(p, cc);
+}
+
+
+/**
+    Emit a block exit: pc, ic, ir and ear are brought up to date for the
+    instructions executed so far and their count is returned.
+
+    @param unsigned char **p - Where to write.
+    @param PB12_MEM *mem - Memory.
+    @param int addr - Address of the last instruction executed.
+    @param int count - Number of instructions executed.
+    @param int set_ear - Nonzero if ear still has to be set to addr.
+*/
+static void pb12EmitExit(unsigned char **p, PB12_MEM *mem, int addr, int count, int set_ear) {
+    pb12EmitByte(p, 0x66); pb12EmitByte(p, 0x81);                           /* add word [pc], count */
+    pb12EmitCpuField(p, 0, PB12_CPU_OFF(pc));
+    pb12EmitImm(p, count, 2);
+    pb12EmitByte(p, 0x81);                                                  /* sub dword [ic], count */
+    pb12EmitCpuField(p, 5, PB12_CPU_OFF(ic));
+    pb12EmitImm(p, count, 4);
+    pb12EmitByte(p, 0xC7);                                                  /* mov dword [ir], word */
+    pb12EmitCpuField(p, 0, PB12_CPU_OFF(ir));
+    memcpy(*p, pb12GetDecoded(mem, addr)->text, 4);
+    *p += 4;
+    pb12EmitByte(p, 0x66); pb12EmitByte(p, 0xC7);                           /* mov word [ir+4], word+4 */
+    pb12EmitCpuField(p, 0, PB12_CPU_OFF(ir) + 4);
+    memcpy(*p, &pb12GetDecoded(mem, addr)->text[4], 2);
+    *p += 2;
+    if (set_ear) {
+        pb12EmitByte(p, 0xC7);                                              /* mov dword [ear], addr */
+        pb12EmitCpuField(p, 0, PB12_CPU_OFF(ear));
+        pb12EmitImm(p, addr, 4);
+    }
+    pb12EmitByte(p, 0xB8); pb12EmitImm(p, count, 4);                        /* mov eax, count */
+    pb12EmitByte(p, 0x48); pb12EmitByte(p, 0x83);                           /* add rsp, 8 */
+    pb12EmitByte(p, 0xC4); pb12EmitByte(p, 8);
+    pb12EmitByte(p, 0x41); pb12EmitByte(p, 0x5D);                           /* pop r13 */
+    pb12EmitByte(p, 0x41); pb12EmitByte(p, 0x5C);                           /* pop r12 */
+    pb12EmitByte(p, 0x5D);                                                  /* pop rbp */
+    pb12EmitByte(p, 0x5B);                                                  /* pop rbx */
+    pb12EmitByte(p, 0xC3);                                                  /* ret */
+}
+
+
+/**
+    Emit the native code of a single instruction.  Only instructions that
+    cannot fail, trap or halt at run time are compiled.
+
+    @param unsigned char **p - Where to write.
+    @param PB12_MEM *mem - Memory.
+    @param PB12_Decoded *dec - Instruction.
+    @param int *mem_op - Set nonzero if the instruction sets ear itself.
+
+    @return int - PB12_JIT_STOP, PB12_JIT_NEXT, PB12_JIT_STORE or
+                  PB12_JIT_BRANCH
+*/
+static int pb12EmitInst(unsigned char **p, PB12_MEM *mem, PB12_Decoded *dec, int *mem_op) {
+    PB12_CPU cpu;
+    int ptr[2];
+    int gen[2];
+    int n;
+
+    /* Offsets of the registers named by the operands, or -1 */
+    for (n=0; n<2; n++) {
+        ptr[n] = dec->ptr[n] < 0 ? -1 :
+            (int)((char *)pb12GetPtrReg(&cpu, dec->ptr[n]) - (char *)&cpu);
+        gen[n] = dec->gen[n] < 0 ? -1 :
+            (int)((char *)pb12GetGenReg(&cpu, dec->gen[n]) - (char *)&cpu);
+    }
+
+    *mem_op = 0;
+
+    switch (dec->op) {
+    case PB12_LOD_PTR_I:    /* 0 - Load Pointer Immediate */
+        if (ptr[0] < 0)
+            return PB12_JIT_STOP;
+        pb12EmitByte(p, 0x66); pb12EmitByte(p, 0xC7);                       /* mov word [ptr], operand */
+        pb12EmitCpuField(p, 0, ptr[0]);
+        pb12EmitImm(p, dec->operand[1], 2);
+        break;
+
+    case PB12_ADD_PTR_I:    /* 1 - Add to Pointer Immediate */
+    case PB12_SUB_PTR_I:    /* 2 - Subtract from Pointer Immediate */
+        if (ptr[0] < 0)
+            return PB12_JIT_STOP;
+        pb12EmitByte(p, 0x0F); pb12EmitByte(p, 0xBF);                       /* movsx eax, word [ptr] */
+        pb12EmitCpuField(p, PB12_X86_EAX, ptr[0]);
+        pb12EmitByte(p, dec->op == PB12_ADD_PTR_I ? 0x05 : 0x2D);           /* add/sub eax, operand */
+        pb12EmitImm(p, dec->operand[1], 4);
+        pb12EmitByte(p, 0x0F); pb12EmitByte(p, 0xBF); pb12EmitByte(p, 0xC0);   /* movsx eax, ax */
+        if (dec->op == PB12_ADD_PTR_I) {
+            pb12EmitByte(p, 0x83); pb12EmitByte(p, 0xF8); pb12EmitByte(p, 99); /* cmp eax, 99 */
+            pb12EmitByte(p, 0x7E); pb12EmitByte(p, 3);                         /* jle +3 */
+            pb12EmitByte(p, 0x83); pb12EmitByte(p, 0xE8); pb12EmitByte(p, 100);/* sub eax, 100 */
+        }
+        else {
+            pb12EmitByte(p, 0x85); pb12EmitByte(p, 0xC0);                      /* test eax, eax */
+            pb12EmitByte(p, 0x79); pb12EmitByte(p, 3);                         /* jns +3 */
+            pb12EmitByte(p, 0x83); pb12EmitByte(p, 0xC0); pb12EmitByte(p, 100);/* add eax, 100 */
+        }
+        pb12EmitByte(p, 0x66); pb12EmitByte(p, 0x89);                       /* mov [ptr], ax */
+        pb12EmitCpuField(p, PB12_X86_EAX, ptr[0]);
+        break;
+
+    case PB12_LOD_ACC_I:    /* 3 - Load Accumulator Immediate */
+    case PB12_LOD_REG_R0_I: /* 12 - Load Register R0 Immediate */
+        pb12EmitByte(p, 0xC7);                                              /* mov dword [reg], value */
+        pb12EmitCpuField(p, 0, dec->op == PB12_LOD_ACC_I ?
+                         PB12_CPU_OFF(acc) : PB12_CPU_OFF(r0));
+        pb12EmitImm(p, dec->value, 4);
+        break;
+
+    case PB12_LOD_ACC_R:    /* 4 - Load Accumulator Register Addressing */
+        if (ptr[0] < 0)
+            return PB12_JIT_STOP;
+        pb12EmitGetMem(p, dec, 0, 0);
+        pb12EmitStore(p, PB12_CPU_OFF(acc));
+        *mem_op = 1;
+        break;
+
+    case PB12_LOD_ACC_D:    /* 5 - Load Accumulator Direct Addressing */
+        if (dec->operand[0] >= mem->mem_size)
+            return PB12_JIT_STOP;
+        pb12EmitGetMem(p, dec, 0, 1);
+        pb12EmitStore(p, PB12_CPU_OFF(acc));
+        *mem_op = 1;
+        break;
+
+    case PB12_STO_ACC_R:    /* 6 - Store Accumulator Register Addressing */
+        if (ptr[0] < 0)
+            return PB12_JIT_STOP;
+        pb12EmitPutMem(p, dec, 0, 0, PB12_CPU_OFF(acc));
+        *mem_op = 1;
+        return PB12_JIT_STORE;
+
+    case PB12_STO_ACC_D:    /* 7 - Store Accumulator Direct Addressing */
+        if (dec->operand[0] >= mem->mem_size)
+            return PB12_JIT_STOP;
+        pb12EmitPutMem(p, dec, 0, 1, PB12_CPU_OFF(acc));
+        *mem_op = 1;
+        return PB12_JIT_STORE;
+
+    case PB12_STO_REG_R:    /* 8 - Store Register to Memory: Register Addressing */
+        if (gen[0] < 0 || ptr[1] < 0)
+            return PB12_JIT_STOP;
+        pb12EmitPutMem(p, dec, 1, 0, gen[0]);
+        *mem_op = 1;
+        return PB12_JIT_STORE;
+
+    case PB12_STO_REG_D:    /* 9 - Store Register to Memory: Direct Addressing */
+        if (gen[0] < 0 || dec->operand[1] >= mem->mem_size)
+            return PB12_JIT_STOP;
+        pb12EmitPutMem(p, dec, 1, 1, gen[0]);
+        *mem_op = 1;
+        return PB12_JIT_STORE;
+
+    case PB12_LOD_REG_R:    /* 10 - Load Register from Memory: Register Addressing */
+        if (gen[0] < 0 || ptr[1] < 0)
+            return PB12_JIT_STOP;
+        pb12EmitGetMem(p, dec, 1, 0);
+        pb12EmitStore(p, gen[0]);
+        *mem_op = 1;
+        break;
+
+    case PB12_LOD_REG_D:    /* 11 - Load Register from Memory: Direct Addressing */
+        if (gen[0] < 0 || dec->operand[1] >= mem->mem_size)
+            return PB12_JIT_STOP;
+        pb12EmitGetMem(p, dec, 1, 1);
+        pb12EmitStore(p, gen[0]);
+        *mem_op = 1;
+        break;
+
+    case PB12_TRA_REG_REG:  /* 13 - Register to Register Transfer */
+        if (gen[0] < 0 || gen[1] < 0)
+            return PB12_JIT_STOP;
+        pb12EmitLoad(p, gen[1]);
+        pb12EmitStore(p, gen[0]);
+        break;
+
+    case PB12_LOD_ACC_REG:  /* 14 - Load Accumulator from Register */
+        if (gen[0] < 0)
+            return PB12_JIT_STOP;
+        pb12EmitLoad(p, gen[0]);
+        pb12EmitStore(p, PB12_CPU_OFF(acc));
+        break;
+
+    case PB12_LOD_REG_ACC:  /* 15 - Load Register from Accumulator */
+        if (gen[0] < 0)
+            return PB12_JIT_STOP;
+        pb12EmitLoad(p, PB12_CPU_OFF(acc));
+        pb12EmitStore(p, gen[0]);
+        break;
+
+    case PB12_ADD_ACC_I:    /* 16 - Add Accumulator Immediate */
+        pb12EmitLoad(p, PB12_CPU_OFF(acc));
+        pb12EmitByte(p, 0x05); pb12EmitImm(p, dec->value, 4);              /* add eax, value */
+        pb12EmitWrapAdd(p, 10000);
+        pb12EmitStore(p, PB12_CPU_OFF(acc));
+        break;
+
+    case PB12_SUB_ACC_I:    /* 17 - Subtract Accumulator Immediate */
+        pb12EmitLoad(p, PB12_CPU_OFF(acc));
+        pb12EmitByte(p, 0x2D); pb12EmitImm(p, dec->value, 4);              /* sub eax, value */
+        pb12EmitWrapSub(p);
+        pb12EmitStore(p, PB12_CPU_OFF(acc));
+        break;
+
+    case PB12_ADD_ACC_REG:  /* 18 - Add contents of Register from Accumulator */
+        if (gen[0] < 0)
+            return PB12_JIT_STOP;
+        pb12EmitLoad(p, PB12_CPU_OFF(acc));
+        pb12EmitByte(p, 0x03);                                              /* add eax, [gen] */
+        pb12EmitCpuField(p, PB12_X86_EAX, gen[0]);
+        pb12EmitWrapAdd(p, 10000);
+        pb12EmitStore(p, PB12_CPU_OFF(acc));
+        break;
+
+    case PB12_SUB_ACC_REG:  /* 19 - Subtract contents of Register from Accumulator */
+        if (gen[0] < 0)
+            return PB12_JIT_STOP;
+        pb12EmitLoad(p, PB12_CPU_OFF(acc));
+        pb12EmitByte(p, 0x2B);                                              /* sub eax, [gen] */
+        pb12EmitCpuField(p, PB12_X86_EAX, gen[0]);
+        pb12EmitWrapSub(p);
+        pb12EmitStore(p, PB12_CPU_OFF(acc));
+        break;
+
+    case PB12_ADD_ACC_R:    /* 20 - Add Accumulator Register Addressing */
+    case PB12_ADD_ACC_D:    /* 21 - Add Accumulator Direct Addressing */
+        if (dec->op == PB12_ADD_ACC_R ? ptr[0] < 0 : dec->operand[0] >= mem->mem_size)
+            return PB12_JIT_STOP;
+        pb12EmitGetMem(p, dec, 0, dec->op == PB12_ADD_ACC_D);
+        pb12EmitByte(p, 0x03);                                              /* add eax, [acc] */
+        pb12EmitCpuField(p, PB12_X86_EAX, PB12_CPU_OFF(acc));
+        /* Register addressing wraps around by 9999, as the interpreter does. */
+        pb12EmitWrapAdd(p, dec->op == PB12_ADD_ACC_R ? 9999 : 10000);
+        pb12EmitStore(p, PB12_CPU_OFF(acc));
+        *mem_op = 1;
+        break;
+
+    case PB12_SUB_ACC_R:    /* 22 - Subtract from Accumulator Register Addressing */
+    case PB12_SUB_ACC_D:    /* 23 - Subtract from Accumulator Direct Addressing */
+        if (dec->op == PB12_SUB_ACC_R ? ptr[0] < 0 : dec->operand[0] >= mem->mem_size)
+            return PB12_JIT_STOP;
+        pb12EmitGetMem(p, dec, 0, dec->op == PB12_SUB_ACC_D);
+        pb12EmitByte(p, 0x89); pb12EmitByte(p, 0xC1);                       /* mov ecx, eax */
+        pb12EmitLoad(p, PB12_CPU_OFF(acc));
+        pb12EmitByte(p, 0x29); pb12EmitByte(p, 0xC8);                       /* sub eax, ecx */
+        pb12EmitWrapSub(p);
+        pb12EmitStore(p, PB12_CPU_OFF(acc));
+        *mem_op = 1;
+        break;
+
+    case PB12_EQU_R:        /* 24 - Compare Equal Register Addressing */
+    case PB12_LES_R:        /* 25 - Compare Less Register Addressing */
+    case PB12_GRE_R:        /* 26 - Compare Greater Register Addressing */
+        if (ptr[0] < 0)
+            return PB12_JIT_STOP;
+        pb12EmitGetMem(p, dec, 0, 0);
+        pb12EmitCompareMem(p, dec->op == PB12_EQU_R ? PB12_X86_CC_E :
+                           dec->op == PB12_LES_R ? PB12_X86_CC_L : PB12_X86_CC_G);
+        *mem_op = 1;
+        break;
+
+    case PB12_GRE_I:        /* 27 - Compare Greater Immediate */
+        pb12EmitCompareImm(p, dec->value, PB12_X86_CC_G);
+        break;
+
+    case PB12_EQU_I:        /* 28 - Compare Equal Immediate */
+        pb12EmitCompareImm(p, dec->value, PB12_X86_CC_E);
+        break;
+
+    case PB12_LES_I:        /* 29 - Compare Less Immediate */
+        pb12EmitCompareImm(p, dec->value, PB12_X86_CC_L);
+        break;
+
+    case PB12_EQU_REG:      /* 30 - Compare Register Equal */
+    case PB12_LES_REG:      /* 31 - Compare Register Less */
+    case PB12_GRE_REG:      /* 32 - Compare Register Greater */
+        if (gen[0] < 0)
+            return PB12_JIT_STOP;
+        pb12EmitCompareReg(p, gen[0], dec->op == PB12_EQU_REG ? PB12_X86_CC_E :
+                           dec->op == PB12_LES_REG ? PB12_X86_CC_L : PB12_X86_CC_G);
+        break;
+
+    case PB12_BRT:          /* 33 - Branch Condition True */
+    case PB12_BRF:          /* 34 - Branch Condition False */
+    case PB12_BRU:          /* 35 - Branch Unconditional */
+        return PB12_JIT_BRANCH;
+
+    case PB12_MOD:          /* 37 - Modulo Operator */
+        if (gen[0] < 0 || gen[1] < 0)
+            return PB12_JIT_STOP;
+        pb12EmitLoad(p, gen[0]);
+        pb12EmitByte(p, 0x99);                                              /* cdq */
+        pb12EmitByte(p, 0xF7);                                              /* idiv dword [gen2] */
+        pb12EmitCpuField(p, 7, gen[1]);
+        pb12EmitByte(p, 0x89); pb12EmitByte(p, 0xD0);                       /* mov eax, edx */
+        pb12EmitStore(p, PB12_CPU_OFF(acc));
+        break;
+
+    default:                /* Traps, halts and invalid opcodes */
+        return PB12_JIT_STOP;
+    }
+
+    return PB12_JIT_NEXT;
+}
+
+
+/**
+    Change what the code of the compiled blocks may be used for.  Code is
+    writable while a block is compiled and executable while blocks run,
+    but never both at once.
+
+    @param PB12_Jit *jit - JIT compiler.
+    @param int prot - PROT_READ | PROT_WRITE or PROT_READ | PROT_EXEC.
+
+    @return int - PB12_SUCCESS or PB12_FAILURE
+*/
+static int pb12ProtectJit(PB12_Jit *jit, int prot) {
+    if (mprotect(jit->code, jit->code_size, prot) != 0)
+        return PB12_FAILURE;
+    return PB12_SUCCESS;
+}
+
+
+/**
+    Compile the basic block that starts at an address.
+
+    @param PB12_Jit *jit - JIT compiler.
+    @param PB12_MEM *mem - Memory.
+    @param int addr - Address of the first instruction.
+
+    @return int - PB12_SUCCESS, or PB12_FAILURE if the first instruction
+                  cannot be compiled.
+*/
+static int pb12CompileJit(PB12_Jit *jit, PB12_MEM *mem, int addr) {
+    unsigned char *start;
+    unsigned char *p;
+    unsigned char *store_jump[PB12_JIT_MAX_BLOCK];  /* Ends of jumps to exits */
+    unsigned char *slice_jump[PB12_JIT_MAX_BLOCK];
+    PB12_Decoded *dec;
+    int mem_op[PB12_JIT_MAX_BLOCK];
+    int kind;
+    int count;
+    int target;
+    int j;
+
+    if (jit->code_size - jit->code_used < PB12_JIT_BLOCK_BYTES)
+        pb12FlushJit(jit, mem);
+    if (pb12ProtectJit(jit, PROT_READ | PROT_WRITE) == PB12_FAILURE)
+        return PB12_FAILURE;
+
+    start = jit->code + jit->code_used;
+    p = start;
+
+    pb12EmitByte(&p, 0x53);                                                 /* push rbx */
+    pb12EmitByte(&p, 0x55);                                                 /* push rbp */
+    pb12EmitByte(&p, 0x41); pb12EmitByte(&p, 0x54);                         /* push r12 */
+    pb12EmitByte(&p, 0x41); pb12EmitByte(&p, 0x55);                         /* push r13 */
+    pb12EmitByte(&p, 0x48); pb12EmitByte(&p, 0x83);                         /* sub rsp, 8 */
+    pb12EmitByte(&p, 0xEC); pb12EmitByte(&p, 8);
+    pb12EmitByte(&p, 0x48); pb12EmitByte(&p, 0x89); pb12EmitByte(&p, 0xFB); /* mov rbx, rdi */
+    pb12EmitByte(&p, 0x48); pb12EmitByte(&p, 0x89); pb12EmitByte(&p, 0xF5); /* mov rbp, rsi */
+    pb12EmitByte(&p, 0x44); pb12EmitByte(&p, 0x8B); pb12EmitByte(&p, 0xA5); /* mov r12d, [code_writes] */
+    pb12EmitImm(&p, (int)offsetof(PB12_MEM, code_writes), 4);
+    pb12EmitByte(&p, 0x44); pb12EmitByte(&p, 0x8B);                         /* mov r13d, [ic] */
+    pb12EmitCpuField(&p, 5, PB12_CPU_OFF(ic));
+
+    for (j=0; j<PB12_JIT_MAX_BLOCK; j++) {
+        store_jump[j] = NULL;
+        slice_jump[j] = NULL;
+    }
+
+    kind = PB12_JIT_STOP;
+    for (count=0; count < PB12_JIT_MAX_BLOCK && addr + count < mem->mem_size; count++) {
+        dec = pb12GetDecoded(mem, addr + count);
+        kind = pb12EmitInst(&p, mem, dec, &mem_op[count]);
+        if (kind == PB12_JIT_STOP || kind == PB12_JIT_BRANCH)
+            break;
+
+        /* Leave straight after a store that changed a compiled word. */
+        if (kind == PB12_JIT_STORE) {
+            pb12EmitByte(&p, 0x44); pb12EmitByte(&p, 0x3B); pb12EmitByte(&p, 0xA5); /* cmp r12d, [code_writes] */
+            pb12EmitImm(&p, (int)offsetof(PB12_MEM, code_writes), 4);
+            pb12EmitByte(&p, 0x0F); pb12EmitByte(&p, 0x85);                 /* jne exit */
+            pb12EmitImm(&p, 0, 4);
+            store_jump[count] = p;
+        }
+
+        /* Leave when the time slice has run out. */
+        pb12EmitByte(&p, 0x41); pb12EmitByte(&p, 0x81); pb12EmitByte(&p, 0xFD); /* cmp r13d, count+1 */
+        pb12EmitImm(&p, count + 1, 4);
+        pb12EmitByte(&p, 0x0F); pb12EmitByte(&p, 0x84);                     /* je exit */
+        pb12EmitImm(&p, 0, 4);
+        slice_jump[count] = p;
+    }
+
+    if (kind == PB12_JIT_BRANCH) {
+        dec = pb12GetDecoded(mem, addr + count);
+        target = dec->operand[0];
+        ++count;
+        if (dec->op == PB12_BRU) {
+            pb12EmitByte(&p, 0x66); pb12EmitByte(&p, 0xC7);                 /* mov word [pc], target */
+            pb12EmitCpuField(&p, 0, PB12_CPU_OFF(pc));
+            pb12EmitImm(&p, target - count, 2);
+        }
+        else {
+            pb12EmitByte(&p, 0x80);                                         /* cmp byte [psw], 'T'/'F' */
+            pb12EmitCpuField(&p, 7, PB12_CPU_OFF(psw));
+            pb12EmitByte(&p, dec->op == PB12_BRT ? 'T' : 'F');
+            pb12EmitByte(&p, 0x75); pb12EmitByte(&p, 9);                    /* jne +9 */
+            pb12EmitByte(&p, 0x66); pb12EmitByte(&p, 0xC7);                 /* mov word [pc], target */
+            pb12EmitCpuField(&p, 0, PB12_CPU_OFF(pc));
+            pb12EmitImm(&p, target - count, 2);
+        }
+        /* The exit adds count to pc, so the target was stored less count. */
+        pb12EmitExit(&p, mem, addr + count - 1, count, 1);
+    }
+    else if (count == 0) {
+        pb12ProtectJit(jit, PROT_READ | PROT_EXEC);
+        return PB12_FAILURE;
+    }
+    else {
+        pb12EmitExit(&p, mem, addr + count - 1, count, !mem_op[count-1]);
+    }
+
+    /* Exits after each instruction, for the jumps emitted above */
+    for (j=0; j<count; j++) {
+        if (!slice_jump[j])
+            continue;
+        pb12PatchJump(store_jump[j], p);
+        pb12PatchJump(slice_jump[j], p);
+        pb12EmitExit(&p, mem, addr + j, j + 1, !mem_op[j]);
+    }
+
+    /* Any write to these words has to throw the block away. */
+    for (j=0; j<count; j++)
+        mem->decoded[addr + j].flags |= PB12_DEC_JIT;
+
+    jit->code_used += (int)(p - start);
+    if (pb12ProtectJit(jit, PROT_READ | PROT_EXEC) == PB12_FAILURE)
+        return PB12_FAILURE;
+    jit->block[addr] = (int)(start - jit->code);
+    return PB12_SUCCESS;
+}
+
+#endif /* PB12_JIT_X86_64 */
+
+
+/**
+    Initialize the JIT compiler.  This fails when native code cannot be
+    generated for the machine the VM is running on.
+
+    @param PB12_Jit *jit - JIT compiler.
+    @param int mem_size - Size of memory in VM.
+
+    @return int - PB12_SUCCESS or PB12_FAILURE
+*/
+int pb12InitJit(PB12_Jit *jit, int mem_size) {
+    int i;
+
+    jit->code = NULL;
+    jit->code_size = 0;
+    jit->code_used = 0;
+    jit->code_writes = 0;
+    jit->block = (int*) malloc(mem_size * sizeof(int));
+    jit->counter = (unsigned short*) calloc(mem_size, sizeof(unsigned short));
+    if (jit->block == NULL || jit->counter == NULL)
+        return PB12_FAILURE;
+    for (i=0; i<mem_size; i++)
+        jit->block[i] = -1;
+
+#ifdef PB12_JIT_X86_64
+    jit->code = (unsigned char*) mmap(NULL, PB12_JIT_CODE_SIZE, PROT_READ | PROT_EXEC,
+                                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (jit->code == (unsigned char*) MAP_FAILED) {
+        jit->code = NULL;
+        return PB12_FAILURE;
+    }
+    jit->code_size = PB12_JIT_CODE_SIZE;
+    return PB12_SUCCESS;
+#else
+    return PB12_FAILURE;
+#endif
+}
+
+
+/**
+    Destroy the JIT compiler and all compiled blocks.
+
+    @param PB12_Jit *jit - JIT compiler.
+*/
+void pb12DestroyJit(PB12_Jit *jit) {
+#ifdef PB12_JIT_X86_64
+    if (jit->code)
+        munmap(jit->code, jit->code_size);
+#endif
+    jit->code = NULL;
+    free(jit->block);
+    jit->block = NULL;
+    free(jit->counter);
+    jit->counter = NULL;
+}
+
+
+/**
+    Throw away all compiled blocks and execution counters.
+
+    @param PB12_Jit *jit - JIT compiler.
+    @param PB12_MEM *mem - Memory the blocks were compiled from.
+*/
+void pb12FlushJit(PB12_Jit *jit, PB12_MEM *mem) {
+    int i;
+
+    for (i=0; i<mem->mem_size; i++) {
+        jit->block[i] = -1;
+        jit->counter[i] = 0;
+        mem->decoded[i].flags &= ~PB12_DEC_JIT;
+    }
+    jit->code_used = 0;
+    jit->code_writes = mem->code_writes;
+    mem->code_low = mem->mem_size;
+    mem->code_high = -1;
+}
+
+
+/**
+    Throw away the blocks that cover words changed since the JIT last
+    looked (between mem->code_low and mem->code_high), and start counting
+    executions of their addresses again.  Blocks anywhere else are kept.
+
+    @param PB12_Jit *jit - JIT compiler.
+    @param PB12_MEM *mem - Memory the blocks were compiled from.
+*/
+void pb12InvalidateJit(PB12_Jit *jit, PB12_MEM *mem) {
+    int i;
+
+    /* A block covers at most PB12_JIT_MAX_BLOCK words from where it starts. */
+    i = mem->code_low - (PB12_JIT_MAX_BLOCK - 1);
+    if (i < 0)
+        i = 0;
+    for (; i<=mem->code_high; i++) {
+        jit->block[i] = -1;
+        jit->counter[i] = 0;
+    }
+    jit->code_writes = mem->code_writes;
+    mem->code_low = mem->mem_size;
+    mem->code_high = -1;
+}
+
+
+/**
+    Runs the compiled block at pc, compiling it first if the word has become
+    hot.
+
+    @param PB12_Jit *jit - JIT compiler.
+    @param PB12_HW *hw - Hardware.
+
+    @return int - PB12_SUCCESS, or PB12_NOT_RUN if the interpreter has to
+                  execute the instruction at pc instead.
+*/
+int pb12RunJit(PB12_Jit *jit, PB12_HW *hw) {
+#ifdef PB12_JIT_X86_64
+    PB12_MEM *mem;
+    PB12_JitBlock run;
+    void *entry;
+    int addr;
+
+    mem = &hw->mem;
+
+    /* A compiled word has been written since the blocks were compiled. */
+    if (mem->code_writes != jit->code_writes)
+        pb12InvalidateJit(jit, mem);
+
+    addr = hw->cpu.bar + hw->cpu.pc;
+    if (addr < 0 || addr >= mem->mem_size)
+        return PB12_NOT_RUN;
+
+    if (jit->block[addr] < 0) {
+        if (jit->counter[addr] == PB12_JIT_NEVER ||
+            ++jit->counter[addr] < PB12_JIT_THRESHOLD)
+            return PB12_NOT_RUN;
+
+        if (pb12CompileJit(jit, mem, addr) == PB12_FAILURE) {
+            jit->counter[addr] = PB12_JIT_NEVER;
+            return PB12_NOT_RUN;
+        }
+    }
+
+    /* ISO C has no conversion from data to function pointers. */
+    entry = jit->code + jit->block[addr];
+    memcpy(&run, &entry, sizeof(run));
+    hw->retired = run(&hw->cpu, mem);
+    return PB12_SUCCESS;
+#else
+    (void)jit;
+    (void)hw;
+    return PB12_NOT_RUN;
+#endif
+}
@@ -0,0 +1,86 @@
+#ifndef PB12_JIT_H
+#define PB12_JIT_H
+
+#include "pb12_cpu.h"
+#include "pb12_mem.h"
+
+struct S_PB12_HW;
+
+#define PB12_JIT_THRESHOLD  16      /* Executions of a word before compiling */
+#define PB12_JIT_MAX_BLOCK  32      /* Most instructions in one block */
+#define PB12_JIT_CODE_SIZE  (256 * 1024)    /* Bytes of executable memory */
+
+/*
+    Hot basic blocks compiled to native code.  Everything is indexed by the
+    absolute address (bar + pc) of the first instruction of a block, so one
+    block serves every process that reaches that word.  The code is only
+    writable while a block is being compiled, and only executable the rest
+    of the time.
+*/
+typedef struct S_PB12_Jit {
+    unsigned char *code;        /* Executable memory for compiled blocks */
+    int code_size;              /* Bytes of executable memory */
+    int code_used;              /* Bytes already holding blocks */
+    int *block;                 /* Offset of the block at each address, or -1 */
+    unsigned short *counter;    /* Times each address has been executed */
+    unsigned int code_writes;   /* mem->code_writes when blocks were compiled */
+} PB12_Jit;
+
+
+/**
+    Initialize the JIT compiler.  This fails when native code cannot be
+    generated for the machine the VM is running on.
+
+    @param PB12_Jit *jit - JIT compiler.
+    @param int mem_size - Size of memory in VM.
+
+    @return int - PB12_SUCCESS or PB12_FAILURE
+*/
+int pb12InitJit(PB12_Jit *jit, int mem_size);
+
+
+/**
+    Destroy the JIT compiler and all compiled blocks.
+
+    @param PB12_Jit *jit - JIT compiler.
+*/
+void pb12DestroyJit(PB12_Jit *jit);
+
+
+/**
+    Throw away all compiled blocks and execution counters.
+
+    @param PB12_Jit *jit - JIT compiler.
+    @param PB12_MEM *mem - Memory the blocks were compiled from.
+*/
+void pb12FlushJit(PB12_Jit *jit, PB12_MEM *mem);
+
+
+/**
+    Throw away the blocks that cover words changed since the JIT last
+    looked (between mem->code_low and mem->code_high), and start counting
+    executions of their addresses again.  Blocks anywhere else are kept.
+
+    @param PB12_Jit *jit - JIT compiler.
+    @param PB12_MEM *mem - Memory the blocks were compiled from.
+*/
+void pb12InvalidateJit(PB12_Jit *jit, PB12_MEM *mem);
+
+
+/**
+    Runs the compiled block at pc, compiling it first if the word has become
+    hot.  A block runs until it ends with a branch or the word after it is an
+    instruction that cannot be compiled (traps, halts, invalid instructions),
+    and stops early when the time slice runs out or a store writes to a
+    compiled word.  The number of instructions executed is left in
+    hw->retired.
+
+    @param PB12_Jit *jit - JIT compiler.
+    @param struct S_PB12_HW *hw - Hardware.
+
+    @return int - PB12_SUCCESS, or PB12_NOT_RUN if the interpreter has to
+                  execute the instruction at pc instead.
+*/
+int pb12RunJit(PB12_Jit *jit, struct S_PB12_HW *hw);
+
+#endif /* PB12_JIT_H */
@@ -0,0 +1,619 @@
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "pb12.h"
+#include "pb12_loop.h"
+#include "pb12_cpu.h"
+#include "pb12_hw.h"
+#include "pb12_mem.h"
+#include "pb12_decode.h"
+#include "pb12_inst.h"
+
+/* Registers in PB12_Loop.var, in the order pb12GetLoopVars() reads them */
+#define PB12_LOOP_ACC   0
+#define PB12_LOOP_R0    1
+#define PB12_LOOP_P0    5
+
+
+/**
+    Read the registers a loop can change.
+
+    @param const PB12_CPU *cpu - CPU.
+    @param long *var - PB12_LOOP_VARS registers.
+*/
+static void pb12GetLoopVars(const PB12_CPU *cpu, long *var) {
+    var[0] = cpu->acc;
+    var[1] = cpu->r0;
+    var[2] = cpu->r1;
+    var[3] = cpu->r2;
+    var[4] = cpu->r3;
+    var[5] = cpu->p0;
+    var[6] = cpu->p1;
+    var[7] = cpu->p2;
+    var[8] = cpu->p3;
+}
+
+
+/**
+    Write back the registers a loop can change.
+
+    @param PB12_CPU *cpu - CPU.
+    @param const long *var - PB12_LOOP_VARS registers.
+*/
+static void pb12SetLoopVars(PB12_CPU *cpu, const long *var) {
+    cpu->acc = (int)var[0];
+    cpu->r0 = (int)var[1];
+    cpu->r1 = (int)var[2];
+    cpu->r2 = (int)var[3];
+    cpu->r3 = (int)var[4];
+    cpu->p0 = (short int)var[5];
+    cpu->p1 = (short int)var[6];
+    cpu->p2 = (short int)var[7];
+    cpu->p3 = (short int)var[8];
+}
+
+
+/**
+    Get the value of a general register while following an iteration.
+
+    @param PB12_Affine *var - Registers.
+    @param int number - Number of general register.
+
+    @return PB12_Affine* - The register, or NULL if there is no such register.
+*/
+static PB12_Affine *pb12LoopGen(PB12_Affine *var, int number) {
+    if (number < 0 || number > 3)
+        return NULL;
+    return &var[PB12_LOOP_R0 + number];
+}
+
+
+/**
+    Get the value of a pointer register while following an iteration.
+
+    @param PB12_Affine *var - Registers.
+    @param int number - Pointer number.
+
+    @return PB12_Affine* - The register, or NULL if there is no such register.
+*/
+static PB12_Affine *pb12LoopPtr(PB12_Affine *var, int number) {
+    if (number < 0 || number > 3)
+        return NULL;
+    return &var[PB12_LOOP_P0 + number];
+}
+
+
+/**
+    Add a check to a loop.
+
+    @param PB12_Loop *loop - Loop.
+    @param PB12_Affine a - Value checked.
+    @param int b - Constant subtracted from it.
+    @param long lo - Lowest difference allowed.
+    @param long hi - Highest difference allowed.
+    @param int want - 1 if the difference has to stay between lo and hi,
+                      -1 if it only sets psw.
+
+    @return int - Index of the check.
+*/
+static int pb12AddCheck(PB12_Loop *loop, PB12_Affine a, PB12_Affine b,
+                        long lo, long hi, int want) {
+    PB12_LoopCheck *check;
+
+    check = &loop->check[loop->checks];
+    check->a = a;
+    check->b = b;
+    check->lo = lo;
+    check->hi = hi;
+    check->want = want;
+    return loop->checks++;
+}
+
+
+/**
+    Follow one iteration of the loop that starts at pc, working out what it
+    does to every register.  Only straight runs of instructions that do not
+    read memory, trap or halt, and that end with a branch back to pc, are
+    loops that can be summarized.
+
+    @param PB12_MEM *mem - Memory.
+    @param int bar - Base address of the process.
+    @param int pc - First instruction of the loop.
+    @param PB12_Loop *loop - What one iteration does.
+
+    @return int - PB12_SUCCESS, or PB12_FAILURE if it is not such a loop.
+*/
+static int pb12FindLoop(PB12_MEM *mem, int bar, int pc, PB12_Loop *loop) {
+    PB12_Affine *var;
+    PB12_Affine *reg1;
+    PB12_Affine *reg2;
+    PB12_Affine imm;
+    PB12_Decoded *dec;
+    int cmp;
+    int taken;
+    int want;
+    int addr;
+    int i;
+
+    var = loop->var;
+    for (i=0; i<PB12_LOOP_VARS; i++) {
+        var[i].var = i;
+        var[i].off = 0;
+    }
+    loop->pc = pc;
+    loop->checks = 0;
+    loop->stores = 0;
+    loop->psw = -1;
+    imm.var = -1;
+    imm.off = 0;
+
+    for (i=0; i<PB12_LOOP_MAX_BODY; i++) {
+        addr = bar + pc + i;
+        if (addr < 0 || addr >= mem->mem_size)
+            return PB12_FAILURE;
+        dec = pb12GetDecoded(mem, addr);
+        imm.off = dec->value;
+
+        switch (dec->opcode) {
+        case PB12_LOD_PTR_I:
+            if (!(reg1 = pb12LoopPtr(var, dec->ptr[0])))
+                return PB12_FAILURE;
+            reg1->var = -1;
+            reg1->off = dec->operand[1];
+            break;
+
+        case PB12_ADD_PTR_I:
+            if (!(reg1 = pb12LoopPtr(var, dec->ptr[0])))
+                return PB12_FAILURE;
+            reg1->off += dec->operand[1];
+            imm.off = 0;
+            pb12AddCheck(loop, *reg1, imm, LONG_MIN, 99, 1);
+            break;
+
+        case PB12_SUB_PTR_I:
+            if (!(reg1 = pb12LoopPtr(var, dec->ptr[0])))
+                return PB12_FAILURE;
+            reg1->off -= dec->operand[1];
+            imm.off = 0;
+            pb12AddCheck(loop, *reg1, imm, 0, LONG_MAX, 1);
+            break;
+
+        case PB12_LOD_ACC_I:
+            var[PB12_LOOP_ACC] = imm;
+            break;
+
+        case PB12_STO_ACC_R:
+            if (!(reg1 = pb12LoopPtr(var, dec->ptr[0])))
+                return PB12_FAILURE;
+            loop->store[loop->stores].addr = *reg1;
+            loop->store[loop->stores++].value = var[PB12_LOOP_ACC];
+            break;
+
+        case PB12_STO_ACC_D:
+            if (dec->operand[0] >= mem->mem_size)
+                return PB12_FAILURE;
+            imm.off = dec->operand[0];
+            loop->store[loop->stores].addr = imm;
+            loop->store[loop->stores++].value = var[PB12_LOOP_ACC];
+            break;
+
+        case PB12_STO_REG_R:
+            if (!(reg1 = pb12LoopGen(var, dec->gen[0])) ||
+                !(reg2 = pb12LoopPtr(var, dec->ptr[1])))
+                return PB12_FAILURE;
+            loop->store[loop->stores].addr = *reg2;
+            loop->store[loop->stores++].value = *reg1;
+            break;
+
+        case PB12_STO_REG_D:
+            if (!(reg1 = pb12LoopGen(var, dec->gen[0])) ||
+                dec->operand[1] >= mem->mem_size)
+                return PB12_FAILURE;
+            imm.off = dec->operand[1];
+            loop->store[loop->stores].addr = imm;
+            loop->store[loop->stores++].value = *reg1;
+            break;
+
+        case PB12_LOD_REG_R0_I:
+            var[PB12_LOOP_R0] = imm;
+            break;
+
+        case PB12_TRA_REG_REG:
+            if (!(reg1 = pb12LoopGen(var, dec->gen[0])) ||
+                !(reg2 = pb12LoopGen(var, dec->gen[1])))
+                return PB12_FAILURE;
+            *reg1 = *reg2;
+            break;
+
+        case PB12_LOD_ACC_REG:
+            if (!(reg1 = pb12LoopGen(var, dec->gen[0])))
+                return PB12_FAILURE;
+            var[PB12_LOOP_ACC] = *reg1;
+            break;
+
+        case PB12_LOD_REG_ACC:
+            if (!(reg1 = pb12LoopGen(var, dec->gen[0])))
+                return PB12_FAILURE;
+            *reg1 = var[PB12_LOOP_ACC];
+            break;
+
+        case PB12_ADD_ACC_REG:
+        case PB12_SUB_ACC_REG:
+            /* Only a register that holds a constant keeps acc affine. */
+            if (!(reg1 = pb12LoopGen(var, dec->gen[0])) || reg1->var >= 0)
+                return PB12_FAILURE;
+            imm.off = reg1->off;
+            /* Fall through */
+        case PB12_ADD_ACC_I:
+        case PB12_SUB_ACC_I:
+            if (dec->opcode == PB12_ADD_ACC_I || dec->opcode == PB12_ADD_ACC_REG) {
+                var[PB12_LOOP_ACC].off += imm.off;
+                imm.off = 0;
+                pb12AddCheck(loop, var[PB12_LOOP_ACC], imm, LONG_MIN, 9999, 1);
+            }
+            else {
+                var[PB12_LOOP_ACC].off -= imm.off;
+                imm.off = 0;
+                pb12AddCheck(loop, var[PB12_LOOP_ACC], imm, 0, LONG_MAX, 1);
+            }
+            break;
+
+        case PB12_GRE_I:
+            loop->psw = pb12AddCheck(loop, var[PB12_LOOP_ACC], imm, 1, LONG_MAX, -1);
+            break;
+
+        case PB12_EQU_I:
+            loop->psw = pb12AddCheck(loop, var[PB12_LOOP_ACC], imm, 0, 0, -1);
+            break;
+
+        case PB12_LES_I:
+            loop->psw = pb12AddCheck(loop, var[PB12_LOOP_ACC], imm, LONG_MIN, -1, -1);
+            break;
+
+        case PB12_GRE_REG:
+        case PB12_EQU_REG:
+        case PB12_LES_REG:
+            if (!(reg1 = pb12LoopGen(var, dec->gen[0])))
+                return PB12_FAILURE;
+            if (dec->opcode == PB12_GRE_REG)
+                cmp = pb12AddCheck(loop, var[PB12_LOOP_ACC], *reg1, 1, LONG_MAX, -1);
+            else if (dec->opcode == PB12_EQU_REG)
+                cmp = pb12AddCheck(loop, var[PB12_LOOP_ACC], *reg1, 0, 0, -1);
+            else
+                cmp = pb12AddCheck(loop, var[PB12_LOOP_ACC], *reg1, LONG_MIN, -1, -1);
+            loop->psw = cmp;
+            break;
+
+        case PB12_BRT:
+        case PB12_BRF:
+            /* psw has to come from a comparison in the loop. */
+            if (loop->psw < 0)
+                return PB12_FAILURE;
+
+            /* Skipped iterations all go the way that stays in the loop. */
+            taken = dec->operand[0] == pc;
+            want = (dec->opcode == PB12_BRT) == taken;
+            if (loop->check[loop->psw].want == !want)
+                return PB12_FAILURE;
+            loop->check[loop->psw].want = want;
+
+            if (taken) {
+                loop->length = i + 1;
+                return PB12_SUCCESS;
+            }
+            break;
+
+        case PB12_BRU:
+            if (dec->operand[0] != pc)
+                return PB12_FAILURE;
+            loop->length = i + 1;
+            return PB12_SUCCESS;
+
+        default:
+            /* Loads, traps, modulo, halts and invalid instructions */
+            return PB12_FAILURE;
+        }
+    }
+
+    return PB12_FAILURE;
+}
+
+
+/**
+    Value of an affine value at the start of the skipped iterations.
+
+    @param PB12_Affine a - Value.
+    @param const long *var - Registers when the first iteration starts.
+
+    @return long - The value.
+*/
+static long pb12AffineValue(PB12_Affine a, const long *var) {
+    if (a.var < 0)
+        return a.off;
+    return var[a.var] + a.off;
+}
+
+
+/**
+    How much an affine value changes from one iteration to the next.
+
+    @param PB12_Affine a - Value.
+    @param const long *step - How much each register changes.
+
+    @return long - The change.
+*/
+static long pb12AffineStep(PB12_Affine a, const long *step) {
+    if (a.var < 0)
+        return 0;
+    return step[a.var];
+}
+
+
+/**
+    Most iterations for which a value that changes by step every iteration
+    stays between lo and hi.
+
+    @param long value - Value in the first iteration.
+    @param long step - Change every iteration.
+    @param long lo - Lowest value allowed.
+    @param long hi - Highest value allowed.
+    @param long count - Most iterations wanted.
+
+    @return long - Iterations, no more than count.
+*/
+static long pb12RangeLimit(long value, long step, long lo, long hi, long count) {
+    long limit;
+
+    if (value < lo || value > hi)
+        return 0;
+    if (step > 0 && hi != LONG_MAX) {
+        limit = (hi - value) / step + 1;
+        if (limit < count)
+            count = limit;
+    }
+    if (step < 0 && lo != LONG_MIN) {
+        limit = (value - lo) / -step + 1;
+        if (limit < count)
+            count = limit;
+    }
+    return count;
+}
+
+
+/**
+    Most iterations for which a check holds.
+
+    @param const PB12_LoopCheck *check - Check.
+    @param const long *var - Registers when the first iteration starts.
+    @param const long *step - How much each register changes.
+    @param long count - Most iterations wanted.
+
+    @return long - Iterations, no more than count.
+*/
+static long pb12CheckLimit(const PB12_LoopCheck *check, const long *var,
+                           const long *step, long count) {
+    long value;
+    long change;
+
+    value = pb12AffineValue(check->a, var) - pb12AffineValue(check->b, var);
+    change = pb12AffineStep(check->a, step) - pb12AffineStep(check->b, step);
+
+    if (check->want == 1)
+        return pb12RangeLimit(value, change, check->lo, check->hi, count);
+
+    /* The comparison has to stay false. */
+    if (check->lo == LONG_MIN)
+        return pb12RangeLimit(value, change, check->hi + 1, LONG_MAX, count);
+    if (check->hi == LONG_MAX)
+        return pb12RangeLimit(value, change, LONG_MIN, check->lo - 1, count);
+
+    /* Not equal: the difference is zero in at most one iteration. */
+    if (value == 0)
+        return 0;
+    if (change != 0 && value % change == 0 && -value / change > 0 &&
+        -value / change < count)
+        count = -value / change;
+    return count;
+}
+
+
+/**
+    Most iterations for which a store writes memory that exists and does
+    not write to the loop itself.
+
+    @param const PB12_LoopStore *store - Store.
+    @param const long *var - Registers when the first iteration starts.
+    @param const long *step - How much each register changes.
+    @param int bar - Base address of the process.
+    @param int first - Absolute address of the loop's first instruction.
+    @param int last - Absolute address of its last instruction.
+    @param int mem_size - Size of memory.
+    @param long count - Most iterations wanted.
+
+    @return long - Iterations, no more than count.
+*/
+static long pb12StoreLimit(const PB12_LoopStore *store, const long *var,
+                           const long *step, int bar, int first, int last,
+                           int mem_size, long count) {
+    long addr;
+    long change;
+
+    addr = bar + pb12AffineValue(store->addr, var);
+    change = pb12AffineStep(store->addr, step);
+    count = pb12RangeLimit(addr, change, 0, mem_size - 1, count);
+    if (addr < first)
+        return pb12RangeLimit(addr, change, LONG_MIN, first - 1, count);
+    if (addr > last)
+        return pb12RangeLimit(addr, change, last + 1, LONG_MAX, count);
+    return 0;
+}
+
+
+/**
+    Initialize the loop summarizer.
+
+    @param PB12_Loops *loops - Loop summarizer.
+    @param int mem_size - Size of memory in VM.
+
+    @return int - PB12_SUCCESS or PB12_FAILURE
+*/
+int pb12InitLoops(PB12_Loops *loops, int mem_size) {
+    loops->size = mem_size;
+    loops->code_writes = 0;
+    loops->loop = (PB12_Loop**) calloc(mem_size, sizeof(PB12_Loop*));
+    loops->tried = (unsigned char*) calloc(mem_size, sizeof(unsigned char));
+    if (loops->loop == NULL || loops->tried == NULL)
+        return PB12_FAILURE;
+    return PB12_SUCCESS;
+}
+
+
+/**
+    Destroy the loop summarizer and every loop it found.
+
+    @param PB12_Loops *loops - Loop summarizer.
+*/
+void pb12DestroyLoops(PB12_Loops *loops) {
+    int i;
+
+    if (loops->loop) {
+        for (i=0; i<loops->size; i++)
+            free(loops->loop[i]);
+    }
+    free(loops->loop);
+    loops->loop = NULL;
+    free(loops->tried);
+    loops->tried = NULL;
+}
+
+
+/**
+    Throw away every loop that was found.
+
+    @param PB12_Loops *loops - Loop summarizer.
+    @param PB12_MEM *mem - Memory the loops were found in.
+*/
+void pb12FlushLoops(PB12_Loops *loops, PB12_MEM *mem) {
+    int i;
+
+    for (i=0; i<loops->size; i++) {
+        free(loops->loop[i]);
+        loops->loop[i] = NULL;
+        loops->tried[i] = 0;
+        mem->decoded[i].flags &= ~PB12_DEC_LOOP;
+    }
+    loops->code_writes = mem->code_writes;
+}
+
+
+/**
+    If pc is at the start of a counting loop, do as many of its iterations
+    as possible all at once.
+
+    @param PB12_Loops *loops - Loop summarizer.
+    @param PB12_HW *hw - Hardware.
+
+    @return int - PB12_SUCCESS, or PB12_NOT_RUN if the interpreter has to
+                  execute the instruction at pc instead.
+*/
+int pb12RunLoop(PB12_Loops *loops, PB12_HW *hw) {
+    PB12_CPU *cpu;
+    PB12_MEM *mem;
+    PB12_Loop *loop;
+    PB12_LoopCheck *check;
+    long var[PB12_LOOP_VARS];
+    long step[PB12_LOOP_VARS];
+    long count;
+    long j;
+    long value;
+    int addr;
+    int last;
+    int i;
+
+    cpu = &hw->cpu;
+    mem = &hw->mem;
+
+    /* A word of a loop has been written since the loops were found. */
+    if (mem->code_writes != loops->code_writes)
+        pb12FlushLoops(loops, mem);
+
+    addr = cpu->bar + cpu->pc;
+    if (addr < 0 || addr >= mem->mem_size)
+        return PB12_NOT_RUN;
+
+    if (!loops->tried[addr]) {
+        loops->tried[addr] = 1;
+        loop = (PB12_Loop*) malloc(sizeof(PB12_Loop));
+        if (loop == NULL)
+            return PB12_NOT_RUN;
+        if (pb12FindLoop(mem, cpu->bar, cpu->pc, loop) == PB12_FAILURE) {
+            free(loop);
+            return PB12_NOT_RUN;
+        }
+        for (i=0; i<loop->length; i++)
+            mem->decoded[addr + i].flags |= PB12_DEC_LOOP;
+        loops->loop[addr] = loop;
+    }
+
+    /* Branch targets are relative, so the loop only works from its own bar. */
+    loop = loops->loop[addr];
+    if (loop == NULL || loop->pc != cpu->pc)
+        return PB12_NOT_RUN;
+
+    /*
+        Every register has to change by the same amount each iteration.
+        One that is set to a constant only does from the second iteration,
+        and one copied from another has to keep up with it.
+    */
+    pb12GetLoopVars(cpu, var);
+    for (i=0; i<PB12_LOOP_VARS; i++)
+        step[i] = pb12AffineValue(loop->var[i], var) - var[i];
+    for (i=0; i<PB12_LOOP_VARS; i++) {
+        if (step[i] != pb12AffineStep(loop->var[i], step))
+            return PB12_NOT_RUN;
+    }
+
+    /* Whole iterations left in the time slice, on the path that loops. */
+    count = cpu->ic / loop->length;
+    for (i=0; i<loop->checks && count > 0; i++) {
+        if (loop->check[i].want >= 0)
+            count = pb12CheckLimit(&loop->check[i], var, step, count);
+    }
+    last = addr + loop->length - 1;
+    for (i=0; i<loop->stores && count > 0; i++)
+        count = pb12StoreLimit(&loop->store[i], var, step, cpu->bar, addr,
+                               last, mem->mem_size, count);
+    if (count <= 0)
+        return PB12_NOT_RUN;
+
+    /* Stores still happen one at a time, in the order the loop makes them. */
+    for (j=0; j<count; j++) {
+        for (i=0; i<loop->stores; i++) {
+            pb12PutMemOp(cpu, mem,
+                (int)(pb12AffineValue(loop->store[i].addr, var) +
+                      j * pb12AffineStep(loop->store[i].addr, step)),
+                (int)(pb12AffineValue(loop->store[i].value, var) +
+                      j * pb12AffineStep(loop->store[i].value, step)));
+        }
+    }
+
+    /* psw is left by the last comparison of the last iteration. */
+    if (loop->psw >= 0) {
+        check = &loop->check[loop->psw];
+        value = pb12AffineValue(check->a, var) - pb12AffineValue(check->b, var) +
+                (count - 1) * (pb12AffineStep(check->a, step) -
+                               pb12AffineStep(check->b, step));
+        pb12SetPswCmp(cpu, value >= check->lo && value <= check->hi);
+    }
+
+    for (i=0; i<PB12_LOOP_VARS; i++)
+        var[i] += count * step[i];
+    pb12SetLoopVars(cpu, var);
+
+    /* The branch back to pc was the last word fetched. */
+    cpu->ic -= (int)(count * loop->length);
+    cpu->ear = last;
+    memcpy(cpu->ir, pb12GetDecoded(mem, last)->text, 6);
+    hw->retired = (int)(count * loop->length);
+    return PB12_SUCCESS;
+}
@@ -0,0 +1,119 @@
+#ifndef PB12_LOOP_H
+#define PB12_LOOP_H
+
+#include "pb12_cpu.h"
+#include "pb12_mem.h"
+
+struct S_PB12_HW;
+
+#define PB12_LOOP_MAX_BODY  32      /* Most instructions in one loop */
+#define PB12_LOOP_VARS      9       /* acc, r0-r3 and p0-p3 */
+
+/*
+    A value worked out while following one iteration of a loop: the value
+    a register had when the iteration started plus a constant, or just the
+    constant when var is -1.
+*/
+typedef struct S_PB12_Affine {
+    int var;                    /* Register the value depends on, or -1 */
+    int off;                    /* Constant added to it */
+} PB12_Affine;
+
+/*
+    Something that has to stay true in every iteration that is skipped: the
+    difference a - b is between lo and hi (the comparison is true) when want
+    is 1, or is not when want is 0.  Comparisons become checks, with want
+    set if a branch depends on them, and so do additions that must not wrap
+    around.
+*/
+typedef struct S_PB12_LoopCheck {
+    PB12_Affine a;
+    PB12_Affine b;
+    long lo;
+    long hi;
+    int want;                   /* 1 or 0 as above, -1 if nothing depends on it */
+} PB12_LoopCheck;
+
+/*
+    A store made in every iteration.  The address is relative to bar, as
+    in the instruction.
+*/
+typedef struct S_PB12_LoopStore {
+    PB12_Affine addr;
+    PB12_Affine value;
+} PB12_LoopStore;
+
+/*
+    What one iteration of a loop does.  The loop starts at pc and runs
+    straight through length words, the last of which branches back to pc.
+    Every register ends the iteration as an affine value of the registers
+    it started with, so as long as each one changes by the same amount
+    every time, many iterations can be done at once.
+*/
+typedef struct S_PB12_Loop {
+    int pc;                     /* Relative address of the first instruction */
+    int length;                 /* Instructions in one iteration */
+    PB12_Affine var[PB12_LOOP_VARS];    /* Registers after one iteration */
+    PB12_LoopCheck check[PB12_LOOP_MAX_BODY];
+    int checks;
+    PB12_LoopStore store[PB12_LOOP_MAX_BODY];
+    int stores;
+    int psw;                    /* Check that sets psw last, or -1 */
+} PB12_Loop;
+
+/*
+    Loops found in memory.  Like JIT blocks, they are indexed by the
+    absolute address (bar + pc) of their first instruction.
+*/
+typedef struct S_PB12_Loops {
+    PB12_Loop **loop;           /* Loop starting at each address, or NULL */
+    unsigned char *tried;       /* Nonzero once an address has been looked at */
+    int size;                   /* Addresses in loop and tried */
+    unsigned int code_writes;   /* mem->code_writes when loops were found */
+} PB12_Loops;
+
+
+/**
+    Initialize the loop summarizer.
+
+    @param PB12_Loops *loops - Loop summarizer.
+    @param int mem_size - Size of memory in VM.
+
+    @return int - PB12_SUCCESS or PB12_FAILURE
+*/
+int pb12InitLoops(PB12_Loops *loops, int mem_size);
+
+
+/**
+    Destroy the loop summarizer and every loop it found.
+
+    @param PB12_Loops *loops - Loop summarizer.
+*/
+void pb12DestroyLoops(PB12_Loops *loops);
+
+
+/**
+    Throw away every loop that was found.
+
+    @param PB12_Loops *loops - Loop summarizer.
+    @param PB12_MEM *mem - Memory the loops were found in.
+*/
+void pb12FlushLoops(PB12_Loops *loops, PB12_MEM *mem);
+
+
+/**
+    If pc is at the start of a counting loop, do as many of its iterations
+    as fit in what is left of the time slice and keep the loop on the same
+    path, all at once.  Registers, psw, ic and memory end up as if every
+    instruction had been interpreted, and the number of instructions is
+    left in hw->retired.
+
+    @param PB12_Loops *loops - Loop summarizer.
+    @param struct S_PB12_HW *hw - Hardware.
+
+    @return int - PB12_SUCCESS, or PB12_NOT_RUN if the interpreter has to
+                  execute the instruction at pc instead.
+*/
+int pb12RunLoop(PB12_Loops *loops, struct S_PB12_HW *hw);
+
+#endif /* PB12_LOOP_H */
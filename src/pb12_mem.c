@@ -3,19 +3,102 @@
 #include <string.h>
 #include "pb12.h"
 #include "pb12_mem.h"
+#include "pb12_inst.h"
+#include "pb12_strings.h"
+
+/* Dispatch index of the unchecked handler of each memory instruction */
+static const unsigned char pb12UncheckedOp[PB12_MAX_OPCODE] = {
+    0, 0, 0, 0,
+    PB12_DEC_OP_LOD_ACC_R_U, PB12_DEC_OP_LOD_ACC_D_U,
+    PB12_DEC_OP_STO_ACC_R_U, PB12_DEC_OP_STO_ACC_D_U,
+    PB12_DEC_OP_STO_REG_R_U, PB12_DEC_OP_STO_REG_D_U,
+    PB12_DEC_OP_LOD_REG_R_U, PB12_DEC_OP_LOD_REG_D_U,
+    0, 0, 0, 0, 0, 0, 0, 0,
+    PB12_DEC_OP_ADD_ACC_R_U, PB12_DEC_OP_ADD_ACC_D_U,
+    PB12_DEC_OP_SUB_ACC_R_U, PB12_DEC_OP_SUB_ACC_D_U,
+    PB12_DEC_OP_EQU_R_U, PB12_DEC_OP_LES_R_U, PB12_DEC_OP_GRE_R_U,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+
+/**
+    Set the last four characters of a word.
+
+    @param PB12_Word *word - Word.
+    @param const char *text - Four characters.
+*/
+static void pb12PutTail(PB12_Word *word, const char *text) {
+    int digits;
+    int i;
+
+    digits = 0;
+    for (i=0; i<4; i++) {
+        if (text[i] < '0' || text[i] > '9')
+            break;
+        digits = digits * 10 + (text[i] - '0');
+    }
+
+    if (i == 4) {
+        word->tail = (unsigned short)digits;
+    }
+    else {
+        word->tail = PB12_WORD_DIGITS;
+        memcpy(word->text, text, 4);
+    }
+}
+
 
 /**
-    Initialize memory.
+    Initialize memory.  Every word starts out as "ZZZZZZ".  Memory can have
+    as many words as an int can count, as long as malloc() can give room
+    for each word and its decoded instruction cache entry.  If it cannot,
+    whatever was allocated is freed again.
 
     @param PB12_MEM *mem - Memory.
     @param int memSize - Size of memory to allocate.
+    @param const PB12_Config *config - Settings of the VM.
+
+    @return int - PB12_SUCCESS or PB12_FAILURE
 */
-int pb12InitMem(PB12_MEM *mem, int memSize) {
+int pb12InitMem(PB12_MEM *mem, int memSize, const PB12_Config *config) {
+    int i;
+
+    mem->config = config;
+    mem->mmu = NULL;
     mem->mem_size = memSize;
-    mem->mem = (char (*)[6]) malloc(memSize * sizeof(char[6]));
+    mem->decoded = NULL;
+    mem->mem = NULL;
+    mem->proof_block = NULL;
+    mem->proof_writes = NULL;
+    if (memSize < 1 || (size_t)memSize > (size_t)-1 / sizeof(PB12_Decoded))
+        return PB12_FAILURE;
+
+    mem->mem = (PB12_Word*) malloc(memSize * sizeof(PB12_Word));
     if (mem->mem == NULL)
         return PB12_FAILURE;
-    memset(mem->mem, 'Z', memSize * sizeof(char[6]));
+
+    mem->mem[0].op[0] = 'Z';
+    mem->mem[0].op[1] = 'Z';
+    pb12PutTail(&mem->mem[0], "ZZZZ");
+    for (i=1; i<memSize; i++)
+        mem->mem[i] = mem->mem[0];
+
+    mem->decoded = (PB12_Decoded*) calloc(memSize, sizeof(PB12_Decoded));
+    if (mem->decoded == NULL) {
+        pb12DestroyMem(mem);
+        return PB12_FAILURE;
+    }
+    mem->code_writes = 0;
+    mem->code_low = memSize;
+    mem->code_high = -1;
+
+    mem->proof_block = (int*) calloc(memSize, sizeof(int));
+    mem->proof_writes = (unsigned int*) calloc(memSize, sizeof(unsigned int));
+    if (mem->proof_block == NULL || mem->proof_writes == NULL) {
+        pb12DestroyMem(mem);
+        return PB12_FAILURE;
+    }
+
     return PB12_SUCCESS;
 }
 
@@ -27,6 +110,12 @@ int pb12InitMem(PB12_MEM *mem, int memSize) {
 int pb12DestroyMem(PB12_MEM *mem) {
     free(mem->mem);
     mem->mem = NULL;
+    free(mem->decoded);
+    mem->decoded = NULL;
+    free(mem->proof_block);
+    mem->proof_block = NULL;
+    free(mem->proof_writes);
+    mem->proof_writes = NULL;
     return PB12_SUCCESS;
 }
 
@@ -69,6 +158,71 @@ void pb12IntToChars(char *dest, int length, int value) {
 }
 
 
+/**
+    Gets the six characters of the word at a memory address.
+
+    @param PB12_MEM *mem - Memory.
+    @param int address - Memory address.
+    @param char *dest - Where to write the six characters.
+*/
+void pb12GetMemWord(PB12_MEM *mem, int address, char *dest) {
+    PB12_Word *word;
+
+    word = &mem->mem[address];
+    dest[0] = word->op[0];
+    dest[1] = word->op[1];
+    if (word->tail < PB12_WORD_DIGITS)
+        pb12IntToChars(&dest[2], 4, word->tail);
+    else
+        memcpy(&dest[2], word->text, 4);
+}
+
+
+/**
+    Puts six characters at a memory address.  The decoded instruction cache
+    entry for the address is invalidated.
+
+    @param PB12_MEM *mem - Memory.
+    @param int address - Memory address.
+    @param const char *source - Six characters to write.
+*/
+void pb12PutMemWord(PB12_MEM *mem, int address, const char *source) {
+    mem->mem[address].op[0] = source[0];
+    mem->mem[address].op[1] = source[1];
+    pb12PutTail(&mem->mem[address], &source[2]);
+    pb12InvalidateDecoded(mem, address);
+}
+
+
+/**
+    Moves words from one address to another, as when memory is compacted.
+    The two ranges may overlap.  The decoded instruction cache entries of
+    the words written are invalidated.
+
+    @param PB12_MEM *mem - Memory.
+    @param int dest - Address to move the words to.
+    @param int source - Address of the first word to move.
+    @param int length - Number of words.
+*/
+void pb12MoveMem(PB12_MEM *mem, int dest, int source, int length) {
+    int i;
+
+    /* Words hold all six characters, so they are copied as they are. */
+    if (dest < source) {
+        for (i=0; i<length; i++) {
+            mem->mem[dest + i] = mem->mem[source + i];
+            pb12InvalidateDecoded(mem, dest + i);
+        }
+    }
+    else if (dest > source) {
+        for (i=length-1; i>=0; i--) {
+            mem->mem[dest + i] = mem->mem[source + i];
+            pb12InvalidateDecoded(mem, dest + i);
+        }
+    }
+}
+
+
 /**
     Get value at a memory address.
 
@@ -78,8 +232,15 @@ void pb12IntToChars(char *dest, int length, int value) {
     @return int  Value from memory address.
 */
 int pb12GetMemValue(PB12_MEM *mem, int address) {
+    int tail;
+
     /* TODO: Bounds Checking */
-    return pb12CharsToInt(&mem->mem[address][2], 4);
+    tail = mem->mem[address].tail;
+    if (tail >= PB12_WORD_DIGITS)
+        return pb12CharsToInt(mem->mem[address].text, 4);
+
+    /* The same weights pb12CharsToInt() gives each digit */
+    return tail % 100 + 200 * (tail / 100 % 10) + 3000 * (tail / 1000);
 }
 
 
@@ -91,8 +252,146 @@ int pb12GetMemValue(PB12_MEM *mem, int address) {
     @param int value  Value to place into memory.
 */
 void pb12PutMemValue(PB12_MEM *mem, int address, int value) {
+    char text[4];
+
     /* TODO: Bounds Checking */
-    pb12IntToChars(&mem->mem[address][2], 4, value);
+    if (value >= 0) {
+        mem->mem[address].tail = (unsigned short)(value % PB12_WORD_DIGITS);
+    }
+    else {
+        pb12IntToChars(text, 4, value);
+        pb12PutTail(&mem->mem[address], text);
+    }
+    pb12InvalidateDecoded(mem, address);
+}
+
+
+/**
+    Get the decoded form of the instruction at a memory address, decoding it
+    first if the cached entry is no longer valid.
+
+    @param PB12_MEM *mem - Memory.
+    @param int address - Memory address.
+
+    @return PB12_Decoded* - Decoded instruction.
+*/
+PB12_Decoded *pb12GetDecoded(PB12_MEM *mem, int address) {
+    PB12_Decoded *dec;
+    char word[6];
+
+    dec = &mem->decoded[address];
+    if (!(dec->flags & PB12_DEC_VALID)) {
+        pb12GetMemWord(mem, address, word);
+        pb12Decode(word, dec);
+    }
+
+    return dec;
+}
+
+
+/**
+    Invalidate the decoded instruction cache entry for a memory address.
+    Superinstructions that the word is part of are invalidated as well,
+    code_writes is counted up if the word was compiled to native code or is
+    part of a summarized loop, and the proof_writes of its block if a
+    load-time proof depended on it.
+
+    @param PB12_MEM *mem - Memory.
+    @param int address - Memory address that has been written.
+*/
+void pb12InvalidateDecoded(PB12_MEM *mem, int address) {
+    if (mem->decoded[address].flags & (PB12_DEC_JIT | PB12_DEC_NATIVE | PB12_DEC_LOOP))
+        pb12CountCodeWrite(mem, address);
+    if (mem->decoded[address].flags & PB12_DEC_VERIFIED)
+        ++mem->proof_writes[mem->proof_block[address]];
+    mem->decoded[address].flags = 0;
+
+    /* A superinstruction covers at most the two words before this one. */
+    if (address > 0)
+        mem->decoded[address-1].flags &= ~PB12_DEC_FUSED;
+    if (address > 1)
+        mem->decoded[address-2].flags &= ~PB12_DEC_FUSED;
+}
+
+
+/**
+    Count a change to a word that was compiled to native code or is part of
+    a summarized loop, so that whatever was made from it is thrown away.
+    The address is kept in code_low and code_high, so the JIT only has to
+    throw away the blocks around the words that changed.
+
+    @param PB12_MEM *mem - Memory.
+    @param int address - Memory address that has changed.
+*/
+void pb12CountCodeWrite(PB12_MEM *mem, int address) {
+    ++mem->code_writes;
+    if (address < mem->code_low)
+        mem->code_low = address;
+    if (address > mem->code_high)
+        mem->code_high = address;
+}
+
+
+/**
+    Work out whether the instruction at a memory address starts one of the
+    superinstructions the threaded engine executes in a single dispatch, and
+    record it in the decoded entry's xop.  Memory instructions proved to be
+    in range get the dispatch index of their unchecked handler instead.
+    The entry is left with the
+    PB12_DEC_FUSED flag set until it or one of the words it was fused with
+    is invalidated.
+
+    @param PB12_MEM *mem - Memory.
+    @param int address - Memory address.
+
+    @return PB12_Decoded* - Decoded instruction.
+*/
+PB12_Decoded *pb12FuseDecoded(PB12_MEM *mem, int address) {
+    PB12_Decoded *dec;
+    PB12_Decoded *next;
+    PB12_Decoded *last;
+
+    dec = pb12GetDecoded(mem, address);
+    dec->xop = dec->op;
+    dec->flags |= PB12_DEC_FUSED;
+
+    /* Memory instructions are never part of a superinstruction. */
+    if (dec->flags & PB12_DEC_UNCHECKED) {
+        dec->xop = pb12UncheckedOp[dec->op];
+        return dec;
+    }
+
+    if (address + 1 >= mem->mem_size)
+        return dec;
+    next = pb12GetDecoded(mem, address + 1);
+
+    /* Compare immediate then branch on the result */
+    if (next->op == PB12_BRT || next->op == PB12_BRF) {
+        if (dec->op == PB12_GRE_I)
+            dec->xop = PB12_DEC_OP_GRE_I_BR;
+        else if (dec->op == PB12_EQU_I)
+            dec->xop = PB12_DEC_OP_EQU_I_BR;
+        else if (dec->op == PB12_LES_I)
+            dec->xop = PB12_DEC_OP_LES_I_BR;
+        return dec;
+    }
+
+    if (address + 2 >= mem->mem_size)
+        return dec;
+
+    /* Load register into acc, add/subtract immediate, store acc to register */
+    if (dec->op == PB12_LOD_ACC_REG && dec->gen[0] >= 0 &&
+        (next->op == PB12_ADD_ACC_I || next->op == PB12_SUB_ACC_I)) {
+        last = pb12GetDecoded(mem, address + 2);
+        if (last->op == PB12_LOD_REG_ACC && last->gen[0] >= 0) {
+            if (next->op == PB12_ADD_ACC_I)
+                dec->xop = PB12_DEC_OP_REG_ADD_I;
+            else
+                dec->xop = PB12_DEC_OP_REG_SUB_I;
+        }
+    }
+
+    return dec;
 }
 
 
@@ -119,6 +418,7 @@ void pb12PrintMem(PB12_MEM *mem, int start, int length) {
     @param PB12_MEM *mem - Memory.
 */
 void pb12DumpMemory(PB12_MEM *mem) {
+    char word[6];
     int i;
 
     printf("MEMORY:\n");
@@ -128,7 +428,8 @@ void pb12DumpMemory(PB12_MEM *mem) {
             printf("  %03u:", i);
         }
 
-        printf(" %.6s", mem->mem[i]);
+        pb12GetMemWord(mem, i, word);
+        printf(" %.6s", word);
 
         if (i % 10 == 9) {
             printf("\n");
@@ -162,7 +463,7 @@ int pb12Load(PB12_MEM *mem, int addr, const char *filename) {
     while (fgets(buffer, 256, fp)) {
         /* Valid program has 6 chars per line (more than that is ignored) */
         if (strlen(buffer) >= 6) {
-            memcpy(mem->mem[line], buffer, 6);
+            pb12PutMemWord(mem, line, buffer);
             ++line;
         }
     }
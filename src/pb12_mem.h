@@ -1,19 +1,54 @@
 #ifndef PB12_MEM_H
 #define PB12_MEM_H
 
+#include "pb12.h"
+#include "pb12_decode.h"
+
+#define PB12_WORD_DIGITS    10000   /* Tails below this are four decimal digits */
+
+/*
+    A packed memory word.  Values written by programs always have four
+    decimal digits after the opcode, so those are kept as a number and never
+    have to be parsed again.  Any other four characters (register operands,
+    unused memory) are kept in the word as they are, so a word means the
+    same wherever it is copied.
+*/
+typedef struct S_PB12_Word {
+    char op[2];             /* First two characters */
+    unsigned short tail;    /* Last four characters as a number, or
+                               PB12_WORD_DIGITS if they are in text */
+    char text[4];           /* Last four characters if they are not all digits */
+} PB12_Word;
+
+struct S_PB12_Mmu;
+
 typedef struct S_PB12_MEM {
     int mem_size;    /* Memory size */
-    char (*mem)[6];   /* Memory */
+    PB12_Word *mem;   /* Memory */
+    PB12_Decoded *decoded;  /* Decoded instruction cache, one per word */
+    unsigned int code_writes;   /* Writes to words compiled or summarized */
+    int code_low;               /* Lowest and highest address counted in */
+    int code_high;              /*   code_writes since the JIT last looked */
+    int *proof_block;           /* Base address of the block each proved word is in */
+    unsigned int *proof_writes; /* Writes to proved words, by base address of their block */
+    struct S_PB12_Mmu *mmu;     /* Page tables addresses go through, or NULL */
+    const PB12_Config *config;  /* Settings of the VM */
 } PB12_MEM;
 
 
 /**
-    Initialize memory.
+    Initialize memory.  Every word starts out as "ZZZZZZ".  Memory can have
+    as many words as an int can count, as long as malloc() can give room
+    for each word and its decoded instruction cache entry.  If it cannot,
+    whatever was allocated is freed again.
 
     @param PB12_MEM *mem - Memory.
     @param int memSize - Size of memory to allocate.
+    @param const PB12_Config *config - Settings of the VM.
+
+    @return int - PB12_SUCCESS or PB12_FAILURE
 */
-int pb12InitMem(PB12_MEM *mem, int memSize);
+int pb12InitMem(PB12_MEM *mem, int memSize, const PB12_Config *config);
 
 
 /**
@@ -44,6 +79,40 @@ int pb12CharsToInt(const char *source, int length);
 void pb12IntToChars(char *dest, int length, int value);
 
 
+/**
+    Gets the six characters of the word at a memory address.
+
+    @param PB12_MEM *mem - Memory.
+    @param int address - Memory address.
+    @param char *dest - Where to write the six characters.
+*/
+void pb12GetMemWord(PB12_MEM *mem, int address, char *dest);
+
+
+/**
+    Puts six characters at a memory address.  The decoded instruction cache
+    entry for the address is invalidated.
+
+    @param PB12_MEM *mem - Memory.
+    @param int address - Memory address.
+    @param const char *source - Six characters to write.
+*/
+void pb12PutMemWord(PB12_MEM *mem, int address, const char *source);
+
+
+/**
+    Moves words from one address to another, as when memory is compacted.
+    The two ranges may overlap.  The decoded instruction cache entries of
+    the words written are invalidated.
+
+    @param PB12_MEM *mem - Memory.
+    @param int dest - Address to move the words to.
+    @param int source - Address of the first word to move.
+    @param int length - Number of words.
+*/
+void pb12MoveMem(PB12_MEM *mem, int dest, int source, int length);
+
+
 /**
     Get value at a memory address.
 
@@ -65,6 +134,60 @@ int pb12GetMemValue(PB12_MEM *mem, int address);
 void pb12PutMemValue(PB12_MEM *mem, int address, int value);
 
 
+/**
+    Get the decoded form of the instruction at a memory address, decoding it
+    first if the cached entry is no longer valid.
+
+    @param PB12_MEM *mem - Memory.
+    @param int address - Memory address.
+
+    @return PB12_Decoded* - Decoded instruction.
+*/
+PB12_Decoded *pb12GetDecoded(PB12_MEM *mem, int address);
+
+
+/**
+    Invalidate the decoded instruction cache entry for a memory address.
+    Superinstructions that the word is part of are invalidated as well,
+    code_writes is counted up if the word was compiled to native code or is
+    part of a summarized loop, and the proof_writes of its block if a
+    load-time proof depended on it.
+
+    @param PB12_MEM *mem - Memory.
+    @param int address - Memory address that has been written.
+*/
+void pb12InvalidateDecoded(PB12_MEM *mem, int address);
+
+
+/**
+    Count a change to a word that was compiled to native code or is part of
+    a summarized loop, so that whatever was made from it is thrown away.
+    The address is kept in code_low and code_high, so the JIT only has to
+    throw away the blocks around the words that changed.
+
+    @param PB12_MEM *mem - Memory.
+    @param int address - Memory address that has changed.
+*/
+void pb12CountCodeWrite(PB12_MEM *mem, int address);
+
+
+/**
+    Work out whether the instruction at a memory address starts one of the
+    superinstructions the threaded engine executes in a single dispatch, and
+    record it in the decoded entry's xop.  Memory instructions proved to be
+    in range get the dispatch index of their unchecked handler instead.
+    The entry is left with the
+    PB12_DEC_FUSED flag set until it or one of the words it was fused with
+    is invalidated.
+
+    @param PB12_MEM *mem - Memory.
+    @param int address - Memory address.
+
+    @return PB12_Decoded* - Decoded instruction.
+*/
+PB12_Decoded *pb12FuseDecoded(PB12_MEM *mem, int address);
+
+
 /**
     Prints a range of memory values to the console.
 
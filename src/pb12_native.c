@@ -0,0 +1,933 @@
+#if defined(__unix__) || defined(__APPLE__)
+    #define PB12_NATIVE_DLOPEN
+    #define _POSIX_C_SOURCE 200809L     /* dlopen(), mkdir(), mkstemp(), fork() and opendir() are POSIX */
+    #include <sys/types.h>
+    #include <sys/stat.h>
+    #include <sys/wait.h>
+    #include <dirent.h>
+    #include <unistd.h>
+    #include <dlfcn.h>
+#endif
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include "pb12.h"
+#include "pb12_native.h"
+#include "pb12_cpu.h"
+#include "pb12_hw.h"
+#include "pb12_mem.h"
+#include "pb12_decode.h"
+#include "pb12_inst.h"
+#include "pb12_strings.h"
+
+#define PB12_STR(x) #x
+#define PB12_XSTR(x) PB12_STR(x)
+
+/*
+    Fingerprint of the PB12_CPU layout.  Translations declare their own copy
+    of the structure, and are only used if its fingerprint matches.  It is
+    in two halves to keep each expanded string short enough for ANSI C.
+*/
+#define PB12_NATIVE_LAYOUT_A(T) \
+    ((unsigned long)sizeof(T) + 1000UL * (offsetof(T, p0) + 3UL * offsetof(T, pc) + \
+     5UL * offsetof(T, sp) + 7UL * offsetof(T, acc) + 11UL * offsetof(T, r0)))
+#define PB12_NATIVE_LAYOUT_B(T) \
+    (1000UL * (13UL * offsetof(T, psw) + 17UL * offsetof(T, ir) + 19UL * offsetof(T, ic) + \
+     23UL * offsetof(T, bar) + 29UL * offsetof(T, lr) + 31UL * offsetof(T, ear)))
+#define PB12_NATIVE_LAYOUT(T) (PB12_NATIVE_LAYOUT_A(T) + PB12_NATIVE_LAYOUT_B(T))
+
+/* The CPU structure as translations see it */
+static const char pb12NativeCpuDecl[] =
+    "typedef struct S_PB12_CPU {\n"
+    "    short int p0, p1, p2, p3;\n"
+    "    short int pc;\n"
+    "    short int sp;\n"
+    "    int acc;\n"
+    "    int r0, r1, r2, r3;\n"
+    "    char psw[2];\n"
+    "    char ir[6];\n"
+    "    int ic;\n"
+    "    int bar;\n"
+    "    int lr;\n"
+    "    int ear;\n"
+    "} PB12_CPU;\n";
+
+static const char *pb12NativePtr[] = { "p0", "p1", "p2", "p3" };
+static const char *pb12NativeGen[] = { "r0", "r1", "r2", "r3" };
+
+
+#ifdef PB12_NATIVE_DLOPEN
+
+/**
+    Reads memory for a translation, see pb12GetMemOp().
+
+    @param PB12_CPU *cpu - CPU.
+    @param void *mem - Memory in hardware.
+    @param int addr - Relative address to read memory from.
+
+    @return int - Value in memory.
+*/
+static int pb12NativeGet(PB12_CPU *cpu, void *mem, int addr) {
+    return pb12GetMemOp(cpu, (PB12_MEM*) mem, addr);
+}
+
+
+/**
+    Writes memory for a translation, see pb12PutMemOp().
+
+    @param PB12_CPU *cpu - CPU.
+    @param void *mem - Memory in hardware.
+    @param int addr - Relative address to write memory to.
+    @param int value - Value to write to memory.
+*/
+static void pb12NativePut(PB12_CPU *cpu, void *mem, int addr, int value) {
+    pb12PutMemOp(cpu, (PB12_MEM*) mem, addr, value);
+}
+
+
+/**
+    Adds bytes to the two 32 bit hashes (FNV-1a and djb2) that name a
+    translation in the cache.
+
+    @param unsigned long *hash - The two hashes.
+    @param const char *data - Bytes to add.
+    @param size_t size - Number of bytes.
+*/
+static void pb12NativeHash(unsigned long *hash, const char *data, size_t size) {
+    size_t i;
+
+    for (i=0; i<size; i++) {
+        hash[0] = ((hash[0] ^ (unsigned char)data[i]) * 16777619UL) & 0xFFFFFFFFUL;
+        hash[1] = (hash[1] * 33UL + (unsigned char)data[i]) & 0xFFFFFFFFUL;
+    }
+}
+
+
+/**
+    Reads the words of a program file the same way pb12Load() does, and
+    works out the name of its translation.
+
+    @param const char *filename - Path to program file.
+    @param int mem_size - Size of memory in VM.
+    @param int *length - Set to the number of words.
+    @param char *name - Set to the name of the translation, 17 chars.
+
+    @return char (*)[6] - Words of the program (to be freed), or NULL.
+*/
+static char (*pb12NativeRead(const char *filename, int mem_size, int *length, char *name))[6] {
+    char buffer[256];
+    char (*words)[6];
+    char (*more)[6];
+    unsigned long hash[2];
+    int size;
+    FILE *fp;
+
+    fp = fopen(filename, "rt");
+    if (!fp)
+        return NULL;
+
+    /* Translations also depend on the translator and the VM they run in. */
+    hash[0] = 2166136261UL;
+    hash[1] = 5381UL;
+    sprintf(buffer, "%d %lu %d\n", PB12_NATIVE_VERSION,
+            (unsigned long)PB12_NATIVE_LAYOUT(PB12_CPU), mem_size);
+    pb12NativeHash(hash, buffer, strlen(buffer));
+
+    size = 64;
+    words = (char (*)[6]) malloc(size * sizeof(char[6]));
+    *length = 0;
+
+    while (words && fgets(buffer, 256, fp)) {
+        pb12NativeHash(hash, buffer, strlen(buffer));
+        if (strlen(buffer) >= 6) {
+            if (*length == size) {
+                size *= 2;
+                more = (char (*)[6]) realloc(words, size * sizeof(char[6]));
+                if (!more) {
+                    free(words);
+                    words = NULL;
+                    break;
+                }
+                words = more;
+            }
+            memcpy(words[*length], buffer, 6);
+            ++*length;
+        }
+    }
+
+    fclose(fp);
+    sprintf(name, "%08lx%08lx", hash[0], hash[1]);
+    return words;
+}
+
+
+/**
+    Writes the C translation of one instruction, a case of the switch on pc.
+    Instructions that can trap, halt or fail are left to the interpreter.
+
+    @param FILE *fp - Translation being written.
+    @param const char *word - Instruction word.
+    @param int k - Relative address of the instruction.
+    @param int mem_size - Size of memory in VM.
+*/
+static void pb12WriteNativeInst(FILE *fp, const char *word, int k, int mem_size) {
+    PB12_Decoded dec;
+    char body[256];
+    const char *ptr[2];
+    const char *gen[2];
+    char comment[7];
+    int mem_op;
+    int store;
+    int n;
+
+    pb12Decode(word, &dec);
+    for (n=0; n<2; n++) {
+        ptr[n] = dec.ptr[n] < 0 ? NULL : pb12NativePtr[(int)dec.ptr[n]];
+        gen[n] = dec.gen[n] < 0 ? NULL : pb12NativeGen[(int)dec.gen[n]];
+    }
+
+    for (n=0; n<6; n++)
+        comment[n] = (word[n] >= ' ' && word[n] <= '~' && word[n] != '*' && word[n] != '/') ?
+                     word[n] : '?';
+    comment[6] = '\0';
+    fprintf(fp, "        case %d:    /* %s */\n", k, comment);
+
+    body[0] = '\0';
+    mem_op = 0;
+    store = 0;
+
+    switch (dec.op) {
+    case PB12_LOD_PTR_I:    /* 0 - Load Pointer Immediate */
+        if (ptr[0])
+            sprintf(body, "%s = %d;", ptr[0], dec.operand[1]);
+        break;
+
+    case PB12_ADD_PTR_I:    /* 1 - Add to Pointer Immediate */
+        if (ptr[0])
+            sprintf(body, "%s += %d; if (%s > 99) %s -= 100;",
+                    ptr[0], dec.operand[1], ptr[0], ptr[0]);
+        break;
+
+    case PB12_SUB_PTR_I:    /* 2 - Subtract from Pointer Immediate */
+        if (ptr[0])
+            sprintf(body, "%s -= %d; if (%s < 0) %s += 100;",
+                    ptr[0], dec.operand[1], ptr[0], ptr[0]);
+        break;
+
+    case PB12_LOD_ACC_I:    /* 3 - Load Accumulator Immediate */
+        sprintf(body, "acc = %d;", dec.value);
+        break;
+
+    case PB12_LOD_ACC_R:    /* 4 - Load Accumulator Register Addressing */
+        if (ptr[0])
+            sprintf(body, "acc = get(cpu, mem, %s);", ptr[0]);
+        mem_op = 1;
+        break;
+
+    case PB12_LOD_ACC_D:    /* 5 - Load Accumulator Direct Addressing */
+        if (dec.operand[0] < mem_size)
+            sprintf(body, "acc = get(cpu, mem, %d);", dec.operand[0]);
+        mem_op = 1;
+        break;
+
+    case PB12_STO_ACC_R:    /* 6 - Store Accumulator Register Addressing */
+        if (ptr[0])
+            sprintf(body, "put(cpu, mem, %s, acc);", ptr[0]);
+        mem_op = store = 1;
+        break;
+
+    case PB12_STO_ACC_D:    /* 7 - Store Accumulator Direct Addressing */
+        if (dec.operand[0] < mem_size)
+            sprintf(body, "put(cpu, mem, %d, acc);", dec.operand[0]);
+        mem_op = store = 1;
+        break;
+
+    case PB12_STO_REG_R:    /* 8 - Store Register to Memory: Register Addressing */
+        if (gen[0] && ptr[1])
+            sprintf(body, "put(cpu, mem, %s, %s);", ptr[1], gen[0]);
+        mem_op = store = 1;
+        break;
+
+    case PB12_STO_REG_D:    /* 9 - Store Register to Memory: Direct Addressing */
+        if (gen[0] && dec.operand[1] < mem_size)
+            sprintf(body, "put(cpu, mem, %d, %s);", dec.operand[1], gen[0]);
+        mem_op = store = 1;
+        break;
+
+    case PB12_LOD_REG_R:    /* 10 - Load Register from Memory: Register Addressing */
+        if (gen[0] && ptr[1])
+            sprintf(body, "%s = get(cpu, mem, %s);", gen[0], ptr[1]);
+        mem_op = 1;
+        break;
+
+    case PB12_LOD_REG_D:    /* 11 - Load Register from Memory: Direct Addressing */
+        if (gen[0] && dec.operand[1] < mem_size)
+            sprintf(body, "%s = get(cpu, mem, %d);", gen[0], dec.operand[1]);
+        mem_op = 1;
+        break;
+
+    case PB12_LOD_REG_R0_I: /* 12 - Load Register R0 Immediate */
+        sprintf(body, "r0 = %d;", dec.value);
+        break;
+
+    case PB12_TRA_REG_REG:  /* 13 - Register to Register Transfer */
+        if (gen[0] && gen[1])
+            sprintf(body, "%s = %s;", gen[0], gen[1]);
+        break;
+
+    case PB12_LOD_ACC_REG:  /* 14 - Load Accumulator from Register */
+        if (gen[0])
+            sprintf(body, "acc = %s;", gen[0]);
+        break;
+
+    case PB12_LOD_REG_ACC:  /* 15 - Load Register from Accumulator */
+        if (gen[0])
+            sprintf(body, "%s = acc;", gen[0]);
+        break;
+
+    case PB12_ADD_ACC_I:    /* 16 - Add Accumulator Immediate */
+        sprintf(body, "acc += %d; if (acc > 9999) acc -= 10000;", dec.value);
+        break;
+
+    case PB12_SUB_ACC_I:    /* 17 - Subtract Accumulator Immediate */
+        sprintf(body, "acc -= %d; if (acc < 0) acc += 10000;", dec.value);
+        break;
+
+    case PB12_ADD_ACC_REG:  /* 18 - Add contents of Register from Accumulator */
+        if (gen[0])
+            sprintf(body, "acc += %s; if (acc > 9999) acc -= 10000;", gen[0]);
+        break;
+
+    case PB12_SUB_ACC_REG:  /* 19 - Subtract contents of Register from Accumulator */
+        if (gen[0])
+            sprintf(body, "acc -= %s; if (acc < 0) acc += 10000;", gen[0]);
+        break;
+
+    case PB12_ADD_ACC_R:    /* 20 - Add Accumulator Register Addressing */
+        /* Wraps around by 9999, as the interpreter does. */
+        if (ptr[0])
+            sprintf(body, "acc += get(cpu, mem, %s); if (acc > 9999) acc -= 9999;", ptr[0]);
+        mem_op = 1;
+        break;
+
+    case PB12_ADD_ACC_D:    /* 21 - Add Accumulator Direct Addressing */
+        if (dec.operand[0] < mem_size)
+            sprintf(body, "acc += get(cpu, mem, %d); if (acc > 9999) acc -= 10000;",
+                    dec.operand[0]);
+        mem_op = 1;
+        break;
+
+    case PB12_SUB_ACC_R:    /* 22 - Subtract from Accumulator Register Addressing */
+        if (ptr[0])
+            sprintf(body, "acc -= get(cpu, mem, %s); if (acc < 0) acc += 10000;", ptr[0]);
+        mem_op = 1;
+        break;
+
+    case PB12_SUB_ACC_D:    /* 23 - Subtract from Accumulator Direct Addressing */
+        if (dec.operand[0] < mem_size)
+            sprintf(body, "acc -= get(cpu, mem, %d); if (acc < 0) acc += 10000;",
+                    dec.operand[0]);
+        mem_op = 1;
+        break;
+
+    case PB12_EQU_R:        /* 24 - Compare Equal Register Addressing */
+    case PB12_LES_R:        /* 25 - Compare Less Register Addressing */
+    case PB12_GRE_R:        /* 26 - Compare Greater Register Addressing */
+        if (ptr[0])
+            sprintf(body, "psw = acc %s get(cpu, mem, %s) ? 'T' : 'F';",
+                    dec.op == PB12_EQU_R ? "==" : dec.op == PB12_LES_R ? "<" : ">",
+                    ptr[0]);
+        mem_op = 1;
+        break;
+
+    case PB12_GRE_I:        /* 27 - Compare Greater Immediate */
+    case PB12_EQU_I:        /* 28 - Compare Equal Immediate */
+    case PB12_LES_I:        /* 29 - Compare Less Immediate */
+        sprintf(body, "psw = acc %s %d ? 'T' : 'F';",
+                dec.op == PB12_EQU_I ? "==" : dec.op == PB12_LES_I ? "<" : ">",
+                dec.value);
+        break;
+
+    case PB12_EQU_REG:      /* 30 - Compare Register Equal */
+    case PB12_LES_REG:      /* 31 - Compare Register Less */
+    case PB12_GRE_REG:      /* 32 - Compare Register Greater */
+        if (gen[0])
+            sprintf(body, "psw = acc %s %s ? 'T' : 'F';",
+                    dec.op == PB12_EQU_REG ? "==" : dec.op == PB12_LES_REG ? "<" : ">",
+                    gen[0]);
+        break;
+
+    case PB12_BRT:          /* 33 - Branch Condition True */
+    case PB12_BRF:          /* 34 - Branch Condition False */
+    case PB12_BRU:          /* 35 - Branch Unconditional */
+        fprintf(fp, "            --ic; ++n; last = %d; last_mem = 0;\n", k);
+        if (dec.op == PB12_BRU)
+            fprintf(fp, "            pc = %d;\n", dec.operand[0]);
+        else
+            fprintf(fp, "            pc = psw == '%c' ? %d : %d;\n",
+                    dec.op == PB12_BRT ? 'T' : 'F', dec.operand[0], k + 1);
+        fprintf(fp, "            if (ic == 0) goto out;\n");
+        fprintf(fp, "            break;\n");
+        return;
+
+    case PB12_MOD:          /* 37 - Modulo Operator */
+        if (gen[0] && gen[1])
+            sprintf(body, "acc = %s %% %s;", gen[0], gen[1]);
+        break;
+
+    default:                /* Traps, halts and invalid opcodes */
+        break;
+    }
+
+    if (!body[0]) {
+        fprintf(fp, "            goto out;\n");
+        return;
+    }
+
+    fprintf(fp, "            --ic; ++n; last = %d; last_mem = %d;\n", k, mem_op);
+    fprintf(fp, "            %s\n", body);
+    fprintf(fp, "            pc = %d;\n", k + 1);
+    if (store)
+        fprintf(fp, "            if (*code_writes != writes) goto out;\n");
+    fprintf(fp, "            if (ic == 0) goto out;\n");
+}
+
+
+/**
+    Writes the C translation of a program.
+
+    @param FILE *fp - File to write to.
+    @param char (*words)[6] - Words of the program.
+    @param int length - Number of words.
+    @param int mem_size - Size of memory in VM.
+*/
+static void pb12WriteNative(FILE *fp, char (*words)[6], int length, int mem_size) {
+    int i;
+    int j;
+
+    fprintf(fp, "/* PBrain12 program translated by pbrain12.  Generated file, do not edit. */\n\n");
+    fprintf(fp, "#include <stddef.h>\n#include <string.h>\n\n");
+    fprintf(fp, "%s\n", pb12NativeCpuDecl);
+    fprintf(fp, "const int pb12NativeVersion = %d;\n", PB12_NATIVE_VERSION);
+    fprintf(fp, "const unsigned long pb12NativeLayout =\n    %s +\n    %s;\n",
+            PB12_XSTR(PB12_NATIVE_LAYOUT_A(PB12_CPU)),
+            PB12_XSTR(PB12_NATIVE_LAYOUT_B(PB12_CPU)));
+    fprintf(fp, "const int pb12NativeLength = %d;\n", length);
+    fprintf(fp, "const char pb12NativeCode[%d][6] = {\n", length);
+    for (i=0; i<length; i++) {
+        fprintf(fp, "    {");
+        for (j=0; j<6; j++)
+            fprintf(fp, "%d%s", words[i][j], j < 5 ? ", " : "");
+        fprintf(fp, "}%s\n", i < length - 1 ? "," : "");
+    }
+    fprintf(fp, "};\n\n");
+
+    fprintf(fp, "int pb12NativeRun(PB12_CPU *cpu, void *mem, const unsigned int *code_writes,\n"
+                "                  int (*get)(PB12_CPU *, void *, int),\n"
+                "                  void (*put)(PB12_CPU *, void *, int, int)) {\n"
+                "    short int p0 = cpu->p0, p1 = cpu->p1, p2 = cpu->p2, p3 = cpu->p3;\n"
+                "    int r0 = cpu->r0, r1 = cpu->r1, r2 = cpu->r2, r3 = cpu->r3;\n"
+                "    int acc = cpu->acc;\n"
+                "    char psw = cpu->psw[0];\n"
+                "    int ic = cpu->ic;\n"
+                "    int pc = cpu->pc;\n"
+                "    unsigned int writes = *code_writes;\n");
+    fprintf(fp, "    int n = 0;\n"
+                "    int last = 0;\n"
+                "    int last_mem = 0;\n\n"
+                "    for (;;) {\n"
+                "        switch (pc) {\n");
+
+    for (i=0; i<length; i++)
+        pb12WriteNativeInst(fp, words[i], i, mem_size);
+
+    fprintf(fp, "        default:\n"
+                "            goto out;\n"
+                "        }\n"
+                "    }\n\n"
+                "out:\n"
+                "    cpu->p0 = p0; cpu->p1 = p1; cpu->p2 = p2; cpu->p3 = p3;\n"
+                "    cpu->r0 = r0; cpu->r1 = r1; cpu->r2 = r2; cpu->r3 = r3;\n"
+                "    cpu->acc = acc;\n");
+    fprintf(fp, "    cpu->psw[0] = psw;\n"
+                "    cpu->ic = ic;\n"
+                "    cpu->pc = (short int)pc;\n"
+                "    if (n > 0) {\n"
+                "        memcpy(cpu->ir, pb12NativeCode[last], 6);\n"
+                "        if (!last_mem)\n"
+                "            cpu->ear = cpu->bar + last;\n"
+                "    }\n"
+                "    return n;\n"
+                "}\n");
+}
+
+
+/**
+    Loads a translation from the cache, checking that it was made from the
+    same program by a compatible translator.
+
+    @param PB12_NativeProg *prog - Translation to fill in.
+    @param const char *path - Path of the shared object.
+    @param char (*words)[6] - Words of the program.
+    @param int length - Number of words.
+
+    @return int - PB12_SUCCESS or PB12_FAILURE
+*/
+static int pb12OpenNative(PB12_NativeProg *prog, const char *path, char (*words)[6], int length) {
+    const int *version;
+    const unsigned long *layout;
+    const int *count;
+    void *run;
+
+    prog->handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+    if (!prog->handle)
+        return PB12_FAILURE;
+
+    version = (const int*) dlsym(prog->handle, "pb12NativeVersion");
+    layout = (const unsigned long*) dlsym(prog->handle, "pb12NativeLayout");
+    count = (const int*) dlsym(prog->handle, "pb12NativeLength");
+    prog->code = (const char (*)[6]) dlsym(prog->handle, "pb12NativeCode");
+    run = dlsym(prog->handle, "pb12NativeRun");
+
+    if (!version || !layout || !count || !prog->code || !run ||
+        *version != PB12_NATIVE_VERSION ||
+        *layout != (unsigned long)PB12_NATIVE_LAYOUT(PB12_CPU) ||
+        *count != length || memcmp(prog->code, words, length * sizeof(char[6])) != 0) {
+        dlclose(prog->handle);
+        prog->handle = NULL;
+        return PB12_FAILURE;
+    }
+
+    /* ISO C has no conversion from data to function pointers. */
+    memcpy(&prog->run, &run, sizeof(prog->run));
+    prog->length = length;
+    prog->state = PB12_NATIVE_LOADED;
+    return PB12_SUCCESS;
+}
+
+
+/**
+    Checks that the code of a process in memory is still the code it was
+    translated from, and marks its words so that writes to them are seen.
+
+    @param PB12_NativeProg *prog - Translation.
+    @param PB12_MEM *mem - Memory.
+    @param int bar - Base address of the process.
+*/
+static void pb12ActivateNative(PB12_NativeProg *prog, PB12_MEM *mem, int bar) {
+    int i;
+
+    prog->bar = bar;
+    if (bar < 0 || bar + prog->length > mem->mem_size) {
+        prog->state = PB12_NATIVE_MODIFIED;
+        return;
+    }
+    for (i=0; i<prog->length; i++) {
+        if (memcmp(pb12GetDecoded(mem, bar + i)->text, prog->code[i], 6) != 0) {
+            prog->state = PB12_NATIVE_MODIFIED;
+            return;
+        }
+    }
+
+    for (i=0; i<prog->length; i++)
+        pb12GetDecoded(mem, bar + i)->flags |= PB12_DEC_NATIVE;
+    prog->state = PB12_NATIVE_ACTIVE;
+}
+
+
+/**
+    Called when a marked word has been written: any process whose code no
+    longer matches its translation goes back to being interpreted.
+
+    @param PB12_Native *native - Translator.
+    @param PB12_MEM *mem - Memory.
+*/
+static void pb12CheckNative(PB12_Native *native, PB12_MEM *mem) {
+    PB12_NativeProg *prog;
+    int i;
+    int j;
+
+    for (i=0; i<native->count; i++) {
+        prog = &native->prog[i];
+        if (prog->state != PB12_NATIVE_ACTIVE)
+            continue;
+        for (j=0; j<prog->length; j++) {
+            if (!(mem->decoded[prog->bar + j].flags & PB12_DEC_NATIVE)) {
+                pb12ActivateNative(prog, mem, prog->bar);
+                break;
+            }
+        }
+    }
+
+    native->code_writes = mem->code_writes;
+}
+
+
+/**
+    Builds a translation with the C compiler.  The compiler is run directly
+    rather than through the shell, so nothing in the paths is taken as a
+    command.
+
+    @param const char *object - Path of the shared object to build.
+    @param const char *source - Path of the C source.
+
+    @return int - PB12_SUCCESS, or PB12_FAILURE if the compiler failed
+*/
+static int pb12CompileNative(const char *object, const char *source) {
+    const char *argv[] = { PB12_NATIVE_CC, PB12_NATIVE_CFLAGS, "-x", "c", "-o", NULL, NULL, NULL };
+    int argc;
+    int status;
+    pid_t child;
+
+    /* The paths go in the two slots before the terminating NULL. */
+    argc = sizeof(argv) / sizeof(argv[0]) - 3;
+    argv[argc] = object;
+    argv[argc + 1] = source;
+
+    child = fork();
+    if (child < 0)
+        return PB12_FAILURE;
+    if (child == 0) {
+        /* execvp() takes char *const[], though it leaves the strings be. */
+        execvp(argv[0], (char *const*) argv);
+        _exit(127);
+    }
+
+    while (waitpid(child, &status, 0) < 0) {
+        if (errno != EINTR)
+            return PB12_FAILURE;
+    }
+    if (WIFEXITED(status) && WEXITSTATUS(status) == 0)
+        return PB12_SUCCESS;
+    return PB12_FAILURE;
+}
+
+
+/* A translation in the cache, when pruning it */
+typedef struct S_PB12_NativeEntry {
+    time_t built;               /* When its shared object was last written */
+    char name[32];              /* Hash it is named after */
+} PB12_NativeEntry;
+
+
+/**
+    Orders cached translations from the oldest to the newest.
+
+    @param const void *a - First PB12_NativeEntry.
+    @param const void *b - Second PB12_NativeEntry.
+
+    @return int - Negative, zero or positive as for qsort().
+*/
+static int pb12CompareNativeEntry(const void *a, const void *b) {
+    const PB12_NativeEntry *x = (const PB12_NativeEntry*) a;
+    const PB12_NativeEntry *y = (const PB12_NativeEntry*) b;
+
+    if (x->built < y->built)
+        return -1;
+    if (x->built > y->built)
+        return 1;
+    return strcmp(x->name, y->name);
+}
+
+
+/**
+    Keeps the cache to PB12_NATIVE_CACHE_MAX translations by removing the
+    oldest, source and shared object both.  Anything else in the directory
+    is left alone.
+
+    @param const char *cache - Directory of translations.
+*/
+static void pb12PruneNative(const char *cache) {
+    PB12_NativeEntry *entries;
+    PB12_NativeEntry *more;
+    struct dirent *dir;
+    struct stat info;
+    char path[PB12_NATIVE_PATH + 48];
+    size_t length;
+    int count;
+    int room;
+    int i;
+    DIR *d;
+
+    d = opendir(cache);
+    if (!d)
+        return;
+
+    entries = NULL;
+    count = 0;
+    room = 0;
+    while ((dir = readdir(d)) != NULL) {
+        length = strlen(dir->d_name);
+        if (length < 4 || length - 3 >= sizeof(entries->name) ||
+            strcmp(&dir->d_name[length - 3], ".so") != 0)
+            continue;
+        sprintf(path, "%s%s%s", cache, PB12_PATH_SEP, dir->d_name);
+        if (stat(path, &info) != 0)
+            continue;
+
+        if (count == room) {
+            room = room ? 2 * room : PB12_NATIVE_CACHE_MAX + 1;
+            more = (PB12_NativeEntry*) realloc(entries, room * sizeof(PB12_NativeEntry));
+            if (!more)
+                break;
+            entries = more;
+        }
+        entries[count].built = info.st_mtime;
+        memcpy(entries[count].name, dir->d_name, length - 3);
+        entries[count].name[length - 3] = '\0';
+        ++count;
+    }
+    closedir(d);
+
+    if (count > PB12_NATIVE_CACHE_MAX) {
+        qsort(entries, count, sizeof(PB12_NativeEntry), pb12CompareNativeEntry);
+        for (i=0; i<count - PB12_NATIVE_CACHE_MAX; i++) {
+            sprintf(path, "%s%s%s.so", cache, PB12_PATH_SEP, entries[i].name);
+            remove(path);
+            sprintf(path, "%s%s%s.c", cache, PB12_PATH_SEP, entries[i].name);
+            remove(path);
+        }
+    }
+    free(entries);
+}
+
+
+/**
+    Works out the directory translations are kept in: the one named by the
+    PB12_NATIVE_CACHE_ENV environment variable, or else PB12_NATIVE_CACHE
+    in the directory of the executable, so that running from elsewhere
+    finds the same translations.  Where the executable cannot be found it
+    is the current directory.
+
+    @param char *cache - Set to the directory, PB12_NATIVE_PATH chars.
+*/
+static void pb12NativeCacheDir(char *cache) {
+    const char *env;
+    char *slash;
+    ssize_t length;
+
+    /* Room is left for the names of translations in it. */
+    env = getenv(PB12_NATIVE_CACHE_ENV);
+    if (env && env[0] && strlen(env) < PB12_NATIVE_PATH - 32) {
+        strcpy(cache, env);
+        return;
+    }
+
+    length = readlink("/proc/self/exe", cache, PB12_NATIVE_PATH - 1);
+    if (length > 0) {
+        cache[length] = '\0';
+        slash = strrchr(cache, PB12_PATH_SEP[0]);
+        if (slash && (size_t)(slash - cache) + strlen(PB12_NATIVE_CACHE) < PB12_NATIVE_PATH - 32) {
+            strcpy(slash + 1, PB12_NATIVE_CACHE);
+            return;
+        }
+    }
+
+    sprintf(cache, ".%s%s", PB12_PATH_SEP, PB12_NATIVE_CACHE);
+}
+
+#endif /* PB12_NATIVE_DLOPEN */
+
+
+/**
+    Initialize the ahead-of-time translator.  This fails when shared objects
+    cannot be loaded on the machine the VM is running on.
+
+    @param PB12_Native *native - Translator.
+
+    @return int - PB12_SUCCESS or PB12_FAILURE
+*/
+int pb12InitNative(PB12_Native *native) {
+    native->prog = NULL;
+    native->count = 0;
+    native->code_writes = 0;
+    native->cache[0] = '\0';
+
+#ifdef PB12_NATIVE_DLOPEN
+    pb12NativeCacheDir(native->cache);
+    return PB12_SUCCESS;
+#else
+    return PB12_FAILURE;
+#endif
+}
+
+
+/**
+    Unload all translations.
+
+    @param PB12_Native *native - Translator.
+*/
+void pb12DestroyNative(PB12_Native *native) {
+#ifdef PB12_NATIVE_DLOPEN
+    int i;
+
+    for (i=0; i<native->count; i++) {
+        if (native->prog[i].handle)
+            dlclose(native->prog[i].handle);
+    }
+#endif
+    free(native->prog);
+    native->prog = NULL;
+    native->count = 0;
+}
+
+
+/**
+    Translate the program of a process, or load its translation from the
+    cache.  If this fails the process is simply interpreted.
+
+    @param PB12_Native *native - Translator.
+    @param int pid - Process ID.
+    @param const char *filename - Path to program file.
+    @param int mem_size - Size of memory in VM.
+    @param const PB12_Config *config - Settings of the VM.
+
+    @return int - PB12_SUCCESS or PB12_FAILURE
+*/
+int pb12TranslateNative(PB12_Native *native, int pid, const char *filename, int mem_size,
+                        const PB12_Config *config) {
+#ifdef PB12_NATIVE_DLOPEN
+    PB12_NativeProg *more;
+    PB12_NativeProg *prog;
+    char (*words)[6];
+    char name[32];
+    char source[PB12_NATIVE_PATH + 48];
+    char object[PB12_NATIVE_PATH + 48];
+    char temp_source[PB12_NATIVE_PATH + 56];
+    char temp[PB12_NATIVE_PATH + 56];
+    int length;
+    int ret_val;
+    int fd;
+    int i;
+    FILE *fp;
+
+    if (pid < 0)
+        return PB12_FAILURE;
+
+    if (pid >= native->count) {
+        more = (PB12_NativeProg*) realloc(native->prog, (pid + 1) * sizeof(PB12_NativeProg));
+        if (!more)
+            return PB12_FAILURE;
+        native->prog = more;
+        for (i=native->count; i<=pid; i++) {
+            native->prog[i].handle = NULL;
+            native->prog[i].state = PB12_NATIVE_NONE;
+        }
+        native->count = pid + 1;
+    }
+    prog = &native->prog[pid];
+
+    words = pb12NativeRead(filename, mem_size, &length, name);
+    if (!words)
+        return PB12_FAILURE;
+    if (length == 0) {
+        free(words);
+        return PB12_FAILURE;
+    }
+
+    sprintf(source, "%s%s%s.c", native->cache, PB12_PATH_SEP, name);
+    sprintf(object, "%s%s%s.so", native->cache, PB12_PATH_SEP, name);
+
+    /* A cached translation of the same program starts straight away. */
+    ret_val = pb12OpenNative(prog, object, words, length);
+    if (ret_val == PB12_FAILURE) {
+        mkdir(native->cache, 0777);
+
+        /*
+            Write and build under names no other VM or run can have, so an
+            old translation is never half written, even when others are
+            building the same program.
+        */
+        sprintf(temp_source, "%s.XXXXXX", source);
+        sprintf(temp, "%s.XXXXXX", object);
+        fp = NULL;
+        fd = mkstemp(temp_source);
+        if (fd >= 0) {
+            fp = fdopen(fd, "w");
+            if (!fp) {
+                close(fd);
+                remove(temp_source);
+            }
+        }
+        fd = fp ? mkstemp(temp) : -1;
+        if (fd >= 0) {
+            close(fd);
+            pb12WriteNative(fp, words, length, mem_size);
+            if (fclose(fp) == 0) {
+                if (pb12CompileNative(temp, temp_source) == PB12_SUCCESS &&
+                    rename(temp, object) == 0) {
+                    ret_val = pb12OpenNative(prog, object, words, length);
+                    pb12PruneNative(native->cache);
+                }
+            }
+            if (ret_val == PB12_FAILURE || rename(temp_source, source) != 0)
+                remove(temp_source);
+            remove(temp);
+        }
+        else if (fp) {
+            fclose(fp);
+            remove(temp_source);
+        }
+    }
+
+    if (ret_val == PB12_FAILURE)
+        pb12ErrorMsg(config, pb12ErrorStr[PB12_ERROR_TRANSLATING], filename);
+
+    free(words);
+    return ret_val;
+#else
+    (void)native;
+    (void)pid;
+    (void)filename;
+    (void)mem_size;
+    (void)config;
+    return PB12_FAILURE;
+#endif
+}
+
+
+/**
+    Runs the current process natively until its time slice runs out or it
+    reaches an instruction that has to be interpreted.
+
+    @param PB12_Native *native - Translator.
+    @param int pid - Process ID of the current process.
+    @param PB12_HW *hw - Hardware.
+
+    @return int - PB12_SUCCESS, or PB12_NOT_RUN if the interpreter has to
+                  execute the instruction at pc instead.
+*/
+int pb12RunNative(PB12_Native *native, int pid, PB12_HW *hw) {
+#ifdef PB12_NATIVE_DLOPEN
+    PB12_NativeProg *prog;
+    PB12_MEM *mem;
+
+    if (pid < 0 || pid >= native->count)
+        return PB12_NOT_RUN;
+
+    prog = &native->prog[pid];
+    if (prog->state == PB12_NATIVE_NONE || prog->state == PB12_NATIVE_MODIFIED)
+        return PB12_NOT_RUN;
+
+    mem = &hw->mem;
+    if (mem->code_writes != native->code_writes)
+        pb12CheckNative(native, mem);
+
+    if (prog->state == PB12_NATIVE_LOADED || prog->bar != hw->cpu.bar)
+        pb12ActivateNative(prog, mem, hw->cpu.bar);
+    if (prog->state != PB12_NATIVE_ACTIVE)
+        return PB12_NOT_RUN;
+
+    hw->retired = prog->run(&hw->cpu, mem, &mem->code_writes,
+                            pb12NativeGet, pb12NativePut);
+    return hw->retired > 0 ? PB12_SUCCESS : PB12_NOT_RUN;
+#else
+    (void)native;
+    (void)pid;
+    (void)hw;
+    return PB12_NOT_RUN;
+#endif
+}
@@ -0,0 +1,109 @@
+#ifndef PB12_NATIVE_H
+#define PB12_NATIVE_H
+
+#include "pb12_cpu.h"
+#include "pb12_mem.h"
+
+struct S_PB12_HW;
+
+#define PB12_NATIVE_VERSION     1           /* Changes whenever translations do */
+#define PB12_NATIVE_CACHE       ".pb12_cache"   /* Directory of translations */
+#define PB12_NATIVE_CACHE_ENV   "PB12_CACHE"    /* Environment variable naming it */
+#define PB12_NATIVE_PATH        256         /* Room for the path of the directory */
+#define PB12_NATIVE_CACHE_MAX   256         /* Most translations kept, the oldest go first */
+#define PB12_NATIVE_CC          "gcc"       /* Compiler, found on the PATH */
+#define PB12_NATIVE_CFLAGS      "-O2", "-shared", "-fPIC"   /* Its options, one per argument */
+
+/* States of a translated program */
+#define PB12_NATIVE_NONE        0   /* No translation, always interpreted */
+#define PB12_NATIVE_LOADED      1   /* Translated, code not yet checked */
+#define PB12_NATIVE_ACTIVE      2   /* Code in memory matches the translation */
+#define PB12_NATIVE_MODIFIED    3   /* Code has been written, interpreted */
+
+/*
+    Entry point of a translated program.  It runs the process from pc until
+    the time slice runs out, a store writes a translated word, or it reaches
+    an instruction it has to leave to the interpreter, and returns the
+    number of instructions it executed.
+*/
+typedef int (*PB12_NativeRun)(PB12_CPU *cpu, void *mem,
+                              const unsigned int *code_writes,
+                              int (*get)(PB12_CPU *cpu, void *mem, int addr),
+                              void (*put)(PB12_CPU *cpu, void *mem, int addr, int value));
+
+typedef struct S_PB12_NativeProg {
+    void *handle;               /* Shared object of the translation */
+    PB12_NativeRun run;         /* Entry point */
+    const char (*code)[6];      /* Words the program was translated from */
+    int length;                 /* Number of words */
+    int bar;                    /* Where the code was checked in memory */
+    int state;                  /* PB12_NATIVE_* state */
+} PB12_NativeProg;
+
+/*
+    Programs translated ahead of time to C, compiled to shared objects and
+    loaded with dlopen().  Translations are named after a hash of the
+    program file and reused by later runs.  They are kept in the directory
+    named by the PB12_NATIVE_CACHE_ENV environment variable, or else in
+    PB12_NATIVE_CACHE next to the executable, wherever the VM is run from.
+    No more than PB12_NATIVE_CACHE_MAX are kept.
+*/
+typedef struct S_PB12_Native {
+    char cache[PB12_NATIVE_PATH];   /* Directory of translations */
+    PB12_NativeProg *prog;      /* Translation of each process, by pid */
+    int count;                  /* Number of entries in prog */
+    unsigned int code_writes;   /* mem->code_writes when code was checked */
+} PB12_Native;
+
+
+/**
+    Initialize the ahead-of-time translator and work out where its
+    translations are kept.  This fails when shared objects cannot be loaded
+    on the machine the VM is running on.
+
+    @param PB12_Native *native - Translator.
+
+    @return int - PB12_SUCCESS or PB12_FAILURE
+*/
+int pb12InitNative(PB12_Native *native);
+
+
+/**
+    Unload all translations.
+
+    @param PB12_Native *native - Translator.
+*/
+void pb12DestroyNative(PB12_Native *native);
+
+
+/**
+    Translate the program of a process, or load its translation from the
+    cache.  If this fails the process is simply interpreted.
+
+    @param PB12_Native *native - Translator.
+    @param int pid - Process ID.
+    @param const char *filename - Path to program file.
+    @param int mem_size - Size of memory in VM.
+    @param const PB12_Config *config - Settings of the VM.
+
+    @return int - PB12_SUCCESS or PB12_FAILURE
+*/
+int pb12TranslateNative(PB12_Native *native, int pid, const char *filename, int mem_size,
+                        const PB12_Config *config);
+
+
+/**
+    Runs the current process natively until its time slice runs out or it
+    reaches an instruction that has to be interpreted.  The number of
+    instructions executed is left in hw->retired.
+
+    @param PB12_Native *native - Translator.
+    @param int pid - Process ID of the current process.
+    @param struct S_PB12_HW *hw - Hardware.
+
+    @return int - PB12_SUCCESS, or PB12_NOT_RUN if the interpreter has to
+                  execute the instruction at pc instead.
+*/
+int pb12RunNative(PB12_Native *native, int pid, struct S_PB12_HW *hw);
+
+#endif /* PB12_NATIVE_H */
@@ -9,6 +9,42 @@
 #include "pb12_semaphore.h"
 #include "pb12_strings.h"
 #include "pb12_alloc.h"
+#include "pb12_verify.h"
+
+/**
+    Work out how many instructions the next time slice has.
+
+    @param PB12_OS *os - Operating System.
+
+    @return int - Instruction count.
+*/
+static int pb12NextIc(PB12_OS *os) {
+    if (os->hw->config->options & PB12_OPT_TIMESTEP)
+        return os->hw->config->time_step;
+
+    return pb12RandIc(&os->rng, PB12_TIME_SLICE);
+}
+
+
+/**
+    Remove a PCB from a list, complaining if it is not there.
+
+    @param PB12_OS *os - Operating System.
+    @param PB12_PCB_List *pcb_list - PCB List.
+    @param int pid - ID of process to remove.
+
+    @return PB12_PCB* - PCB that has been removed, or NULL.
+*/
+static PB12_PCB *pb12TakePcb(PB12_OS *os, PB12_PCB_List *pcb_list, int pid) {
+    PB12_PCB *pcb;
+
+    pcb = pb12RemovePcb(pcb_list, pid);
+    if (pcb == NULL)
+        pb12ErrorMsg(os->hw->config, pb12ErrorStr[PB12_ERROR_PCB_NOT_FOUND]);
+
+    return pcb;
+}
+
 
 /**
     Initialize Operating System.
@@ -16,19 +52,44 @@
     @param PB12_OS *os - Operating System
     @param PB12_HW *hw - Virtual Machine's hardware.
 
-    @return int - PB21_SUCCESS
+    @return int - PB12_SUCCESS, or PB12_FAILURE if the free list cannot be made
 */
 int pb12InitOs(PB12_OS *os, PB12_HW *hw) {
     os->hw = hw;
 
     os->tick_count = 0;
 
-    pb12AllocInit(&os->free_list, PB12_MEM_SIZE);
+    if (pb12AllocInit(&os->free_list, hw->mem.mem_size, hw->config) == PB12_FAILURE)
+        return PB12_FAILURE;
+    if (hw->config->options & PB12_OPT_BUDDY &&
+        pb12InitBuddy(&os->buddy, hw->mem.mem_size, hw->config) == PB12_FAILURE)
+        return PB12_FAILURE;
+    if (hw->config->options & PB12_OPT_PAGED) {
+        if (pb12InitMmu(&os->mmu, hw->mem.mem_size, hw->config) == PB12_FAILURE)
+            return PB12_FAILURE;
+        hw->mem.mmu = &os->mmu;
+    }
+    pb12SeedRand(&os->rng, hw->config->seed);
 
     pb12InitPcbList(&os->new_q);
     pb12InitPcbList(&os->ready_q);
+    pb12InitPcbList(&os->swap_q);
+    if (hw->config->options & PB12_OPT_SWAP &&
+        pb12InitSwap(&os->swap) == PB12_FAILURE)
+        return PB12_FAILURE;
+    if (hw->config->options & PB12_OPT_TRACE &&
+        pb12OpenTraceWrite(&os->trace, hw->config->trace_path, hw->mem.mem_size) == PB12_FAILURE)
+        return PB12_FAILURE;
+    if (hw->config->options & PB12_OPT_TELEMETRY &&
+        pb12InitTelemetry(&os->telemetry) == PB12_FAILURE)
+        return PB12_FAILURE;
 
     os->next_pid = 0;
+    os->allocs = 0;
+    os->alloc_failures = 0;
+    os->compactions = 0;
+    os->words_moved = 0;
+    os->freed = false;
 
     /* TODO: REMOVE AFTER PROJECT 3 */
     pb12SemInit(&os->forks[0], 1);
@@ -53,6 +114,20 @@ int pb12InitOs(PB12_OS *os, PB12_HW *hw) {
 int pb12DestroyOs(PB12_OS *os) {
     pb12FreePcbList(&os->new_q);
     pb12FreePcbList(&os->ready_q);
+    pb12FreePcbList(&os->swap_q);
+    pb12AllocDestroy(&os->free_list);
+    if (os->hw->config->options & PB12_OPT_BUDDY)
+        pb12DestroyBuddy(&os->buddy);
+    if (os->hw->config->options & PB12_OPT_PAGED) {
+        pb12DestroyMmu(&os->mmu);
+        os->hw->mem.mmu = NULL;
+    }
+    if (os->hw->config->options & PB12_OPT_SWAP)
+        pb12DestroySwap(&os->swap);
+    if (os->hw->config->options & PB12_OPT_TRACE)
+        pb12CloseTrace(&os->trace);
+    if (os->hw->config->options & PB12_OPT_TELEMETRY)
+        pb12DestroyTelemetry(&os->telemetry);
 
     os->hw = NULL;
 
@@ -72,8 +147,9 @@ void pb12StartOs(PB12_OS *os) {
 
 /**
     Queueing a program will create a PCB for a process and add it to the
-    new process queue.  When a memory location is available, it will load
-    the program into memory and move the PCB to the ready queue.
+    new process queue.  The program file is read once, here, and kept in the
+    PCB.  When a memory location is available, it will load the program
+    into memory and move the PCB to the ready queue.
 
     @param PB12_OS *os - Operating System.
     @param const char *filename - File name of program.
@@ -82,26 +158,24 @@ void pb12StartOs(PB12_OS *os) {
 */
 int pb12QueueProgram(PB12_OS *os, const char *filename) {
     int pid;
-    int mem_req;
     PB12_PCB *pcb;
-    FILE *fp;
-    char buffer[256];
+    PB12_Image image;
 
-    fp = fopen(filename, "rt");
-    if (fp == NULL) {
+    /* The program is kept in the PCB until there is room to load it. */
+    if (pb12ReadImage(&image, filename) == PB12_FAILURE) {
         return PB12_FAILURE;
     }
 
-    fgets(buffer, 256, fp);
-    fclose(fp);
-    fp = NULL;
-    sscanf(buffer, "%d", &mem_req);
-
     pid = os->next_pid;
     ++os->next_pid;
 
     pcb = (PB12_PCB*) malloc(sizeof(PB12_PCB));
-    pb12InitPcb(pcb, pid, filename, mem_req);
+    pb12InitPcb(pcb, pid, filename, image.mem_req, pb12NextIc(os));
+    pcb->image = image;
+
+    if (os->hw->config->options & PB12_OPT_VERBOSE)
+        printf("Init PCB - PID: %d, Program: \"%s\", Memory: %d, IC = %d.\n",
+               pcb->pid, pcb->program, pcb->mem_req, pcb->cpu.ic);
 
     pb12PushBackPcb(&os->new_q, pcb);
 
@@ -109,6 +183,401 @@ int pb12QueueProgram(PB12_OS *os, const char *filename) {
 }
 
 
+/**
+    Records an allocation event in the trace file, if there is one, and
+    samples the allocator after it for telemetry.
+
+    @param PB12_OS *os - Operating System.
+    @param int op - PB12_TRACE_*.
+    @param int pid - Process the block is for.
+    @param int length - Words asked for, or 0.
+*/
+static void pb12RecordAlloc(PB12_OS *os, int op, int pid, int length) {
+    PB12_AllocSample sample;
+
+    if (os->hw->config->options & PB12_OPT_TRACE)
+        pb12TraceWrite(&os->trace, op, pid, length, os->tick_count);
+
+    if (os->hw->config->options & PB12_OPT_TELEMETRY) {
+        sample.tick = os->tick_count;
+        if (os->hw->config->options & PB12_OPT_BUDDY) {
+            sample.free_words = pb12BuddyCensus(&os->buddy, &sample.holes, &sample.largest);
+            sample.visited = os->buddy.visited;
+            sample.merges = os->buddy.merges;
+        }
+        else {
+            sample.free_words = pb12AllocCensus(&os->free_list, &sample.holes, &sample.largest);
+            sample.visited = os->free_list.visited;
+            sample.merges = os->free_list.merges;
+        }
+        sample.allocs = os->allocs;
+        sample.failed = os->alloc_failures;
+        pb12TelemetrySample(&os->telemetry, &sample);
+    }
+}
+
+
+/**
+    Orders processes by the address of their memory.
+
+    @param const void *a - PB12_PCB** of one process.
+    @param const void *b - PB12_PCB** of the other.
+
+    @return int - Negative, zero or positive, as for qsort().
+*/
+static int pb12CompareBar(const void *a, const void *b) {
+    return (*(PB12_PCB* const*)a)->mem_block->address -
+           (*(PB12_PCB* const*)b)->mem_block->address;
+}
+
+
+/**
+    Adds the processes of a queue that hold memory to a list.
+
+    @param PB12_PCB **resident - List of processes.
+    @param int count - Processes in the list so far.
+    @param PB12_PCB_List *list - Queue of processes.
+
+    @return int - Processes in the list now.
+*/
+static int pb12GatherResident(PB12_PCB **resident, int count, PB12_PCB_List *list) {
+    PB12_PCB *pcb;
+
+    for (pcb = list->head; pcb != NULL; pcb = pcb->next_pcb) {
+        if (pcb->mem_block != NULL)
+            resident[count++] = pcb;
+    }
+    return count;
+}
+
+
+/**
+    Slides the memory of every process that holds any down to the lowest
+    addresses, leaving one free block at the end of memory.  Each process
+    moved gets its bar and lr rewritten, the hardware's CPU as well if it
+    is running, and its program is verified again where it now is.
+    Nothing is moved if it would take more than compact_limit words.
+
+    @param PB12_OS *os - Operating System.
+
+    @return int - PB12_SUCCESS, or PB12_FAILURE if nothing was moved
+*/
+static int pb12CompactMemory(PB12_OS *os) {
+    PB12_PCB **resident;
+    PB12_PCB *pcb;
+    PB12_MemBlock *mem_block;
+    int count;
+    int address;
+    int moved;
+    int i;
+
+    /* Blocked processes hold memory too. */
+    resident = (PB12_PCB**) malloc(os->next_pid * sizeof(PB12_PCB*));
+    if (resident == NULL)
+        return PB12_FAILURE;
+    count = pb12GatherResident(resident, 0, &os->ready_q);
+    for (i=0; i<(int)(sizeof(os->forks) / sizeof(os->forks[0])); i++)
+        count = pb12GatherResident(resident, count, &os->forks[i].sem_q);
+    count = pb12GatherResident(resident, count, &os->doorman.sem_q);
+    qsort(resident, count, sizeof(PB12_PCB*), pb12CompareBar);
+
+    moved = 0;
+    address = 0;
+    for (i=0; i<count; i++) {
+        mem_block = resident[i]->mem_block;
+        if (mem_block->address != address)
+            moved += mem_block->length;
+        address += mem_block->length;
+    }
+    if (moved == 0 || moved > os->hw->config->compact_limit) {
+        free(resident);
+        return PB12_FAILURE;
+    }
+
+    address = 0;
+    for (i=0; i<count; i++) {
+        pcb = resident[i];
+        mem_block = pcb->mem_block;
+        if (mem_block->address != address) {
+            if (os->hw->config->options & PB12_OPT_VERBOSE) {
+                printf("Moving %s (%d) from [%d-%d:%d] to %d.\n", pcb->program, pcb->pid,
+                       mem_block->address, mem_block->address + mem_block->length - 1,
+                       mem_block->length, address);
+            }
+
+            pb12ForgetProgram(&os->hw->mem, mem_block->address, mem_block->length);
+            pb12MoveMem(&os->hw->mem, address, mem_block->address, mem_block->length);
+            if (pcb == os->ready_q.head && os->hw->cpu.bar == mem_block->address) {
+                os->hw->cpu.bar = address;
+                os->hw->cpu.lr = address + mem_block->length;
+            }
+            mem_block->address = address;
+            pb12SetPcbMem(pcb, mem_block);
+            pb12MoveProof(&os->hw->mem, address, mem_block->length, &pcb->proof);
+        }
+        address += mem_block->length;
+    }
+    free(resident);
+
+    pb12AllocCompacted(&os->free_list, address);
+    pb12RecordAlloc(os, PB12_TRACE_COMPACT, 0, 0);
+    ++os->compactions;
+    os->words_moved += moved;
+
+    if (os->hw->config->options & PB12_OPT_VERBOSE) {
+        printf("Memory compacted, %d words moved.  Memory list now:\n", moved);
+        pb12AllocPrint(&os->free_list);
+    }
+
+    return PB12_SUCCESS;
+}
+
+
+/**
+    Allocates a block of memory with the allocation algorithm in use.
+
+    @param PB12_OS *os - Operating System.
+    @param int length - Words needed.
+
+    @return PB12_MemBlock* - Memory block, or NULL if none is big enough.
+*/
+static PB12_MemBlock *pb12AllocBlock(PB12_OS *os, int length) {
+    PB12_MemBlock *mem_block;
+
+    if (os->hw->config->options & PB12_OPT_FIRST_FIT)
+        mem_block = pb12AllocFirstFit(&os->free_list, length);
+    else if (os->hw->config->options & PB12_OPT_NEXT_FIT)
+        mem_block = pb12AllocNextFit(&os->free_list, length);
+    else if (os->hw->config->options & PB12_OPT_WORST_FIT)
+        mem_block = pb12AllocWorstFit(&os->free_list, length);
+    else if (os->hw->config->options & PB12_OPT_SEGREGATED_FIT)
+        mem_block = pb12AllocSegregatedFit(&os->free_list, length);
+    else if (os->hw->config->options & PB12_OPT_BUDDY)
+        mem_block = pb12BuddyAlloc(&os->buddy, length);
+    else if (os->hw->config->options & PB12_OPT_TLSF)
+        mem_block = pb12AllocTlsf(&os->free_list, length);
+    else
+        mem_block = pb12AllocBestFit(&os->free_list, length);
+
+    if (mem_block != NULL)
+        ++os->allocs;
+    else
+        ++os->alloc_failures;
+    return mem_block;
+}
+
+
+/**
+    Gives a block of memory back to the allocation algorithm in use.
+
+    @param PB12_OS *os - Operating System.
+    @param PB12_MemBlock *mem_block - Memory block.
+*/
+static void pb12FreeBlock(PB12_OS *os, PB12_MemBlock *mem_block) {
+    pb12ForgetProgram(&os->hw->mem, mem_block->address, mem_block->length);
+    if (os->hw->config->options & PB12_OPT_BUDDY)
+        pb12BuddyFree(&os->buddy, mem_block);
+    else
+        pb12AllocMerge(&os->free_list, mem_block);
+}
+
+
+/**
+    Finds the blocked process of a semaphore queue holding the most memory.
+
+    @param PB12_PCB *largest - Largest found so far, or NULL.
+    @param PB12_PCB_List *list - Queue of a semaphore.
+
+    @return PB12_PCB* - Largest found now, or NULL.
+*/
+static PB12_PCB *pb12LargestBlocked(PB12_PCB *largest, PB12_PCB_List *list) {
+    PB12_PCB *pcb;
+
+    for (pcb = list->head; pcb != NULL; pcb = pcb->next_pcb) {
+        if (pcb->mem_block != NULL &&
+            (largest == NULL || pcb->mem_block->length > largest->mem_block->length))
+            largest = pcb;
+    }
+    return largest;
+}
+
+
+/**
+    Swaps out the blocked process that holds the most memory.  Its words
+    go to the backing store and its block is freed, so others can have it
+    until it is unblocked.
+
+    @param PB12_OS *os - Operating System.
+
+    @return int - PB12_SUCCESS, or PB12_FAILURE if no process could be swapped out
+*/
+static int pb12SwapOut(PB12_OS *os) {
+    PB12_PCB *pcb;
+    PB12_MemBlock *mem_block;
+    long bytes;
+    int i;
+
+    pcb = NULL;
+    for (i=0; i<(int)(sizeof(os->forks) / sizeof(os->forks[0])); i++)
+        pcb = pb12LargestBlocked(pcb, &os->forks[i].sem_q);
+    pcb = pb12LargestBlocked(pcb, &os->doorman.sem_q);
+    if (pcb == NULL)
+        return PB12_FAILURE;
+
+    mem_block = pcb->mem_block;
+    if (pcb->swap_offset < 0) {
+        pcb->swap_offset = pb12SwapReserve(&os->swap, mem_block->length);
+        pcb->swap_length = mem_block->length;
+    }
+    bytes = pb12SwapWrite(&os->swap, &os->hw->mem, pcb->swap_offset,
+                          mem_block->address, mem_block->length);
+    if (bytes < 0) {
+        pb12ErrorMsg(os->hw->config, pb12ErrorStr[PB12_ERROR_SWAP], pcb->pid);
+        return PB12_FAILURE;
+    }
+
+    if (os->hw->config->options & PB12_OPT_VERBOSE) {
+        printf("Swapped out %s (%d) from [%d-%d:%d], %ld bytes.\n", pcb->program, pcb->pid,
+               mem_block->address, mem_block->address + mem_block->length - 1,
+               mem_block->length, bytes);
+    }
+
+    pb12FreeBlock(os, mem_block);
+    pb12RecordAlloc(os, PB12_TRACE_FREE, pcb->pid, 0);
+    pcb->mem_block = NULL;
+    pcb->swapped = true;
+    ++os->stats[pcb->pid].swap_outs;
+    os->stats[pcb->pid].swap_out_bytes += bytes;
+
+    return PB12_SUCCESS;
+}
+
+
+/**
+    Allocates a block the way waiting programs are admitted.  If no block
+    is big enough, memory is compacted when enough of it is free in pieces,
+    and blocked processes are swapped out, until one is found or neither
+    can make more room.
+
+    @param PB12_OS *os - Operating System.
+    @param int length - Words needed.
+
+    @return PB12_MemBlock* - Memory block, or NULL if there is no room.
+*/
+static PB12_MemBlock *pb12MakeRoom(PB12_OS *os, int length) {
+    PB12_MemBlock *mem_block;
+    int compacted = 0;
+
+    while ((mem_block = pb12AllocBlock(os, length)) == NULL) {
+        /* Enough is free, just not in one piece: compact and try again. */
+        if (!compacted && (os->hw->config->options & PB12_OPT_COMPACT) &&
+            !(os->hw->config->options & PB12_OPT_BUDDY) &&
+            os->free_list.free_words >= length &&
+            pb12CompactMemory(os) == PB12_SUCCESS) {
+            compacted = 1;
+        }
+        /* Blocked processes can wait for their memory in the backing store. */
+        else if ((os->hw->config->options & PB12_OPT_SWAP) &&
+                 pb12SwapOut(os) == PB12_SUCCESS) {
+            compacted = 0;
+        }
+        else {
+            return NULL;
+        }
+    }
+    return mem_block;
+}
+
+
+/**
+    Swaps a process back in, wherever memory can be found for it, swapping
+    out blocked processes if it takes that.  Its bar and lr are set to
+    where it is now and its program is verified again there.
+
+    @param PB12_OS *os - Operating System.
+    @param PB12_PCB *pcb - Process that was swapped out.
+
+    @return int - PB12_SUCCESS, or PB12_FAILURE if it is still swapped out
+*/
+static int pb12SwapIn(PB12_OS *os, PB12_PCB *pcb) {
+    PB12_MemBlock *mem_block;
+    long bytes;
+
+    while ((mem_block = pb12AllocBlock(os, pcb->mem_req)) == NULL) {
+        if (pb12SwapOut(os) == PB12_FAILURE) {
+            pb12RecordAlloc(os, PB12_TRACE_WAIT, pcb->pid, pcb->mem_req);
+            return PB12_FAILURE;
+        }
+    }
+    pb12RecordAlloc(os, PB12_TRACE_ALLOC, pcb->pid, pcb->mem_req);
+
+    bytes = pb12SwapRead(&os->swap, &os->hw->mem, pcb->swap_offset,
+                         mem_block->address, mem_block->length);
+    if (bytes < 0) {
+        pb12ErrorMsg(os->hw->config, pb12ErrorStr[PB12_ERROR_SWAP], pcb->pid);
+        pb12FreeBlock(os, mem_block);
+        return PB12_FAILURE;
+    }
+
+    pb12SetPcbMem(pcb, mem_block);
+    pb12MoveProof(&os->hw->mem, mem_block->address, mem_block->length, &pcb->proof);
+    pcb->swapped = false;
+    ++os->stats[pcb->pid].swap_ins;
+    os->stats[pcb->pid].swap_in_bytes += bytes;
+
+    if (os->hw->config->options & PB12_OPT_VERBOSE) {
+        printf("Swapped in %s (%d) at %d, length %d, %ld bytes.\n", pcb->program, pcb->pid,
+               mem_block->address, mem_block->length, bytes);
+    }
+
+    return PB12_SUCCESS;
+}
+
+
+/**
+    Readies programs from the new_q with paged memory.  Nothing is loaded
+    until it is touched, so how much a program asks for does not matter:
+    each process is counted as PB12_PAGE_RESERVE frames, whatever it uses.
+    Its addresses are its own, from 0 up to its memory requirement, and are
+    not verified.
+
+    @param PB12_OS *os - Operating System
+
+    @return Number of processes that have been readied.
+*/
+static int pb12ReadyPaged(PB12_OS *os) {
+    PB12_PCB *pcb;
+    int readied = 0;
+
+    while (!pb12IsEmptyPcb(&os->new_q) &&
+           (os->mmu.resident + 1) * PB12_PAGE_RESERVE <= os->mmu.frames) {
+        pcb = os->new_q.head;
+        ++os->mmu.resident;
+        pcb->cpu.bar = 0;
+        pcb->cpu.lr = pcb->mem_req;
+        pcb->wait_time = os->tick_count;
+
+        os->stats[pcb->pid].start_time = os->tick_count;
+        os->stats[pcb->pid].mem_req = pcb->mem_req;
+        os->stats[pcb->pid].mem_alloc = pcb->mem_req;
+        os->stats[pcb->pid].searched = 0;
+        os->stats[pcb->pid].swap_outs = 0;
+        os->stats[pcb->pid].swap_ins = 0;
+        os->stats[pcb->pid].swap_out_bytes = 0;
+        os->stats[pcb->pid].swap_in_bytes = 0;
+
+        pb12MoveToReady(os, &os->new_q, pcb->pid);
+        ++readied;
+        if (os->hw->config->options & PB12_OPT_VERBOSE) {
+            printf("Readied %s (%d) paged, length %d, wait time %d.\n",
+                   pcb->program, pcb->pid, pcb->mem_req, pcb->wait_time);
+        }
+    }
+
+    return readied;
+}
+
+
 /**
     Loads as many programs as possible from the new_q that can fit into
     memory then moves them over to the ready_q to start executing them.
@@ -120,39 +589,69 @@ int pb12QueueProgram(PB12_OS *os, const char *filename) {
 int pb12ReadyPrograms(PB12_OS *os) {
     PB12_MemBlock *mem_block;
     PB12_PCB *pcb;
+    unsigned long searched;
     int readied = 0;
 
+    if (os->hw->config->options & PB12_OPT_PAGED)
+        return pb12ReadyPaged(os);
+
+    /* Processes that were unblocked while swapped out go before new ones. */
+    while (!pb12IsEmptyPcb(&os->swap_q)) {
+        pcb = os->swap_q.head;
+        if (pb12SwapIn(os, pcb) == PB12_FAILURE)
+            return readied;
+        pb12MoveToReady(os, &os->swap_q, pcb->pid);
+        ++readied;
+    }
+
     while (!pb12IsEmptyPcb(&os->new_q)) {
         pcb = os->new_q.head;
+        searched = os->free_list.searched;
 
         /* TODO: Memory allocation, loading, and moving to ready_q */
-        if (pb12Options & PB12_OPT_FIRST_FIT) {
-            mem_block = pb12AllocFirstFit(&os->free_list, pcb->mem_req);
-        }
-        else if (pb12Options & PB12_OPT_WORST_FIT) {
-            mem_block = pb12AllocWorstFit(&os->free_list, pcb->mem_req);
-        }
-        else {
-            mem_block = pb12AllocBestFit(&os->free_list, pcb->mem_req);
-        }
+        mem_block = pb12MakeRoom(os, pcb->mem_req);
+        pcb->searched += os->free_list.searched - searched;
 
-        if (mem_block) {
-            pb12SetPcbMem(pcb, mem_block);
-            pb12Load(&os->hw->mem, mem_block->address, pcb->program);
-            pcb->wait_time = os->tick_count;
-
-            os->stats[pcb->pid].start_time = os->tick_count;
+        if (mem_block == NULL) {
+            pb12RecordAlloc(os, PB12_TRACE_WAIT, pcb->pid, pcb->mem_req);
+            return readied;
+        }
 
-            pb12MoveToReady(os, &os->new_q, pcb->pid);
-            ++readied;
-            if (pb12Options & PB12_OPT_VERBOSE) {
-                printf("Readied %s (%d) at %d, length %d, wait time %d.\n",
-                       pcb->program, pcb->pid, mem_block->address,
-                       mem_block->length, pcb->wait_time);
-            }
+        pb12RecordAlloc(os, PB12_TRACE_ALLOC, pcb->pid, pcb->mem_req);
+        pb12SetPcbMem(pcb, mem_block);
+        pb12LoadImage(&os->hw->mem, mem_block->address, &pcb->image);
+        pb12FreeImage(&pcb->image);
+        pb12VerifyProgram(&os->hw->mem, mem_block->address, mem_block->length,
+                          &pcb->proof);
+        pcb->wait_time = os->tick_count;
+
+        os->stats[pcb->pid].start_time = os->tick_count;
+        os->stats[pcb->pid].mem_req = pcb->mem_req;
+        os->stats[pcb->pid].searched = pcb->searched;
+        os->stats[pcb->pid].swap_outs = 0;
+        os->stats[pcb->pid].swap_ins = 0;
+        os->stats[pcb->pid].swap_out_bytes = 0;
+        os->stats[pcb->pid].swap_in_bytes = 0;
+        if (os->hw->config->options & PB12_OPT_BUDDY)
+            os->stats[pcb->pid].mem_alloc = pb12BuddySize(mem_block->length);
+        else
+            os->stats[pcb->pid].mem_alloc = mem_block->length;
+
+        pb12MoveToReady(os, &os->new_q, pcb->pid);
+        ++readied;
+        if (os->hw->config->options & PB12_OPT_VERBOSE) {
+            printf("Readied %s (%d) at %d, length %d, wait time %d.\n",
+                   pcb->program, pcb->pid, mem_block->address,
+                   mem_block->length, pcb->wait_time);
         }
-        else {
-            return readied;
+        if (os->hw->config->options & PB12_OPT_VERIFY) {
+            printf("Verified %d of %d memory accesses of %s (%d)",
+                   pcb->proof.verified, pcb->proof.accesses, pcb->program, pcb->pid);
+            if (pcb->proof.accesses > 0)
+                printf(", %.1f%%", 100.0 * pcb->proof.verified / pcb->proof.accesses);
+            if (!pcb->proof.confined)
+                printf(", control can leave its block");
+            printf(".\n");
         }
     }
 
@@ -172,19 +671,23 @@ int pb12DestroyProcess(PB12_OS *os, int pid) {
     /* TODO: Fix destroying currently running process to switch to next process. */
     PB12_PCB *pcb;
 
-    pcb = pb12RemovePcb(&os->new_q, pid);
+    pcb = pb12TakePcb(os, &os->new_q, pid);
     if (pcb != NULL) {
         pb12DestroyPcb(pcb);
         return PB12_SUCCESS;
     }
 
-    pcb = pb12RemovePcb(&os->ready_q, pid);
+    pcb = pb12TakePcb(os, &os->ready_q, pid);
     if (pcb != NULL) {
+        if (os->hw->config->options & PB12_OPT_PAGED)
+            pb12MmuRelease(&os->mmu, &pcb->pages);
+        if (os->hw->config->options & PB12_OPT_SWAP)
+            pb12SwapRelease(&os->swap, pcb->swap_offset, pcb->swap_length);
         pb12DestroyPcb(pcb);
         return PB12_SUCCESS;
     }
 
-    pb12ErrorMsg(pb12ErrorStr[PB12_ERORR_DESTROYING_PROCESS], pid);
+    pb12ErrorMsg(os->hw->config, pb12ErrorStr[PB12_ERORR_DESTROYING_PROCESS], pid);
 
     return PB12_FAILURE;
 }
@@ -200,19 +703,27 @@ void pb12TerminateProcess(PB12_OS *os) {
 
     pcb = pb12DequeuePcb(&os->ready_q);
 
-    if (pb12Options & PB12_OPT_VERBOSE) {
+    if (os->hw->config->options & PB12_OPT_VERBOSE) {
         printf("Terminating process (%d) '%s'.\n", pcb->pid, pcb->program);
     }
 
     os->stats[pcb->pid].end_time = os->tick_count;
 
-    pb12AllocMerge(&os->free_list, pcb->mem_block);
+    if (os->hw->config->options & PB12_OPT_PAGED) {
+        pb12MmuRelease(&os->mmu, &pcb->pages);
+    }
+    else {
+        pb12FreeBlock(os, pcb->mem_block);
+        pb12RecordAlloc(os, PB12_TRACE_FREE, pcb->pid, 0);
+    }
+    if (os->hw->config->options & PB12_OPT_SWAP)
+        pb12SwapRelease(&os->swap, pcb->swap_offset, pcb->swap_length);
     pb12DestroyPcb(pcb);
     pb12ReadyPrograms(os);
     if (os->ready_q.head != NULL) {
         /*memcpy(&os->hw->cpu, &os->ready_q.head->cpu, sizeof(PB12_CPU));*/
         pb12CopyCPU(&os->ready_q.head->cpu, &os->hw->cpu);
-        if (pb12Options & PB12_OPT_VERBOSE) {
+        if (os->hw->config->options & PB12_OPT_VERBOSE) {
             printf("Process (%d) ready to exec '%s' with time slice of %d inst.\n",
                    os->ready_q.head->pid, os->ready_q.head->program, os->hw->cpu.ic);
         }
@@ -220,6 +731,106 @@ void pb12TerminateProcess(PB12_OS *os) {
 }
 
 
+/**
+    Grows or shrinks the memory of the running process.  Its block is
+    resized where it is if that can be done, and otherwise it is moved to a
+    new block and the old one is freed.  Its bar and lr, in the hardware's
+    CPU as well, are set to the block it ends up with, and its program is
+    verified again there.  A new block is found the way waiting programs
+    are given one, compacting memory and swapping out blocked processes if
+    that is what it takes.  Memory it gives back may let waiting programs
+    in, which the OS tick does once the trap is over.  With paged memory
+    only lr changes, up to PB12_PAGE_SPACE words.
+
+    @param PB12_OS *os - Operating System.
+    @param int length - Words it wants.
+
+    @return int - PB12_SUCCESS, or PB12_FAILURE if it keeps what it had
+*/
+int pb12ResizeProcess(PB12_OS *os, int length) {
+    PB12_MemBlock *mem_block;
+    PB12_PCB *pcb;
+    int address;
+    int old_length;
+    int resized;
+
+    pcb = os->ready_q.head;
+    if (pcb == NULL || length <= 0)
+        return PB12_FAILURE;
+
+    /* Pages are only loaded when they are touched, so there is nothing to move. */
+    if (os->hw->config->options & PB12_OPT_PAGED) {
+        if (length > PB12_PAGE_SPACE)
+            return PB12_FAILURE;
+        pcb->mem_req = length;
+        pcb->cpu.lr = length;
+        os->hw->cpu.lr = length;
+        return PB12_SUCCESS;
+    }
+
+    mem_block = pcb->mem_block;
+    if (mem_block == NULL)
+        return PB12_FAILURE;
+    if (length == mem_block->length)
+        return PB12_SUCCESS;
+    old_length = mem_block->length;
+
+    if (os->hw->config->options & PB12_OPT_BUDDY)
+        resized = pb12BuddyResize(&os->buddy, mem_block, length);
+    else
+        resized = pb12AllocResize(&os->free_list, mem_block, length);
+
+    /* A new block is found the way waiting programs are given one. */
+    if (resized == PB12_FAILURE) {
+        mem_block = pb12MakeRoom(os, length);
+        if (mem_block == NULL)
+            return PB12_FAILURE;
+    }
+
+    /* Compacting memory to make room may have moved it already, and the
+       proof was for the block as it was. */
+    address = pcb->mem_block->address;
+    pb12ForgetProgram(&os->hw->mem, address, old_length);
+    if (mem_block != pcb->mem_block) {
+        pb12MoveMem(&os->hw->mem, mem_block->address, address,
+                    length < old_length ? length : old_length);
+        pb12FreeBlock(os, pcb->mem_block);
+    }
+
+    pb12SetPcbMem(pcb, mem_block);
+    os->hw->cpu.bar = pcb->cpu.bar;
+    os->hw->cpu.lr = pcb->cpu.lr;
+    pb12VerifyProgram(&os->hw->mem, mem_block->address, mem_block->length, &pcb->proof);
+
+    pcb->mem_req = length;
+
+    /* Its room in the backing store is only as long as its block was. */
+    if (length > old_length && (os->hw->config->options & PB12_OPT_SWAP)) {
+        pb12SwapRelease(&os->swap, pcb->swap_offset, pcb->swap_length);
+        pcb->swap_offset = -1;
+        pcb->swap_length = 0;
+    }
+
+    os->stats[pcb->pid].mem_req = length;
+    if (os->hw->config->options & PB12_OPT_BUDDY)
+        os->stats[pcb->pid].mem_alloc = pb12BuddySize(length);
+    else
+        os->stats[pcb->pid].mem_alloc = length;
+    pb12RecordAlloc(os, PB12_TRACE_RESIZE, pcb->pid, length);
+
+    if (os->hw->config->options & PB12_OPT_VERBOSE) {
+        printf("Resized %s (%d) from [%d-%d:%d] to [%d-%d:%d].\n", pcb->program, pcb->pid,
+               address, address + old_length - 1, old_length, mem_block->address,
+               mem_block->address + mem_block->length - 1, mem_block->length);
+    }
+
+    /* Waiting programs are let in by the OS tick, after the trap. */
+    if (length < old_length || mem_block->address != address)
+        os->freed = true;
+    return PB12_SUCCESS;
+}
+
+
 /**
     Get ID of currently running process.
 
@@ -245,16 +856,26 @@ int pb12CurrentPid(PB12_OS *os) {
 void pb12MoveToReady(PB12_OS *os, PB12_PCB_List *source, int pid) {
     PB12_PCB *pcb;
 
-    if (pb12Options & PB12_OPT_VERBOSE) {
+    if (os->hw->config->options & PB12_OPT_VERBOSE) {
         printf("Moving process with PID %d to Ready Queue.\n", pid);
     }
 
-    pcb = pb12RemovePcb(source, pid);
+    pcb = pb12TakePcb(os, source, pid);
+
+    /* A process swapped out while it was blocked needs memory first. */
+    if (pcb->swapped && pb12SwapIn(os, pcb) == PB12_FAILURE) {
+        if (os->hw->config->options & PB12_OPT_VERBOSE) {
+            printf("Process (%d) waits for memory to be swapped in.\n", pid);
+        }
+        pb12PushBackPcb(&os->swap_q, pcb);
+        return;
+    }
+
     pb12PushBackPcb(&os->ready_q, pcb);
 
     if (os->ready_q.head == pcb) {
         pb12CopyCPU(&pcb->cpu, &os->hw->cpu);
-        if (pb12Options & PB12_OPT_VERBOSE) {
+        if (os->hw->config->options & PB12_OPT_VERBOSE) {
             printf("Process (%d) ready to exec '%s' with time slice of %d inst.\n",
                    os->ready_q.head->pid, os->ready_q.head->program, os->hw->cpu.ic);
         }
@@ -273,26 +894,26 @@ void pb12MoveFromReady(PB12_OS *os, PB12_PCB_List *dest, int pid) {
     PB12_PCB *pcb;
     PB12_PCB *current;
 
-    if (pb12Options & PB12_OPT_VERBOSE && dest != &os->ready_q) {
+    if (os->hw->config->options & PB12_OPT_VERBOSE && dest != &os->ready_q) {
         printf("Moving process with PID %d off of Ready Queue.\n", pid);
     }
 
     current = os->ready_q.head;
-    pcb = pb12RemovePcb(&os->ready_q, pid);
+    pcb = pb12TakePcb(os, &os->ready_q, pid);
     pb12PushBackPcb(dest, pcb);
 
     if (pcb == current) {
         pb12CopyCPU(&os->hw->cpu, &pcb->cpu);
 
         if (pb12IsEmptyPcb(&os->ready_q)) {
-            if (pb12Options & PB12_OPT_VERBOSE) {
+            if (os->hw->config->options & PB12_OPT_VERBOSE) {
                 printf("Ready queue is empty!  Deadlock?\n");
             }
         }
         else {
             pb12CopyCPU(&os->ready_q.head->cpu, &os->hw->cpu);
 
-            if (pb12Options & PB12_OPT_VERBOSE) {
+            if (os->hw->config->options & PB12_OPT_VERBOSE) {
                 printf("Process (%d) ready to exec '%s' with time slice of %d inst.\n",
                        os->ready_q.head->pid, os->ready_q.head->program, os->hw->cpu.ic);
             }
@@ -301,27 +922,42 @@ void pb12MoveFromReady(PB12_OS *os, PB12_PCB_List *dest, int pid) {
 }
 
 
+/*
+    pb12_os_tick.inc is compiled once for untraced runs and once for traced
+    runs, so the OS work done after every time slice has no trace checks
+    when nothing is being traced.
+*/
+#define PB12_TRACED 0
+#define PB12_PREEMPT pb12PreemptUntraced
+#define PB12_TRAP_INTERRUPT pb12TrapInterruptUntraced
+#define PB12_OS_TICK pb12OsTickUntraced
+#include "pb12_os_tick.inc"
+#undef PB12_TRACED
+#undef PB12_PREEMPT
+#undef PB12_TRAP_INTERRUPT
+#undef PB12_OS_TICK
+
+#define PB12_TRACED 1
+#define PB12_PREEMPT pb12PreemptTraced
+#define PB12_TRAP_INTERRUPT pb12TrapInterruptTraced
+#define PB12_OS_TICK pb12OsTickTraced
+#include "pb12_os_tick.inc"
+#undef PB12_TRACED
+#undef PB12_PREEMPT
+#undef PB12_TRAP_INTERRUPT
+#undef PB12_OS_TICK
+
+
 /**
     Preempt the currently running process.
 
     @param PB12_OS *os - Operating System.
 */
 void pb12Preempt(PB12_OS *os) {
-    if (pb12Options & PB12_OPT_VERBOSE)
-        printf("Process (%d) completed time slice. Placing at tail of ready queue.\n", os->ready_q.head->pid);
-
-    pb12CopyCPU(&os->hw->cpu, &os->ready_q.head->cpu);
-
-    pb12MoveFirstToTopPcb(&os->ready_q);
-
-    pb12CopyCPU(&os->ready_q.head->cpu, &os->hw->cpu);
-
-    if (pb12Options & PB12_OPT_VERBOSE) {
-        printf("Process (%d) ready to exec '%s' with time slice of %d inst.\n",
-               os->ready_q.head->pid, os->ready_q.head->program, os->hw->cpu.ic);
-    }
-
-    /* pb12MoveFromReady(os, &os->ready_q, os->ready_q.head->pid); */
+    if (os->hw->config->options & PB12_OPT_VERBOSE)
+        pb12PreemptTraced(os);
+    else
+        pb12PreemptUntraced(os);
 }
 
 
@@ -331,18 +967,10 @@ void pb12Preempt(PB12_OS *os) {
     @param PB12_OS *os - Operating System.
 */
 void pb12TrapInterrupt(PB12_OS *os) {
-    if (os->hw->trap_num < 0)
-        return;
-
-    if (pb12Options & PB12_OPT_VERBOSE) {
-        printf("Trap Operation: num: %d, op: %d.\n", os->hw->trap_num, os->hw->trap_op);
-    }
-
-    if (os->hw->trap_num < PB12_TRAP_MAX_TRAP) {
-        pb12TrapVectors[os->hw->trap_num](os);
-    }
-
-    os->hw->trap_num = -1;
+    if (os->hw->config->options & PB12_OPT_VERBOSE)
+        pb12TrapInterruptTraced(os);
+    else
+        pb12TrapInterruptUntraced(os);
 }
 
 
@@ -355,34 +983,7 @@ void pb12TrapInterrupt(PB12_OS *os) {
     @return int - PB12_SUCCESS if running and PB12_TERMINATE if no processes.
 */
 int pb12OsTick(PB12_OS *os, int cpu_status) {
-    bool preempt;
-    preempt = false;
-
-    ++os->tick_count;
-
-    if (os->hw->cpu.ic == 0) {
-        preempt = true;
-        if (pb12Options & PB12_OPT_TIMESTEP) {
-            os->hw->cpu.ic = pb12TimeStep;
-        }
-        else {
-            os->hw->cpu.ic = pb12RandIc(PB12_TIME_SLICE);
-        }
-    }
-
-    pb12TrapInterrupt(os);
-
-    if (cpu_status == PB12_TERMINATE || cpu_status == PB12_FAILURE)
-        pb12TerminateProcess(os);
-
-    if (pb12IsEmptyPcb(&os->ready_q)) {
-        return PB12_TERMINATE;
-    }
-    else {
-        if (preempt) {
-            pb12Preempt(os);
-        }
-    }
-
-    return PB12_SUCCESS;
+    if (os->hw->config->options & PB12_OPT_VERBOSE)
+        return pb12OsTickTraced(os, cpu_status);
+    return pb12OsTickUntraced(os, cpu_status);
 }
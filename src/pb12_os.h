@@ -3,6 +3,11 @@
 
 #include "pb12_pcb.h"
 #include "pb12_alloc.h"
+#include "pb12_buddy.h"
+#include "pb12_page.h"
+#include "pb12_swap.h"
+#include "pb12_trace.h"
+#include "pb12_telemetry.h"
 #include "pb12_semaphore.h"
 #include "pb12_stats.h"
 
@@ -14,12 +19,26 @@ typedef struct S_PB12_OS {
     unsigned int tick_count;
 
     PB12_MemList free_list;     /* Free memory */
+    PB12_Buddy buddy;           /* Free memory with PB12_OPT_BUDDY instead */
+    PB12_Mmu mmu;               /* Frames of memory with PB12_OPT_PAGED instead */
+    PB12_Swap swap;             /* Backing store with PB12_OPT_SWAP */
+    PB12_Trace trace;           /* Allocations recorded with PB12_OPT_TRACE */
+    PB12_Telemetry telemetry;   /* Allocator sampled with PB12_OPT_TELEMETRY */
 
     PB12_PCB_List new_q;
     PB12_PCB_List ready_q;
+    PB12_PCB_List swap_q;       /* Unblocked, waiting for memory to be swapped in */
 
     int next_pid;
 
+    PB12_Rand rng;              /* Random time slices */
+
+    unsigned long allocs;       /* Blocks the allocator has given out */
+    unsigned long alloc_failures; /* Times the allocator had no block big enough */
+    int compactions;            /* Times memory was compacted */
+    long words_moved;           /* Words compaction has moved, all told */
+    bool freed;                 /* A trap gave memory back, so waiting programs may fit */
+
     PB12_ProcStat stats[50];   /* This is a quick hack for project 4 */
 
     /* THE FOLLOWING IS ONLY USED FOR PROJECT 3 */
@@ -35,7 +54,7 @@ typedef struct S_PB12_OS {
     @param PB12_OS *os - Operating System
     @param PB12_HW *hw - Virtual Machine's hardware.
 
-    @return int - PB21_SUCCESS
+    @return int - PB12_SUCCESS, or PB12_FAILURE if the free list cannot be made
 */
 int pb12InitOs(PB12_OS *os, struct S_PB12_HW *hw);
 
@@ -60,8 +79,9 @@ void pb12StartOs(PB12_OS *os);
 
 /**
     Queueing a program will create a PCB for a process and add it to the
-    new process queue.  When a memory location is available, it will load
-    the program into memory and move the PCB to the ready queue.
+    new process queue.  The program file is read once, here, and kept in the
+    PCB.  When a memory location is available, it will load the program
+    into memory and move the PCB to the ready queue.
 
     @param PB12_OS *os - Operating System.
     @param const char *filename - File name of program.
@@ -101,6 +121,19 @@ int pb12DestroyProcess(PB12_OS *os, int pid);
 void pb12TerminateProcess(PB12_OS *os);
 
 
+/**
+    Grows or shrinks the memory of the running process, where it is if it
+    can be and by moving it if not.  A new block is found the way waiting
+    programs are given one.
+
+    @param PB12_OS *os - Operating System.
+    @param int length - Words it wants.
+
+    @return int - PB12_SUCCESS, or PB12_FAILURE if it keeps what it had
+*/
+int pb12ResizeProcess(PB12_OS *os, int length);
+
+
 /**
     Get ID of currently running process.
 
@@ -157,4 +190,26 @@ void pb12TrapInterrupt(PB12_OS *os);
 */
 int pb12OsTick(PB12_OS *os, int cpu_status);
 
+
+/**
+    pb12OsTick() compiled for untraced runs, with no trace checks.
+
+    @param PB12_OS *os - Operating System.
+    @param int cpu_status - Value returned from CPU.
+
+    @return int - PB12_SUCCESS if running and PB12_TERMINATE if no processes.
+*/
+int pb12OsTickUntraced(PB12_OS *os, int cpu_status);
+
+
+/**
+    pb12OsTick() compiled for traced runs.
+
+    @param PB12_OS *os - Operating System.
+    @param int cpu_status - Value returned from CPU.
+
+    @return int - PB12_SUCCESS if running and PB12_TERMINATE if no processes.
+*/
+int pb12OsTickTraced(PB12_OS *os, int cpu_status);
+
 #endif /* PB12_OS_H */
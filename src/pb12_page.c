@@ -0,0 +1,322 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "pb12.h"
+#include "pb12_page.h"
+#include "pb12_strings.h"
+
+/**
+    Empty the TLB.
+
+    @param PB12_Mmu *mmu - Paged memory.
+*/
+static void pb12FlushTlb(PB12_Mmu *mmu) {
+    int i;
+
+    for (i=0; i<PB12_TLB_SIZE; i++)
+        mmu->tlb[i].page = -1;
+}
+
+
+/**
+    Initialize paged memory with every frame free.
+
+    @param PB12_Mmu *mmu - Paged memory.
+    @param int size - Words of memory.
+    @param const PB12_Config *config - Settings of the VM.
+
+    @return int - PB12_SUCCESS or PB12_FAILURE
+*/
+int pb12InitMmu(PB12_Mmu *mmu, int size, const PB12_Config *config) {
+    int i;
+
+    mmu->config = config;
+    mmu->table = NULL;
+    mmu->frames = size / PB12_PAGE_SIZE;
+    mmu->free_frames = (int*) malloc(mmu->frames * sizeof(int));
+    mmu->owner = (PB12_PageTable**) malloc(mmu->frames * sizeof(PB12_PageTable*));
+    mmu->page = (signed char*) malloc(mmu->frames);
+    mmu->referenced = (char*) calloc(mmu->frames, 1);
+    if (!mmu->free_frames || !mmu->owner || !mmu->page || !mmu->referenced) {
+        pb12DestroyMmu(mmu);
+        return PB12_FAILURE;
+    }
+
+    /* Frames are handed out from the lowest address up. */
+    for (i=0; i<mmu->frames; i++) {
+        mmu->free_frames[i] = mmu->frames - 1 - i;
+        mmu->owner[i] = NULL;
+        mmu->page[i] = -1;
+    }
+    mmu->free_count = mmu->frames;
+    mmu->hand = 0;
+    mmu->resident = 0;
+
+    mmu->tlb_hits = 0;
+    mmu->tlb_misses = 0;
+    mmu->faults = 0;
+    mmu->evictions = 0;
+    mmu->high = 0;
+    pb12FlushTlb(mmu);
+
+    return PB12_SUCCESS;
+}
+
+
+/**
+    Destroy paged memory.
+
+    @param PB12_Mmu *mmu - Paged memory.
+*/
+void pb12DestroyMmu(PB12_Mmu *mmu) {
+    free(mmu->free_frames);
+    mmu->free_frames = NULL;
+    free(mmu->owner);
+    mmu->owner = NULL;
+    free(mmu->page);
+    mmu->page = NULL;
+    free(mmu->referenced);
+    mmu->referenced = NULL;
+    mmu->table = NULL;
+}
+
+
+/**
+    Initialize the page table of a process with no page loaded.
+
+    @param PB12_PageTable *table - Page table.
+    @param int pid - Process the pages belong to.
+    @param const PB12_Image *image - Program the pages are loaded from.
+*/
+void pb12InitPageTable(PB12_PageTable *table, int pid, const PB12_Image *image) {
+    int i;
+
+    table->pid = pid;
+    table->image = image;
+    for (i=0; i<PB12_PAGES; i++) {
+        table->frame[i] = -1;
+        table->saved[i] = NULL;
+    }
+}
+
+
+/**
+    Free the saved words of the evicted pages of a page table.
+
+    @param PB12_PageTable *table - Page table.
+*/
+void pb12DestroyPageTable(PB12_PageTable *table) {
+    int i;
+
+    for (i=0; i<PB12_PAGES; i++) {
+        free(table->saved[i]);
+        table->saved[i] = NULL;
+    }
+}
+
+
+/**
+    Make a page table the one addresses are translated through, emptying
+    the TLB if it was not already.
+
+    @param PB12_Mmu *mmu - Paged memory.
+    @param PB12_PageTable *table - Page table of the running process, or NULL.
+*/
+void pb12MmuSwitch(PB12_Mmu *mmu, PB12_PageTable *table) {
+    if (mmu->table != table) {
+        mmu->table = table;
+        pb12FlushTlb(mmu);
+    }
+}
+
+
+/**
+    Give back the frames of a process that is done with them.
+
+    @param PB12_Mmu *mmu - Paged memory.
+    @param PB12_PageTable *table - Page table of the process.
+*/
+void pb12MmuRelease(PB12_Mmu *mmu, PB12_PageTable *table) {
+    int frame;
+    int i;
+
+    for (i=0; i<PB12_PAGES; i++) {
+        frame = table->frame[i];
+        if (frame >= 0) {
+            mmu->owner[frame] = NULL;
+            mmu->page[frame] = -1;
+            mmu->free_frames[mmu->free_count++] = frame;
+            table->frame[i] = -1;
+        }
+    }
+    if (mmu->table == table)
+        pb12MmuSwitch(mmu, NULL);
+    --mmu->resident;
+}
+
+
+/**
+    Evict the page the clock hand comes to first that has not been used
+    since the hand last passed it.  Its words are saved in its page table.
+
+    @param PB12_Mmu *mmu - Paged memory.
+    @param PB12_MEM *mem - Memory.
+
+    @return int - Frame that is now free, or -1 if the words could not be saved.
+*/
+static int pb12EvictPage(PB12_Mmu *mmu, PB12_MEM *mem) {
+    PB12_PageTable *owner;
+    int frame;
+    int page;
+    int i;
+
+    while (mmu->referenced[mmu->hand]) {
+        mmu->referenced[mmu->hand] = 0;
+        mmu->hand = (mmu->hand + 1) % mmu->frames;
+    }
+    frame = mmu->hand;
+    mmu->hand = (mmu->hand + 1) % mmu->frames;
+
+    owner = mmu->owner[frame];
+    page = mmu->page[frame];
+    if (owner->saved[page] == NULL) {
+        owner->saved[page] = (char (*)[6]) malloc(PB12_PAGE_SIZE * sizeof(char[6]));
+        if (owner->saved[page] == NULL)
+            return -1;
+    }
+
+    /* Packed words may not mean the same once they are out of memory. */
+    for (i=0; i<PB12_PAGE_SIZE; i++)
+        pb12GetMemWord(mem, frame * PB12_PAGE_SIZE + i, owner->saved[page][i]);
+    owner->frame[page] = -1;
+    if (owner == mmu->table && mmu->tlb[page % PB12_TLB_SIZE].page == page)
+        mmu->tlb[page % PB12_TLB_SIZE].page = -1;
+    ++mmu->evictions;
+
+    if (mmu->config->options & PB12_OPT_VERBOSE) {
+        printf("Evicting page %d of process (%d) from frame %d.\n",
+               page, owner->pid, frame);
+    }
+
+    mmu->owner[frame] = NULL;
+    return frame;
+}
+
+
+/**
+    Load a page of the running process into a frame, from its saved words
+    if it was evicted, or else from the image of its program.
+
+    @param PB12_Mmu *mmu - Paged memory.
+    @param PB12_MEM *mem - Memory.
+    @param int page - Page to load.
+
+    @return int - Frame it is in, or -1 if no frame could be had.
+*/
+static int pb12PageFault(PB12_Mmu *mmu, PB12_MEM *mem, int page) {
+    PB12_PageTable *table;
+    int address;
+    int frame;
+    int first;
+    int count;
+    int i;
+
+    table = mmu->table;
+    if (mmu->free_count > 0)
+        frame = mmu->free_frames[--mmu->free_count];
+    else
+        frame = pb12EvictPage(mmu, mem);
+    if (frame < 0)
+        return -1;
+
+    address = frame * PB12_PAGE_SIZE;
+    if (table->saved[page] != NULL) {
+        for (i=0; i<PB12_PAGE_SIZE; i++)
+            pb12PutMemWord(mem, address + i, table->saved[page][i]);
+    }
+    else {
+        /* Words past the end of the program are left as they were, as in a block. */
+        first = page * PB12_PAGE_SIZE;
+        count = table->image->length - first;
+        if (count > PB12_PAGE_SIZE)
+            count = PB12_PAGE_SIZE;
+        if (count > 0)
+            pb12LoadImageRange(mem, address, table->image, first, count);
+    }
+
+    table->frame[page] = frame;
+    mmu->owner[frame] = table;
+    mmu->page[frame] = (signed char)page;
+    ++mmu->faults;
+    if (mmu->frames - mmu->free_count > mmu->high)
+        mmu->high = mmu->frames - mmu->free_count;
+
+    if (mmu->config->options & PB12_OPT_VERBOSE) {
+        printf("Page fault: page %d of process (%d) loaded into frame %d.\n",
+               page, table->pid, frame);
+    }
+
+    return frame;
+}
+
+
+/**
+    Translate an address of the running process into a memory address,
+    loading its page first if it is not in a frame.  Addresses wrap around
+    PB12_PAGE_SPACE the way pointer registers do.
+
+    @param PB12_MEM *mem - Memory, with paging on.
+    @param int address - Address in the process.
+
+    @return int - Address in memory.
+*/
+int pb12Translate(PB12_MEM *mem, int address) {
+    PB12_Mmu *mmu;
+    PB12_TlbEntry *entry;
+    int page;
+    int frame;
+
+    mmu = mem->mmu;
+    address %= PB12_PAGE_SPACE;
+    if (address < 0)
+        address += PB12_PAGE_SPACE;
+    page = address / PB12_PAGE_SIZE;
+
+    entry = &mmu->tlb[page % PB12_TLB_SIZE];
+    if (entry->page == page) {
+        ++mmu->tlb_hits;
+        frame = entry->frame;
+    }
+    else {
+        ++mmu->tlb_misses;
+        if (mmu->table == NULL)
+            return address;
+        frame = mmu->table->frame[page];
+        if (frame < 0)
+            frame = pb12PageFault(mmu, mem, page);
+        if (frame < 0) {
+            pb12ErrorMsg(mmu->config, pb12ErrorStr[PB12_ERROR_PAGE_FAULT], page);
+            return address;
+        }
+        entry->page = (short)page;
+        entry->frame = frame;
+    }
+
+    mmu->referenced[frame] = 1;
+    return frame * PB12_PAGE_SIZE + address % PB12_PAGE_SIZE;
+}
+
+
+/**
+    Prints how well paging went.
+
+    @param const PB12_Mmu *mmu - Paged memory.
+*/
+void pb12MmuPrint(const PB12_Mmu *mmu) {
+    unsigned long lookups;
+
+    lookups = mmu->tlb_hits + mmu->tlb_misses;
+    printf("Paging: %lu page faults, %lu evictions, %d of %d frames in use at most\n",
+           mmu->faults, mmu->evictions, mmu->high, mmu->frames);
+    printf("TLB hit rate: %f%% of %lu translations\n",
+           lookups > 0 ? 100.0 * mmu->tlb_hits / lookups : 0.0, lookups);
+}
@@ -0,0 +1,138 @@
+#ifndef PB12_PAGE_H
+#define PB12_PAGE_H
+
+#include "pb12_image.h"
+
+#define PB12_PAGE_SIZE      10      /* Words in a page and in a frame */
+#define PB12_PAGE_SPACE     100     /* Words a process can address, 0 to 99 */
+#define PB12_PAGES          (PB12_PAGE_SPACE / PB12_PAGE_SIZE)
+#define PB12_TLB_SIZE       4       /* Translations the TLB holds */
+#define PB12_PAGE_RESERVE   5       /* Frames counted per process when admitting */
+
+/*
+    Where the pages of a process are.  A page that has never been touched
+    is loaded from the image of the program the first time it is.  A page
+    that was evicted to make room for another keeps its words in saved, as
+    their six characters, until it is touched again.
+*/
+typedef struct S_PB12_PageTable {
+    int pid;                            /* Process the pages belong to */
+    int frame[PB12_PAGES];              /* Frame each page is in, or -1 */
+    char (*saved[PB12_PAGES])[6];       /* Words of evicted pages, or NULL */
+    const PB12_Image *image;            /* Program the pages are loaded from */
+} PB12_PageTable;
+
+/* One translation the TLB remembers */
+typedef struct S_PB12_TlbEntry {
+    short page;                         /* Page of the running process, or -1 */
+    int frame;                          /* Frame it is in */
+} PB12_TlbEntry;
+
+/*
+    Paged memory.  Memory is split into frames of PB12_PAGE_SIZE words
+    that are handed out one page at a time, so no process needs its memory
+    in one piece.  Addresses of the running process are translated through
+    its page table, and the last few translations are kept in a direct
+    mapped TLB, page k in entry k % PB12_TLB_SIZE, which is emptied
+    whenever another process runs.  When no frame is free, the clock
+    algorithm picks a page to evict: the hand skips frames that were used
+    since it last passed them.
+*/
+typedef struct S_PB12_Mmu {
+    PB12_PageTable *table;              /* Page table of the running process */
+    PB12_TlbEntry tlb[PB12_TLB_SIZE];   /* Recent translations */
+    int frames;                         /* Frames in memory */
+    int *free_frames;                   /* Frames not in use */
+    int free_count;                     /* Entries in free_frames */
+    PB12_PageTable **owner;             /* Page table each frame is used by, or NULL */
+    signed char *page;                  /* Page each frame holds */
+    char *referenced;                   /* Frames used since the hand passed them */
+    int hand;                           /* Next frame the clock looks at */
+    int resident;                       /* Processes that may have pages in frames */
+    unsigned long tlb_hits;             /* Translations found in the TLB */
+    unsigned long tlb_misses;           /* Translations looked up in a page table */
+    unsigned long faults;               /* Pages loaded into a frame */
+    unsigned long evictions;            /* Pages evicted to free a frame */
+    int high;                           /* Most frames that have been in use at once */
+    const PB12_Config *config;          /* Settings of the VM */
+} PB12_Mmu;
+
+
+/**
+    Initialize paged memory with every frame free.
+
+    @param PB12_Mmu *mmu - Paged memory.
+    @param int size - Words of memory.
+    @param const PB12_Config *config - Settings of the VM.
+
+    @return int - PB12_SUCCESS or PB12_FAILURE
+*/
+int pb12InitMmu(PB12_Mmu *mmu, int size, const PB12_Config *config);
+
+
+/**
+    Destroy paged memory.
+
+    @param PB12_Mmu *mmu - Paged memory.
+*/
+void pb12DestroyMmu(PB12_Mmu *mmu);
+
+
+/**
+    Initialize the page table of a process with no page loaded.
+
+    @param PB12_PageTable *table - Page table.
+    @param int pid - Process the pages belong to.
+    @param const PB12_Image *image - Program the pages are loaded from.
+*/
+void pb12InitPageTable(PB12_PageTable *table, int pid, const PB12_Image *image);
+
+
+/**
+    Free the saved words of the evicted pages of a page table.
+
+    @param PB12_PageTable *table - Page table.
+*/
+void pb12DestroyPageTable(PB12_PageTable *table);
+
+
+/**
+    Make a page table the one addresses are translated through, emptying
+    the TLB if it was not already.
+
+    @param PB12_Mmu *mmu - Paged memory.
+    @param PB12_PageTable *table - Page table of the running process, or NULL.
+*/
+void pb12MmuSwitch(PB12_Mmu *mmu, PB12_PageTable *table);
+
+
+/**
+    Give back the frames of a process that is done with them.
+
+    @param PB12_Mmu *mmu - Paged memory.
+    @param PB12_PageTable *table - Page table of the process.
+*/
+void pb12MmuRelease(PB12_Mmu *mmu, PB12_PageTable *table);
+
+
+/**
+    Translate an address of the running process into a memory address,
+    loading its page first if it is not in a frame.  Addresses wrap around
+    PB12_PAGE_SPACE the way pointer registers do.
+
+    @param PB12_MEM *mem - Memory, with paging on.
+    @param int address - Address in the process.
+
+    @return int - Address in memory.
+*/
+int pb12Translate(PB12_MEM *mem, int address);
+
+
+/**
+    Prints how well paging went.
+
+    @param const PB12_Mmu *mmu - Paged memory.
+*/
+void pb12MmuPrint(const PB12_Mmu *mmu);
+
+#endif /* PB12_PAGE_H */
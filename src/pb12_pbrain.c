@@ -2,35 +2,74 @@
 #include "pb12.h"
 #include "pb12_pbrain.h"
 #include "pb12_cpu.h"
+#include "pb12_threaded.h"
+#include "pb12_jit.h"
+#include "pb12_native.h"
+#include "pb12_loop.h"
 #include "pb12_mem.h"
 #include "pb12_strings.h"
 
 
 /**
-    Initializes PBrain Virtual Machine.
+    Initializes PBrain Virtual Machine.  It fails if the engine that was
+    asked for cannot be started on this machine, rather than running on
+    another; only paged memory puts it on the switch engine.
 
     @param PB12_PBRAIN *pbrain - PBrain12 VM.
     @param int mem_size - Size of memory in VM.
+    @param const PB12_Config *config - Settings, copied into the VM.
 
     @return int - PB12_SUCCESS or PB12_FAILURE
 */
-int pb12InitPBrain(PB12_PBrain *pbrain, int mem_size) {
+int pb12InitPBrain(PB12_PBrain *pbrain, int mem_size, const PB12_Config *config) {
+    pbrain->config = *config;
+    pbrain->hw.config = &pbrain->config;
+
     if (pb12InitCpu(&pbrain->hw.cpu) == PB12_FAILURE) {
-        pb12ErrorMsg(pb12ErrorStr[PB12_ERROR_INIT_CPU]);
+        pb12ErrorMsg(&pbrain->config, pb12ErrorStr[PB12_ERROR_INIT_CPU]);
         return PB12_FAILURE;
     }
 
-    if (pb12InitMem(&pbrain->hw.mem, mem_size) == PB12_FAILURE) {
-        pb12ErrorMsg(pb12ErrorStr[PB12_ERROR_INIT_CPU]);
+    if (pb12InitMem(&pbrain->hw.mem, mem_size, &pbrain->config) == PB12_FAILURE) {
+        pb12ErrorMsg(&pbrain->config, pb12ErrorStr[PB12_ERROR_INIT_CPU]);
         return PB12_FAILURE;
     }
 
     /* Trap instruction initializing. */
     pbrain->hw.trap_num = -1;
     pbrain->hw.trap_op = 0;
+    pbrain->hw.retired = 0;
+
+    /* Only the switch engine translates addresses through page tables. */
+    pbrain->engine = pbrain->config.engine;
+    if (pbrain->config.options & PB12_OPT_PAGED)
+        pbrain->engine = PB12_ENGINE_SWITCH;
+
+    /* An engine that was asked for and cannot start is not quietly replaced. */
+    if (pbrain->engine == PB12_ENGINE_JIT &&
+        pb12InitJit(&pbrain->jit, mem_size) == PB12_FAILURE) {
+        pb12ErrorMsg(&pbrain->config, pb12ErrorStr[PB12_ERROR_INIT_JIT]);
+        pb12DestroyJit(&pbrain->jit);
+        pb12DestroyMem(&pbrain->hw.mem);
+        return PB12_FAILURE;
+    }
+    if (pbrain->engine == PB12_ENGINE_AOT &&
+        pb12InitNative(&pbrain->native) == PB12_FAILURE) {
+        pb12ErrorMsg(&pbrain->config, pb12ErrorStr[PB12_ERROR_INIT_NATIVE]);
+        pb12DestroyNative(&pbrain->native);
+        pb12DestroyMem(&pbrain->hw.mem);
+        return PB12_FAILURE;
+    }
+    if (pbrain->engine == PB12_ENGINE_LOOP &&
+        pb12InitLoops(&pbrain->loops, mem_size) == PB12_FAILURE) {
+        pb12ErrorMsg(&pbrain->config, pb12ErrorStr[PB12_ERROR_INIT_LOOP]);
+        pb12DestroyLoops(&pbrain->loops);
+        pb12DestroyMem(&pbrain->hw.mem);
+        return PB12_FAILURE;
+    }
 
     if (pb12InitOs(&pbrain->os, &pbrain->hw) == PB12_FAILURE) {
-        pb12ErrorMsg(pb12ErrorStr[PB12_ERROR_INIT_OS]);
+        pb12ErrorMsg(&pbrain->config, pb12ErrorStr[PB12_ERROR_INIT_OS]);
         return PB12_FAILURE;
     }
 
@@ -45,6 +84,12 @@ int pb12InitPBrain(PB12_PBrain *pbrain, int mem_size) {
 */
 void pb12DestroyPBrain(PB12_PBrain *pbrain) {
     pb12DestroyOs(&pbrain->os);
+    if (pbrain->engine == PB12_ENGINE_JIT)
+        pb12DestroyJit(&pbrain->jit);
+    if (pbrain->engine == PB12_ENGINE_AOT)
+        pb12DestroyNative(&pbrain->native);
+    if (pbrain->engine == PB12_ENGINE_LOOP)
+        pb12DestroyLoops(&pbrain->loops);
     pb12DestroyMem(&pbrain->hw.mem);
 }
 
@@ -60,6 +105,36 @@ void pb12Dump(PB12_PBrain *pbrain) {
 }
 
 
+/*
+    pb12_tick.inc is compiled once for untraced runs and once for traced
+    runs.  pb12Run() picks one when it starts, so a run without -v never
+    checks for tracing between time slices or instructions.
+*/
+#define PB12_TRACED 0
+#define PB12_TICK pb12TickUntraced
+#define PB12_RUN_CPU pb12RunCpuUntraced
+#define PB12_RUN_THREADED pb12RunThreadedUntraced
+#define PB12_OS_TICK pb12OsTickUntraced
+#include "pb12_tick.inc"
+#undef PB12_TRACED
+#undef PB12_TICK
+#undef PB12_RUN_CPU
+#undef PB12_RUN_THREADED
+#undef PB12_OS_TICK
+
+#define PB12_TRACED 1
+#define PB12_TICK pb12TickTraced
+#define PB12_RUN_CPU pb12RunCpuTraced
+#define PB12_RUN_THREADED pb12RunThreadedTraced
+#define PB12_OS_TICK pb12OsTickTraced
+#include "pb12_tick.inc"
+#undef PB12_TRACED
+#undef PB12_TICK
+#undef PB12_RUN_CPU
+#undef PB12_RUN_THREADED
+#undef PB12_OS_TICK
+
+
 /**
     Clock tick for virtual machine -- updates CPU and OS.
 
@@ -68,26 +143,9 @@ void pb12Dump(PB12_PBrain *pbrain) {
     @return int  PB12_SUCCESS, PB12_FAILURE, or PB12_TERMINATE
 */
 int pb12Tick(PB12_PBrain *pbrain) {
-    int ret_val;
-
-    if (pb12Options & PB12_OPT_VERBOSE)
-        printf("  PID=%d ", pb12CurrentPid(&pbrain->os));
-
-    pb12Fetch(&pbrain->hw.cpu, &pbrain->hw.mem);
-    ret_val = pb12Execute(&pbrain->hw.cpu, &pbrain->hw);
-
-    /*
-    if (ret_val == PB12_FAILURE)
-        return ret_val;
-
-    if (ret_val == PB12_TERMINATE)
-        pb12TerminateProcess(&pbrain->os);
-    */
-
-    /* pb12DumpCPU(&pbrain->hw.cpu); */
-
-    ret_val = pb12OsTick(&pbrain->os, ret_val);
-    return ret_val;
+    if (pbrain->config.options & PB12_OPT_VERBOSE)
+        return pb12TickTraced(pbrain);
+    return pb12TickUntraced(pbrain);
 }
 
 
@@ -100,11 +158,25 @@ int pb12Tick(PB12_PBrain *pbrain) {
 */
 int pb12Run(PB12_PBrain *pbrain) {
     int ret_val = 0;
+    int (*tick)(PB12_PBrain *pbrain);
+    PB12_PCB *pcb;
+
+    /* Translate every queued program before anything starts running. */
+    if (pbrain->engine == PB12_ENGINE_AOT) {
+        for (pcb = pbrain->os.new_q.head; pcb != NULL; pcb = pcb->next_pcb)
+            pb12TranslateNative(&pbrain->native, pcb->pid, pcb->program,
+                                pbrain->hw.mem.mem_size, &pbrain->config);
+    }
 
     pb12StartOs(&pbrain->os);
 
+    if (pbrain->config.options & PB12_OPT_VERBOSE)
+        tick = pb12TickTraced;
+    else
+        tick = pb12TickUntraced;
+
     while (ret_val == 0) {
-        ret_val = pb12Tick(pbrain);
+        ret_val = tick(pbrain);
     }
     return ret_val;
 }
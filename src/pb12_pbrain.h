@@ -3,24 +3,40 @@
 
 #include "pb12_hw.h"
 #include "pb12_os.h"
-
+#include "pb12_jit.h"
+#include "pb12_native.h"
+#include "pb12_loop.h"
+
+/*
+    One virtual machine.  Nothing is shared between VMs, so each one can be
+    run on its own host thread.  The hardware, memory and OS point back into
+    the structure, so it must not be copied or moved once initialized.
+*/
 typedef struct S_PB12_PBrain {
+    PB12_Config config;     /* Settings the VM was started with */
     PB12_HW hw;
     PB12_OS os;
+    int engine;     /* PB12_ENGINE_* used to execute instructions */
+    PB12_Jit jit;   /* Compiled blocks, with PB12_ENGINE_JIT */
+    PB12_Native native;     /* Translated programs, with PB12_ENGINE_AOT */
+    PB12_Loops loops;       /* Summarized loops, with PB12_ENGINE_LOOP */
 } PB12_PBrain;
 
 
 /* Prototypes */
 
 /**
-    Initializes PBrain Virtual Machine.
+    Initializes PBrain Virtual Machine.  It fails if the engine that was
+    asked for cannot be started on this machine, rather than running on
+    another; only paged memory puts it on the switch engine.
 
     @param PB12_PBRAIN *pbrain - PBrain12 VM.
     @param int mem_size - Size of memory in VM.
+    @param const PB12_Config *config - Settings, copied into the VM.
 
     @return int - PB12_SUCCESS or PB12_FAILURE
 */
-int pb12InitPBrain(PB12_PBrain *pbrain, int mem_size);
+int pb12InitPBrain(PB12_PBrain *pbrain, int mem_size, const PB12_Config *config);
 
 
 /**
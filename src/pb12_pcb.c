@@ -13,28 +13,35 @@
     @param PB12_PCB * pcb - Process Control Block.
     @param int pid - Process ID.
     @param int mem_req - Required amount of memory for process.
+    @param int ic - Instructions in the first time slice.
 */
-void pb12InitPcb(PB12_PCB *pcb, int pid, const char* filename, int mem_req) {
+void pb12InitPcb(PB12_PCB *pcb, int pid, const char* filename, int mem_req, int ic) {
     pcb->next_pcb = NULL;
     pcb->pid = pid;
     pcb->mem_req = mem_req;
     pcb->mem_block = NULL;
     pcb->wait_time = 0;
+    pcb->searched = 0;
+    pcb->proof.confined = 0;
+    pcb->proof.bar = 0;
+    pcb->proof.writes = 0;
+    pcb->proof.accesses = 0;
+    pcb->proof.verified = 0;
+    pcb->proof.length = 0;
+    pcb->proof.marks = NULL;
+    pcb->image.mem_req = mem_req;
+    pcb->image.length = 0;
+    pcb->image.words = NULL;
+    pcb->image.tails = NULL;
+    pb12InitPageTable(&pcb->pages, pid, &pcb->image);
+    pcb->swapped = false;
+    pcb->swap_offset = -1;
+    pcb->swap_length = 0;
 
     pb12InitCpu(&pcb->cpu);
-
-    if (pb12Options & PB12_OPT_TIMESTEP) {
-        pcb->cpu.ic = pb12TimeStep;
-    }
-    else {
-        pcb->cpu.ic = pb12RandIc(PB12_TIME_SLICE);
-    }
+    pcb->cpu.ic = ic;
 
     strncpy(pcb->program, filename, sizeof(pcb->program));
-
-    if (pb12Options & PB12_OPT_VERBOSE)
-        printf("Init PCB - PID: %d, Program: \"%s\", Memory: %d, IC = %d.\n",
-               pcb->pid, pcb->program, pcb->mem_req, pcb->cpu.ic);
 }
 
 
@@ -44,6 +51,9 @@ void pb12InitPcb(PB12_PCB *pcb, int pid, const char* filename, int mem_req) {
     @param PB12_PCB * pcb - Process Control Block.
 */
 void pb12DestroyPcb(PB12_PCB *pcb) {
+    pb12FreeImage(&pcb->image);
+    pb12FreeProof(&pcb->proof);
+    pb12DestroyPageTable(&pcb->pages);
     free(pcb);
 }
 
@@ -64,10 +74,13 @@ void pb12SetPcbMem(PB12_PCB *pcb, struct S_PB12_MemBlock *mem_block) {
 /**
     Generate random instruction count number.
 
+    @param PB12_Rand *rng - Random number generator of the VM.
+    @param int range - Largest number of instructions.
+
     @return int range - Random number of instructions.
 */
-int pb12RandIc(int range) {
-    return 1 + (int)(range * ((float)rand() / RAND_MAX));
+int pb12RandIc(PB12_Rand *rng, int range) {
+    return 1 + (int)(range * ((float)pb12Rand(rng) / PB12_RAND_MAX));
 }
 
 
@@ -164,7 +177,8 @@ PB12_PCB* pb12FindPrevPcb(PB12_PCB_List *pcb_list, int pid) {
     @param PB12_PCB_LIST *pcb_list - PCB List.
     @param int pid - ID of process to remove.
 
-    @param PB12_PCB* - PCB that has been removed.
+    @param PB12_PCB* - PCB that has been removed, or NULL if it is not in
+                       the list.
 */
 PB12_PCB* pb12RemovePcb(PB12_PCB_List *pcb_list, int pid) {
     PB12_PCB *prev_pcb;
@@ -180,7 +194,6 @@ PB12_PCB* pb12RemovePcb(PB12_PCB_List *pcb_list, int pid) {
             return pcb;
         }
         else {
-            pb12ErrorMsg(pb12ErrorStr[PB12_ERROR_PCB_NOT_FOUND]);
             return NULL;
         }
     }
@@ -259,16 +272,18 @@ PB12_PCB* pb12DequeuePcb(PB12_PCB_List *pcb_list) {
     Move PCB from head to tail of list.
 
     @param PB12_PCB_LIST *pcb_list - PCB List.
+
+    @return int - PB12_SUCCESS, or PB12_FAILURE if the list is empty.
 */
-void pb12MoveFirstToTopPcb(PB12_PCB_List *pcb_list) {
+int pb12MoveFirstToTopPcb(PB12_PCB_List *pcb_list) {
     PB12_PCB *pcb;
 
     pcb = pb12DequeuePcb(pcb_list);
-    if (pcb == NULL) {
-        pb12ErrorMsg(pb12ErrorStr[PB12_ERROR_MOVING_PCB]);
-    }
+    if (pcb == NULL)
+        return PB12_FAILURE;
 
     pb12PushBackPcb(pcb_list, pcb);
+    return PB12_SUCCESS;
 }
 
 
@@ -3,6 +3,10 @@
 
 #include <stdbool.h>
 #include "pb12_cpu.h"
+#include "pb12_rand.h"
+#include "pb12_verify.h"
+#include "pb12_image.h"
+#include "pb12_page.h"
 
 /* struct S_PB12_CPU; */
 struct S_PB12_MemBlock;
@@ -15,6 +19,13 @@ typedef struct S_PB12_PCB {
     int mem_req;    /* Amount of memory needed by process. */
     struct S_PB12_MemBlock* mem_block;  /* Block of memory used by process */
     unsigned int wait_time;  /* Number of ticks elapsed before process exec */
+    unsigned long searched;     /* Free blocks looked at finding it memory */
+    PB12_Proof proof;           /* What was proved when the program was loaded */
+    PB12_Image image;           /* Program read when queued, until it is loaded */
+    PB12_PageTable pages;       /* Where its pages are, with paged memory */
+    bool swapped;               /* Its memory is in the backing store */
+    long swap_offset;           /* Its room in the backing store, or -1 */
+    int swap_length;            /* Words in its room */
     char program[32];
 } PB12_PCB;
 
@@ -32,8 +43,9 @@ typedef struct S_PB12_PCB_List {
     @param int pid - Process ID.
     @param const char* filename - filename associated with process.
     @param int mem_req - Required amount of memory for process.
+    @param int ic - Instructions in the first time slice.
 */
-void pb12InitPcb(PB12_PCB *pcb, int pid, const char *filename, int mem_req);
+void pb12InitPcb(PB12_PCB *pcb, int pid, const char *filename, int mem_req, int ic);
 
 
 /**
@@ -56,9 +68,12 @@ void pb12SetPcbMem(PB12_PCB *pcb, struct S_PB12_MemBlock *mem_block);
 /**
     Generate random instruction count number.
 
+    @param PB12_Rand *rng - Random number generator of the VM.
+    @param int range - Largest number of instructions.
+
     @return int range - Random number of instructions.
 */
-int pb12RandIc(int range);
+int pb12RandIc(PB12_Rand *rng, int range);
 
 
 /**
@@ -115,7 +130,8 @@ PB12_PCB* pb12FindPrevPcb(PB12_PCB_List *pcb_list, int pid);
     @param PB12_PCB_LIST *pcb_list - PCB List.
     @param int pid - ID of process to remove.
 
-    @param PB12_PCB* - PCB that has been removed.
+    @param PB12_PCB* - PCB that has been removed, or NULL if it is not in
+                       the list.
 */
 PB12_PCB* pb12RemovePcb(PB12_PCB_List *pcb_list, int pid);
 
@@ -152,8 +168,10 @@ PB12_PCB* pb12DequeuePcb(PB12_PCB_List *pcb_list);
     Move PCB from head to tail of list.
 
     @param PB12_PCB_LIST *pcb_list - PCB List.
+
+    @return int - PB12_SUCCESS, or PB12_FAILURE if the list is empty.
 */
-void pb12MoveFirstToTopPcb(PB12_PCB_List *pcb_list);
+int pb12MoveFirstToTopPcb(PB12_PCB_List *pcb_list);
 
 
 /**
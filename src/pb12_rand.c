@@ -0,0 +1,62 @@
+#include "pb12_rand.h"
+
+
+/**
+    Seed a random number generator.
+
+    @param PB12_Rand *rng - Random number generator.
+    @param unsigned long seed - Seed, like srand().
+*/
+void pb12SeedRand(PB12_Rand *rng, unsigned long seed) {
+    long word;
+    long hi;
+    long lo;
+    int i;
+
+    word = (long)(seed & 0x7fffffffUL);
+    if (word == 0)
+        word = 1;
+
+    /* Park-Miller minimal standard generator, without overflow */
+    rng->state[0] = (unsigned long)word;
+    for (i=1; i<PB12_RAND_DEG; i++) {
+        hi = word / 127773;
+        lo = word % 127773;
+        word = 16807 * lo - 2836 * hi;
+        if (word < 0)
+            word += 2147483647;
+        rng->state[i] = (unsigned long)word;
+    }
+
+    rng->front = PB12_RAND_SEP;
+    rng->rear = 0;
+
+    /* The first numbers are thrown away, as the C library does. */
+    for (i=0; i<PB12_RAND_DEG * 10; i++)
+        pb12Rand(rng);
+}
+
+
+/**
+    Get the next random number.
+
+    @param PB12_Rand *rng - Random number generator.
+
+    @return int - Number from 0 to PB12_RAND_MAX.
+*/
+int pb12Rand(PB12_Rand *rng) {
+    unsigned long value;
+
+    value = (rng->state[rng->front] + rng->state[rng->rear]) & 0xffffffffUL;
+    rng->state[rng->front] = value;
+
+    if (++rng->front >= PB12_RAND_DEG) {
+        rng->front = 0;
+        ++rng->rear;
+    }
+    else if (++rng->rear >= PB12_RAND_DEG) {
+        rng->rear = 0;
+    }
+
+    return (int)(value >> 1);
+}
@@ -0,0 +1,39 @@
+#ifndef PB12_RAND_H
+#define PB12_RAND_H
+
+#define PB12_RAND_MAX   2147483647  /* Largest number pb12Rand() returns */
+#define PB12_RAND_DEG   31          /* Words of state */
+#define PB12_RAND_SEP   3           /* Distance between the two taps */
+
+/*
+    Random number generator of one virtual machine.  It is the additive
+    feedback generator used by the GNU C library's rand(), so a VM given
+    the same seed makes the same time slices the VM did when it used the C
+    library directly, but VMs no longer share (or race on) its state.
+*/
+typedef struct S_PB12_Rand {
+    unsigned long state[PB12_RAND_DEG];
+    int front;                  /* Word that is updated next */
+    int rear;                   /* Word it is updated with */
+} PB12_Rand;
+
+
+/**
+    Seed a random number generator.
+
+    @param PB12_Rand *rng - Random number generator.
+    @param unsigned long seed - Seed, like srand().
+*/
+void pb12SeedRand(PB12_Rand *rng, unsigned long seed);
+
+
+/**
+    Get the next random number.
+
+    @param PB12_Rand *rng - Random number generator.
+
+    @return int - Number from 0 to PB12_RAND_MAX.
+*/
+int pb12Rand(PB12_Rand *rng);
+
+#endif /* PB12_RAND_H */
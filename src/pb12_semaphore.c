@@ -2,6 +2,7 @@
 #include "pb12.h"
 #include "pb12_semaphore.h"
 #include "pb12_os.h"
+#include "pb12_hw.h"
 
 /**
     Initialize a Semaphore.
@@ -23,15 +24,19 @@ void pb12SemInit(PB12_Semaphore *sem, int count) {
 */
 void pb12SemWait(PB12_Semaphore *sem, PB12_OS *os) {
     --sem->count;
-    if (pb12Options & PB12_OPT_VERBOSE) {
+    if (os->hw->config->options & PB12_OPT_VERBOSE) {
         printf("Wait sem count: %d\n", sem->count);
     }
     if (sem->count < 0) {
-        if (pb12Options & PB12_OPT_VERBOSE) {
+        if (os->hw->config->options & PB12_OPT_VERBOSE) {
             printf("Semaphore blocking process (%d)\n", pb12CurrentPid(os));
         }
 
         pb12MoveFromReady(os, &sem->sem_q, pb12CurrentPid(os));
+
+        /* Its memory can go to a program that is waiting for some. */
+        if (os->hw->config->options & PB12_OPT_SWAP)
+            pb12ReadyPrograms(os);
     }
 }
 
@@ -44,11 +49,11 @@ void pb12SemWait(PB12_Semaphore *sem, PB12_OS *os) {
 */
 void pb12SemSignal(PB12_Semaphore *sem, PB12_OS *os) {
     ++sem->count;
-    if (pb12Options & PB12_OPT_VERBOSE) {
+    if (os->hw->config->options & PB12_OPT_VERBOSE) {
         printf("Signal sem count: %d\n", sem->count);
     }
     if (sem->count <= 0) {
-        if (pb12Options & PB12_OPT_VERBOSE) {
+        if (os->hw->config->options & PB12_OPT_VERBOSE) {
             printf("Semaphore unblocking process (%d)\n", sem->sem_q.head->pid);
         }
 
@@ -9,10 +9,24 @@ void pb12PrintStats(PB12_ProcStat *stats, int count) {
     int start_sum;
     int duration_sum;
     int zeros;
+    long req_sum;
+    long alloc_sum;
+    unsigned long searched_sum;
+    long swap_outs;
+    long swap_ins;
+    long swap_out_bytes;
+    long swap_in_bytes;
 
     start_sum = 0;
     duration_sum = 0;
     zeros = 0;
+    req_sum = 0;
+    alloc_sum = 0;
+    searched_sum = 0;
+    swap_outs = 0;
+    swap_ins = 0;
+    swap_out_bytes = 0;
+    swap_in_bytes = 0;
 
     for(i=0; i<count; i++) {
         if(stats[i].start_time == 0) {
@@ -20,6 +34,13 @@ void pb12PrintStats(PB12_ProcStat *stats, int count) {
         }
         start_sum += stats[i].start_time;
         duration_sum += stats[i].end_time - stats[i].start_time;
+        req_sum += stats[i].mem_req;
+        alloc_sum += stats[i].mem_alloc;
+        searched_sum += stats[i].searched;
+        swap_outs += stats[i].swap_outs;
+        swap_ins += stats[i].swap_ins;
+        swap_out_bytes += stats[i].swap_out_bytes;
+        swap_in_bytes += stats[i].swap_in_bytes;
 
         printf("Process %d: start = %d, end = %d, duration = %d\n",
                i, stats[i].start_time, stats[i].end_time,
@@ -30,4 +51,19 @@ void pb12PrintStats(PB12_ProcStat *stats, int count) {
     printf("Average wait time: %f\n", start_sum / ((float)count));
     printf("Average non-zero wait time: %f\n", start_sum / ((float)(count - zeros)));
     printf("Average duration: %f\n", duration_sum/ ((float)count));
+
+    /* Only first fit and next fit search the list one block at a time. */
+    if (searched_sum > 0)
+        printf("Average search length: %f\n", searched_sum / ((float)count));
+
+    /* Words allocated that the processes did not ask for */
+    printf("Internal fragmentation: %ld of %ld words allocated (%f%%)\n",
+           alloc_sum - req_sum, alloc_sum,
+           alloc_sum > 0 ? 100.0 * (alloc_sum - req_sum) / alloc_sum : 0.0);
+
+    /* Only blocked processes are swapped, and only with -sw. */
+    if (swap_outs > 0) {
+        printf("Swapping: %ld swap outs (%ld bytes), %ld swap ins (%ld bytes)\n",
+               swap_outs, swap_out_bytes, swap_ins, swap_in_bytes);
+    }
 }
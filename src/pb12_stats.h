@@ -7,6 +7,13 @@
 typedef struct S_PB12_ProcStat {
     int start_time;
     int end_time;
+    int mem_req;        /* Words the process asked for */
+    int mem_alloc;      /* Words set aside for it, mem_req or more */
+    unsigned long searched; /* Free blocks first or next fit looked at for it */
+    int swap_outs;      /* Times it was swapped out */
+    int swap_ins;       /* Times it was swapped back in */
+    long swap_out_bytes;    /* Bytes written to the backing store for it */
+    long swap_in_bytes;     /* Bytes read back from the backing store */
 } PB12_ProcStat;
 
 
@@ -16,7 +16,13 @@ const char *pb12ErrorStr[] = {
     "ERROR: initializing memory.\n",
     "ERROR: initializing operating system.\n",
     "ERROR: PCB not found in list.\n",
-    "ERROR: Could not move first PCB to top.\n"
+    "ERROR: Could not move first PCB to top.\n",
+    "ERROR: JIT compiler not available on this machine.\n",
+    "ERROR: Translated programs not supported on this machine.\n",
+    "ERROR: Could not translate '%s', it will be interpreted.\n",
+    "ERROR: Could not initialize loop summarizer.\n",
+    "ERROR: No frame for page %d.\n",
+    "ERROR: Could not swap process (%d).\n"
 
 };
 
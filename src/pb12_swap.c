@@ -0,0 +1,200 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "pb12.h"
+#include "pb12_swap.h"
+
+/**
+    Open an empty backing store.
+
+    @param PB12_Swap *swap - Backing store.
+
+    @return int - PB12_SUCCESS or PB12_FAILURE
+*/
+int pb12InitSwap(PB12_Swap *swap) {
+    swap->end = 0;
+    swap->rooms = NULL;
+    swap->file = tmpfile();
+    if (swap->file == NULL)
+        return PB12_FAILURE;
+    return PB12_SUCCESS;
+}
+
+
+/**
+    Close the backing store, which removes its file.
+
+    @param PB12_Swap *swap - Backing store.
+*/
+void pb12DestroySwap(PB12_Swap *swap) {
+    PB12_SwapRoom *room;
+
+    if (swap->file != NULL)
+        fclose(swap->file);
+    swap->file = NULL;
+    while (swap->rooms != NULL) {
+        room = swap->rooms;
+        swap->rooms = room->next;
+        free(room);
+    }
+}
+
+
+/**
+    Give out room for a process in the backing store.  The shortest room
+    that has been given back and is long enough is used, and the file is
+    only made longer if there is none.
+
+    @param PB12_Swap *swap - Backing store.
+    @param int length - Words the process needs.
+
+    @return long - Word where its room begins.
+*/
+long pb12SwapReserve(PB12_Swap *swap, int length) {
+    PB12_SwapRoom **best;
+    PB12_SwapRoom **link;
+    PB12_SwapRoom *room;
+    long offset;
+
+    best = NULL;
+    for (link = &swap->rooms; *link != NULL; link = &(*link)->next) {
+        if ((*link)->length >= length && (best == NULL || (*link)->length < (*best)->length))
+            best = link;
+    }
+
+    if (best == NULL) {
+        offset = swap->end;
+        swap->end += length;
+        return offset;
+    }
+
+    /* The process takes the start of the room, and the rest stays free. */
+    room = *best;
+    offset = room->offset;
+    room->offset += length;
+    room->length -= length;
+    if (room->length == 0) {
+        *best = room->next;
+        free(room);
+    }
+    return offset;
+}
+
+
+/**
+    Give back the room of a process that has ended or outgrown it, so that
+    others can use it.  Rooms next to each other are joined.
+
+    @param PB12_Swap *swap - Backing store.
+    @param long offset - Word where the room begins, or -1 if there is none.
+    @param int length - Words in the room.
+*/
+void pb12SwapRelease(PB12_Swap *swap, long offset, int length) {
+    PB12_SwapRoom **link;
+    PB12_SwapRoom *prev;
+    PB12_SwapRoom *room;
+    PB12_SwapRoom *next;
+
+    if (offset < 0 || length <= 0)
+        return;
+
+    prev = NULL;
+    link = &swap->rooms;
+    while (*link != NULL && (*link)->offset < offset) {
+        prev = *link;
+        link = &(*link)->next;
+    }
+    next = *link;
+
+    if (prev != NULL && prev->offset + prev->length == offset) {
+        room = prev;
+        room->length += length;
+    }
+    else {
+        /* Without memory for the record, the room is just not reused. */
+        room = (PB12_SwapRoom*) malloc(sizeof(PB12_SwapRoom));
+        if (room == NULL)
+            return;
+        room->offset = offset;
+        room->length = length;
+        room->next = next;
+        *link = room;
+    }
+
+    if (next != NULL && room->offset + room->length == next->offset) {
+        room->length += next->length;
+        room->next = next->next;
+        free(next);
+    }
+
+    /* Room at the end of the file is given back to the file. */
+    if (room->next == NULL && room->offset + room->length == swap->end) {
+        swap->end = room->offset;
+        for (link = &swap->rooms; *link != room; link = &(*link)->next)
+            ;
+        *link = NULL;
+        free(room);
+    }
+}
+
+
+/**
+    Write words of memory to the backing store.
+
+    @param PB12_Swap *swap - Backing store.
+    @param PB12_MEM *mem - Memory.
+    @param long offset - Word of the backing store to write to.
+    @param int address - First word of memory.
+    @param int length - Number of words.
+
+    @return long - Bytes written, or -1 if they could not all be
+*/
+long pb12SwapWrite(PB12_Swap *swap, PB12_MEM *mem, long offset, int address, int length) {
+    char words[PB12_SWAP_CHUNK][PB12_SWAP_WORD];
+    int count;
+    int i;
+    int j;
+
+    if (fseek(swap->file, offset * PB12_SWAP_WORD, SEEK_SET) != 0)
+        return -1;
+    for (i=0; i<length; i+=count) {
+        count = length - i < PB12_SWAP_CHUNK ? length - i : PB12_SWAP_CHUNK;
+        for (j=0; j<count; j++)
+            pb12GetMemWord(mem, address + i + j, words[j]);
+        if (fwrite(words, PB12_SWAP_WORD, count, swap->file) != (size_t)count)
+            return -1;
+    }
+    if (fflush(swap->file) != 0)
+        return -1;
+    return (long)length * PB12_SWAP_WORD;
+}
+
+
+/**
+    Read words from the backing store back into memory, which need not be
+    where they were written from.
+
+    @param PB12_Swap *swap - Backing store.
+    @param PB12_MEM *mem - Memory.
+    @param long offset - Word of the backing store to read from.
+    @param int address - First word of memory.
+    @param int length - Number of words.
+
+    @return long - Bytes read, or -1 if they could not all be
+*/
+long pb12SwapRead(PB12_Swap *swap, PB12_MEM *mem, long offset, int address, int length) {
+    char words[PB12_SWAP_CHUNK][PB12_SWAP_WORD];
+    int count;
+    int i;
+    int j;
+
+    if (fseek(swap->file, offset * PB12_SWAP_WORD, SEEK_SET) != 0)
+        return -1;
+    for (i=0; i<length; i+=count) {
+        count = length - i < PB12_SWAP_CHUNK ? length - i : PB12_SWAP_CHUNK;
+        if (fread(words, PB12_SWAP_WORD, count, swap->file) != (size_t)count)
+            return -1;
+        for (j=0; j<count; j++)
+            pb12PutMemWord(mem, address + i + j, words[j]);
+    }
+    return (long)length * PB12_SWAP_WORD;
+}
@@ -0,0 +1,104 @@
+#ifndef PB12_SWAP_H
+#define PB12_SWAP_H
+
+#include <stdio.h>
+#include "pb12.h"
+#include "pb12_mem.h"
+
+#define PB12_SWAP_WORD      6       /* Bytes of the backing file per word */
+#define PB12_SWAP_CHUNK     64      /* Words read or written at a time */
+
+/* Room in the backing store that has been given back */
+typedef struct S_PB12_SwapRoom {
+    long offset;                /* Word where it begins */
+    long length;                /* Words in it */
+    struct S_PB12_SwapRoom *next;   /* Next room, further into the file */
+} PB12_SwapRoom;
+
+/*
+    Backing store for the memory of swapped out processes.  It is a
+    temporary file that is removed when the VM is destroyed.  Each process
+    is given room in it the first time it is swapped out, as many words as
+    its block, and uses the same room every time after that until it ends
+    or grows.  Room that is given back is reused for the next process that
+    fits in it, so the file only grows when none does.  Words are kept as their
+    six characters, so they do not depend on how memory packs them.
+*/
+typedef struct S_PB12_Swap {
+    FILE *file;                 /* Backing file */
+    long end;                   /* Words of the file given out so far */
+    PB12_SwapRoom *rooms;       /* Room given back, in order of offset */
+} PB12_Swap;
+
+
+/**
+    Open an empty backing store.
+
+    @param PB12_Swap *swap - Backing store.
+
+    @return int - PB12_SUCCESS or PB12_FAILURE
+*/
+int pb12InitSwap(PB12_Swap *swap);
+
+
+/**
+    Close the backing store, which removes its file.
+
+    @param PB12_Swap *swap - Backing store.
+*/
+void pb12DestroySwap(PB12_Swap *swap);
+
+
+/**
+    Give out room for a process in the backing store.  The shortest room
+    that has been given back and is long enough is used, and the file is
+    only made longer if there is none.
+
+    @param PB12_Swap *swap - Backing store.
+    @param int length - Words the process needs.
+
+    @return long - Word where its room begins.
+*/
+long pb12SwapReserve(PB12_Swap *swap, int length);
+
+
+/**
+    Give back the room of a process that has ended or outgrown it, so that
+    others can use it.  Rooms next to each other are joined.
+
+    @param PB12_Swap *swap - Backing store.
+    @param long offset - Word where the room begins, or -1 if there is none.
+    @param int length - Words in the room.
+*/
+void pb12SwapRelease(PB12_Swap *swap, long offset, int length);
+
+
+/**
+    Write words of memory to the backing store.
+
+    @param PB12_Swap *swap - Backing store.
+    @param PB12_MEM *mem - Memory.
+    @param long offset - Word of the backing store to write to.
+    @param int address - First word of memory.
+    @param int length - Number of words.
+
+    @return long - Bytes written, or -1 if they could not all be
+*/
+long pb12SwapWrite(PB12_Swap *swap, PB12_MEM *mem, long offset, int address, int length);
+
+
+/**
+    Read words from the backing store back into memory, which need not be
+    where they were written from.
+
+    @param PB12_Swap *swap - Backing store.
+    @param PB12_MEM *mem - Memory.
+    @param long offset - Word of the backing store to read from.
+    @param int address - First word of memory.
+    @param int length - Number of words.
+
+    @return long - Bytes read, or -1 if they could not all be
+*/
+long pb12SwapRead(PB12_Swap *swap, PB12_MEM *mem, long offset, int address, int length);
+
+#endif /* PB12_SWAP_H */
@@ -0,0 +1,153 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "pb12.h"
+#include "pb12_telemetry.h"
+
+/**
+    Initialize telemetry with no samples.
+
+    @param PB12_Telemetry *telemetry - Telemetry.
+
+    @return int - PB12_SUCCESS or PB12_FAILURE
+*/
+int pb12InitTelemetry(PB12_Telemetry *telemetry) {
+    telemetry->count = 0;
+    telemetry->capacity = PB12_TELEMETRY_SAMPLES;
+    telemetry->samples = (PB12_AllocSample*) malloc(telemetry->capacity * sizeof(PB12_AllocSample));
+    if (telemetry->samples == NULL)
+        return PB12_FAILURE;
+    return PB12_SUCCESS;
+}
+
+
+/**
+    Free the samples of telemetry.
+
+    @param PB12_Telemetry *telemetry - Telemetry.
+*/
+void pb12DestroyTelemetry(PB12_Telemetry *telemetry) {
+    free(telemetry->samples);
+    telemetry->samples = NULL;
+    telemetry->count = 0;
+    telemetry->capacity = 0;
+}
+
+
+/**
+    Add a sample, replacing the last one if it was taken at the same tick.
+
+    @param PB12_Telemetry *telemetry - Telemetry.
+    @param const PB12_AllocSample *sample - Sample.
+
+    @return int - PB12_SUCCESS, or PB12_FAILURE if there is no room for it
+*/
+int pb12TelemetrySample(PB12_Telemetry *telemetry, const PB12_AllocSample *sample) {
+    PB12_AllocSample *samples;
+
+    if (telemetry->count > 0 &&
+        telemetry->samples[telemetry->count - 1].tick == sample->tick) {
+        telemetry->samples[telemetry->count - 1] = *sample;
+        return PB12_SUCCESS;
+    }
+
+    if (telemetry->count == telemetry->capacity) {
+        samples = (PB12_AllocSample*) realloc(telemetry->samples,
+                                              2 * telemetry->capacity * sizeof(PB12_AllocSample));
+        if (samples == NULL)
+            return PB12_FAILURE;
+        telemetry->samples = samples;
+        telemetry->capacity *= 2;
+    }
+
+    telemetry->samples[telemetry->count++] = *sample;
+    return PB12_SUCCESS;
+}
+
+
+/**
+    Gives the external fragmentation of a sample: the part of free memory
+    that is not in the largest free block.
+
+    @param const PB12_AllocSample *sample - Sample.
+
+    @return double - Ratio from 0 to 1.
+*/
+static double pb12TelemetryFragmentation(const PB12_AllocSample *sample) {
+    if (sample->free_words == 0)
+        return 0.0;
+    return (double)(sample->free_words - sample->largest) / sample->free_words;
+}
+
+
+/**
+    Gives the blocks looked at per allocation, up to a sample.
+
+    @param const PB12_AllocSample *sample - Sample.
+
+    @return double - Average blocks looked at.
+*/
+static double pb12TelemetryVisits(const PB12_AllocSample *sample) {
+    if (sample->allocs + sample->failed == 0)
+        return 0.0;
+    return (double)sample->visited / (sample->allocs + sample->failed);
+}
+
+
+/**
+    Write the samples to a file, as JSON if its name ends in .json and as
+    CSV otherwise.
+
+    @param const PB12_Telemetry *telemetry - Telemetry.
+    @param const char *path - Name of the file.
+
+    @return int - PB12_SUCCESS or PB12_FAILURE
+*/
+int pb12WriteTelemetry(const PB12_Telemetry *telemetry, const char *path) {
+    const PB12_AllocSample *sample;
+    FILE *file;
+    size_t length;
+    int json;
+    int i;
+
+    length = strlen(path);
+    json = length >= 5 && strcmp(&path[length - 5], ".json") == 0;
+
+    file = fopen(path, "w");
+    if (file == NULL)
+        return PB12_FAILURE;
+
+    if (json)
+        fprintf(file, "[\n");
+    else
+        fprintf(file, "tick,holes,largest_hole,free_words,external_fragmentation,"
+                      "allocations,visited,visited_per_allocation,failed_allocations,merges\n");
+
+    for (i=0; i<telemetry->count; i++) {
+        sample = &telemetry->samples[i];
+        if (json) {
+            fprintf(file, "  {\"tick\": %lu, \"holes\": %d, \"largest_hole\": %d, "
+                          "\"free_words\": %d, \"external_fragmentation\": %.6f, "
+                          "\"allocations\": %lu, \"visited\": %lu, "
+                          "\"visited_per_allocation\": %.6f, \"failed_allocations\": %lu, "
+                          "\"merges\": %lu}%s\n",
+                    sample->tick, sample->holes, sample->largest, sample->free_words,
+                    pb12TelemetryFragmentation(sample), sample->allocs, sample->visited,
+                    pb12TelemetryVisits(sample), sample->failed, sample->merges,
+                    i + 1 < telemetry->count ? "," : "");
+        }
+        else {
+            fprintf(file, "%lu,%d,%d,%d,%.6f,%lu,%lu,%.6f,%lu,%lu\n",
+                    sample->tick, sample->holes, sample->largest, sample->free_words,
+                    pb12TelemetryFragmentation(sample), sample->allocs, sample->visited,
+                    pb12TelemetryVisits(sample), sample->failed, sample->merges);
+        }
+    }
+
+    if (json)
+        fprintf(file, "]\n");
+
+    if (fclose(file) != 0)
+        return PB12_FAILURE;
+    return PB12_SUCCESS;
+}
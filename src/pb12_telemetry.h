@@ -0,0 +1,74 @@
+#ifndef PB12_TELEMETRY_H
+#define PB12_TELEMETRY_H
+
+#include "pb12.h"
+
+#define PB12_TELEMETRY_SAMPLES  256     /* Samples room is first made for */
+
+/* The allocator as it was after the events of one clock tick */
+typedef struct S_PB12_AllocSample {
+    unsigned long tick;         /* Clock tick it was taken at */
+    int holes;                  /* Free blocks */
+    int largest;                /* Words in the largest free block */
+    int free_words;             /* Words free, all told */
+    unsigned long allocs;       /* Blocks allocated so far */
+    unsigned long visited;      /* Blocks or free lists the allocator has looked at so far */
+    unsigned long failed;       /* Allocations that found no block so far */
+    unsigned long merges;       /* Free blocks joined when blocks were freed so far */
+} PB12_AllocSample;
+
+/*
+    Time series of the allocator, kept in memory while the VM runs and
+    written out when it is done.  A sample is taken after every allocation,
+    free, wait and compaction; nothing else changes the allocator, so the
+    samples are what it was at every tick in between.  Samples taken at the
+    same tick are kept as one, the last of them.
+*/
+typedef struct S_PB12_Telemetry {
+    PB12_AllocSample *samples;  /* Samples, in the order they were taken */
+    int count;                  /* Samples taken */
+    int capacity;               /* Samples there is room for */
+} PB12_Telemetry;
+
+
+/**
+    Initialize telemetry with no samples.
+
+    @param PB12_Telemetry *telemetry - Telemetry.
+
+    @return int - PB12_SUCCESS or PB12_FAILURE
+*/
+int pb12InitTelemetry(PB12_Telemetry *telemetry);
+
+
+/**
+    Free the samples of telemetry.
+
+    @param PB12_Telemetry *telemetry - Telemetry.
+*/
+void pb12DestroyTelemetry(PB12_Telemetry *telemetry);
+
+
+/**
+    Add a sample, replacing the last one if it was taken at the same tick.
+
+    @param PB12_Telemetry *telemetry - Telemetry.
+    @param const PB12_AllocSample *sample - Sample.
+
+    @return int - PB12_SUCCESS, or PB12_FAILURE if there is no room for it
+*/
+int pb12TelemetrySample(PB12_Telemetry *telemetry, const PB12_AllocSample *sample);
+
+
+/**
+    Write the samples to a file, as JSON if its name ends in .json and as
+    CSV otherwise.
+
+    @param const PB12_Telemetry *telemetry - Telemetry.
+    @param const char *path - Name of the file.
+
+    @return int - PB12_SUCCESS or PB12_FAILURE
+*/
+int pb12WriteTelemetry(const PB12_Telemetry *telemetry, const char *path);
+
+#endif /* PB12_TELEMETRY_H */
@@ -0,0 +1,619 @@
+#include <stdio.h>
+#include <string.h>
+#include "pb12.h"
+#include "pb12_threaded.h"
+#include "pb12_cpu.h"
+#include "pb12_hw.h"
+#include "pb12_mem.h"
+#include "pb12_decode.h"
+#include "pb12_strings.h"
+
+/*
+    The instruction handlers below are written once and expanded two ways.
+    With GCC style labels as values every handler is a label and ends by
+    fetching and jumping to the next handler itself, so each opcode gets its
+    own indirect jump.  Otherwise every handler is a function and a loop
+    calls them through a table.  Define PB12_NO_COMPUTED_GOTO to force the
+    call-threaded version.
+*/
+#if defined(__GNUC__) && !defined(PB12_NO_COMPUTED_GOTO)
+    #define PB12_COMPUTED_GOTO
+#endif
+
+
+/*
+    Fetch the instruction at pc, the same as pb12Fetch().  The decoded entry
+    also has to know which superinstruction (if any) starts at this word.
+*/
+#define PB12_FETCH() \
+    cpu->ear = cpu->bar + cpu->pc; \
+    dec = &mem->decoded[cpu->ear]; \
+    if (!(dec->flags & PB12_DEC_FUSED)) \
+        pb12FuseDecoded(mem, cpu->ear); \
+    memcpy(cpu->ir, dec->text, 6); \
+    --cpu->ic; \
+    PB12_RETIRE(); \
+    if (PB12_TRACED) \
+        pb12TraceInst(cpu, dec->opcode)
+
+/*
+    Fetch the next word of a superinstruction.  Its decoded entry directly
+    follows the current one and is known to be valid.
+*/
+#define PB12_FETCH_FUSED() \
+    cpu->ear = cpu->bar + cpu->pc; \
+    ++dec; \
+    memcpy(cpu->ir, dec->text, 6); \
+    --cpu->ic; \
+    PB12_RETIRE(); \
+    ++cpu->pc
+
+/*
+    A superinstruction of n words only runs when the time slice has room for
+    all of them, so that the OS sees the same slice boundaries.  Traced runs
+    show every instruction, so they are never fused.
+*/
+#define PB12_FUSED_GUARD(n) \
+    if ((cpu->ic < (n) - 1 && cpu->ic >= 0) || PB12_TRACED) \
+        PB12_UNFUSED();
+
+
+#ifdef PB12_COMPUTED_GOTO
+
+    #define PB12_DISPATCH() __extension__ ({ goto *handlers[dec->xop]; })
+
+    #define PB12_UNFUSED() __extension__ ({ goto *handlers[dec->op]; })
+
+    #define PB12_ENTRY(name) pb12Op##name:
+
+    #define PB12_RETIRE() ++retired
+
+    #define PB12_NEXT \
+        if (--count == 0 || cpu->ic == 0) \
+            goto done; \
+        PB12_FETCH(); \
+        PB12_DISPATCH();
+
+    #define PB12_STOP(ret) { status = ret; goto done; }
+
+    /* End the slice if a store wrote a word the process's proof relies on. */
+    #define PB12_STORED() \
+        if (mem->proof_writes[cpu->bar] != writes) \
+            PB12_STOP(PB12_SUCCESS)
+
+#else
+
+    #define PB12_UNFUSED() return PB12_HANDLER_TABLE[dec->op](cpu, hw, dec)
+
+    #define PB12_ENTRY(name) \
+        static int PB12_OP(name)(PB12_CPU *cpu, PB12_HW *hw, PB12_Decoded *dec) { \
+            PB12_MEM *mem = &hw->mem; \
+            (void)mem; \
+            (void)dec;
+
+    #define PB12_RETIRE() ++hw->retired
+
+    #define PB12_NEXT return PB12_SUCCESS; }
+
+    #define PB12_STOP(ret) return ret;
+
+    #define PB12_STORED()
+
+#endif
+
+#define PB12_HANDLER(name) PB12_ENTRY(name) ++cpu->pc;
+#define PB12_FAIL(err) { pb12ErrorMsg(hw->config, pb12ErrorStr[err]); PB12_STOP(PB12_FAILURE) }
+
+/* Get pointer register of an operand into var, failing if there is none. */
+#define PB12_PTR(var, n, err) \
+    var = pb12GetPtrReg(cpu, dec->ptr[n]); \
+    if (!var) \
+        PB12_FAIL(err)
+
+/* Get general register of an operand into var, failing if there is none. */
+#define PB12_GEN(var, n, err) \
+    var = pb12GetGenReg(cpu, dec->gen[n]); \
+    if (!var) \
+        PB12_FAIL(err)
+
+/* Get direct address of an operand into var, failing if out of memory. */
+#define PB12_ADDR(var, n) \
+    var = dec->operand[n]; \
+    if (var >= mem->mem_size) \
+        PB12_FAIL(PB12_ERROR_INVALID_ADDR)
+
+
+/*
+    Instruction handlers, in the same order as the opcodes.  The handler
+    bodies match the cases of pb12Execute().  They are followed by the
+    superinstructions, which run each of their words exactly as the single
+    handlers would, or hand over to the handler of their first word, and
+    then by the unchecked memory instructions.
+*/
+#define PB12_HANDLERS \
+    PB12_HANDLER(LodPtrI)       /* 0 - Load Pointer Immediate */ \
+    { \
+        short int *ptr; \
+        PB12_PTR(ptr, 0, PB12_ERROR_INVALID_PTR_1); \
+        *ptr = dec->operand[1]; \
+    } \
+    PB12_NEXT \
+    \
+    PB12_HANDLER(AddPtrI)       /* 1 - Add to Pointer Immediate */ \
+    { \
+        short int *ptr; \
+        PB12_PTR(ptr, 0, PB12_ERROR_INVALID_PTR_1); \
+        *ptr += dec->operand[1]; \
+        if (*ptr > 99) \
+            *ptr -= 100; \
+    } \
+    PB12_NEXT \
+    \
+    PB12_HANDLER(SubPtrI)       /* 2 - Subtract from Pointer Immediate */ \
+    { \
+        short int *ptr; \
+        PB12_PTR(ptr, 0, PB12_ERROR_INVALID_PTR_1); \
+        *ptr -= dec->operand[1]; \
+        if (*ptr < 0) \
+            *ptr += 100; \
+    } \
+    PB12_NEXT \
+    \
+    PB12_HANDLER(LodAccI)       /* 3 - Load Accumulator Immediate */ \
+        cpu->acc = dec->value; \
+    PB12_NEXT \
+    \
+    PB12_HANDLER(LodAccR)       /* 4 - Load Accumulator Register Addressing */ \
+    { \
+        short int *ptr; \
+        PB12_PTR(ptr, 0, PB12_ERROR_INVALID_PTR_1); \
+        cpu->acc = pb12GetMemOp(cpu, mem, *ptr); \
+    } \
+    PB12_NEXT \
+    \
+    PB12_HANDLER(LodAccD)       /* 5 - Load Accumulator Direct Addressing */ \
+    { \
+        int addr; \
+        PB12_ADDR(addr, 0); \
+        cpu->acc = pb12GetMemOp(cpu, mem, addr); \
+    } \
+    PB12_NEXT \
+    \
+    PB12_HANDLER(StoAccR)       /* 6 - Store Accumulator Register Addressing */ \
+    { \
+        short int *ptr; \
+        PB12_PTR(ptr, 0, PB12_ERROR_INVALID_PTR_1); \
+        pb12PutMemOp(cpu, mem, *ptr, cpu->acc); \
+        PB12_STORED(); \
+    } \
+    PB12_NEXT \
+    \
+    PB12_HANDLER(StoAccD)       /* 7 - Store Accumulator Direct Addressing */ \
+    { \
+        int addr; \
+        PB12_ADDR(addr, 0); \
+        pb12PutMemOp(cpu, mem, addr, cpu->acc); \
+        PB12_STORED(); \
+    } \
+    PB12_NEXT \
+    \
+    PB12_HANDLER(StoRegR)       /* 8 - Store Register to Memory: Register Addressing */ \
+    { \
+        int *gen; \
+        short int *ptr; \
+        PB12_GEN(gen, 0, PB12_ERROR_INVALID_REG_1); \
+        PB12_PTR(ptr, 1, PB12_ERROR_INVALID_PTR_2); \
+        pb12PutMemOp(cpu, mem, *ptr, *gen); \
+        PB12_STORED(); \
+    } \
+    PB12_NEXT \
+    \
+    PB12_HANDLER(StoRegD)       /* 9 - Store Register to Memory: Direct Addressing */ \
+    { \
+        int *gen; \
+        int addr; \
+        PB12_GEN(gen, 0, PB12_ERROR_INVALID_REG_1); \
+        PB12_ADDR(addr, 1); \
+        pb12PutMemOp(cpu, mem, addr, *gen); \
+        PB12_STORED(); \
+    } \
+    PB12_NEXT \
+    \
+    PB12_HANDLER(LodRegR)       /* 10 - Load Register from Memory: Register Addressing */ \
+    { \
+        int *gen; \
+        short int *ptr; \
+        PB12_GEN(gen, 0, PB12_ERROR_INVALID_REG_1); \
+        PB12_PTR(ptr, 1, PB12_ERROR_INVALID_PTR_2); \
+        *gen = pb12GetMemOp(cpu, mem, *ptr); \
+    } \
+    PB12_NEXT \
+    \
+    PB12_HANDLER(LodRegD)       /* 11 - Load Register from Memory: Direct Addressing */ \
+    { \
+        int *gen; \
+        int addr; \
+        PB12_GEN(gen, 0, PB12_ERROR_INVALID_REG_1); \
+        PB12_ADDR(addr, 1); \
+        *gen = pb12GetMemOp(cpu, mem, addr); \
+    } \
+    PB12_NEXT \
+    \
+    PB12_HANDLER(LodRegR0I)     /* 12 - Load Register R0 Immediate */ \
+        cpu->r0 = dec->value; \
+    PB12_NEXT \
+    \
+    PB12_HANDLER(TraRegReg)     /* 13 - Register to Register Transfer */ \
+    { \
+        int *gen1; \
+        int *gen2; \
+        PB12_GEN(gen1, 0, PB12_ERROR_INVALID_REG_1); \
+        PB12_GEN(gen2, 1, PB12_ERROR_INVALID_REG_2); \
+        *gen1 = *gen2; \
+    } \
+    PB12_NEXT \
+    \
+    PB12_HANDLER(LodAccReg)     /* 14 - Load Accumulator from Register */ \
+    { \
+        int *gen; \
+        PB12_GEN(gen, 0, PB12_ERROR_INVALID_REG_1); \
+        cpu->acc = *gen; \
+    } \
+    PB12_NEXT \
+    \
+    PB12_HANDLER(LodRegAcc)     /* 15 - Load Register from Accumulator */ \
+    { \
+        int *gen; \
+        PB12_GEN(gen, 0, PB12_ERROR_INVALID_REG_1); \
+        *gen = cpu->acc; \
+    } \
+    PB12_NEXT \
+    \
+    PB12_HANDLER(AddAccI)       /* 16 - Add Accumulator Immediate */ \
+        cpu->acc += dec->value; \
+        if (cpu->acc > 9999) \
+            cpu->acc -= 10000; \
+    PB12_NEXT \
+    \
+    PB12_HANDLER(SubAccI)       /* 17 - Subtract Accumulator Immediate */ \
+        cpu->acc -= dec->value; \
+        if (cpu->acc < 0) \
+            cpu->acc += 10000; \
+    PB12_NEXT \
+    \
+    PB12_HANDLER(AddAccReg)     /* 18 - Add contents of Register from Accumulator */ \
+    { \
+        int *gen; \
+        PB12_GEN(gen, 0, PB12_ERROR_INVALID_REG_1); \
+        cpu->acc += *gen; \
+        if (cpu->acc > 9999) \
+            cpu->acc -= 10000; \
+    } \
+    PB12_NEXT \
+    \
+    PB12_HANDLER(SubAccReg)     /* 19 - Subtract contents of Register from Accumulator */ \
+    { \
+        int *gen; \
+        PB12_GEN(gen, 0, PB12_ERROR_INVALID_REG_1); \
+        cpu->acc -= *gen; \
+        if (cpu->acc < 0) \
+            cpu->acc += 10000; \
+    } \
+    PB12_NEXT \
+    \
+    PB12_HANDLER(AddAccR)       /* 20 - Add Accumulator Register Addressing */ \
+    { \
+        short int *ptr; \
+        PB12_PTR(ptr, 0, PB12_ERROR_INVALID_PTR_1); \
+        cpu->acc += pb12GetMemOp(cpu, mem, *ptr); \
+        if (cpu->acc > 9999) \
+            cpu->acc -= 9999; \
+    } \
+    PB12_NEXT \
+    \
+    PB12_HANDLER(AddAccD)       /* 21 - Add Accumulator Direct Addressing */ \
+    { \
+        int addr; \
+        PB12_ADDR(addr, 0); \
+        cpu->acc += pb12GetMemOp(cpu, mem, addr); \
+        if (cpu->acc > 9999) \
+            cpu->acc -= 10000; \
+    } \
+    PB12_NEXT \
+    \
+    PB12_HANDLER(SubAccR)       /* 22 - Subtract from Accumulator Register Addressing */ \
+    { \
+        short int *ptr; \
+        PB12_PTR(ptr, 0, PB12_ERROR_INVALID_PTR_1); \
+        cpu->acc -= pb12GetMemOp(cpu, mem, *ptr); \
+        if (cpu->acc < 0) \
+            cpu->acc += 10000; \
+    } \
+    PB12_NEXT \
+    \
+    PB12_HANDLER(SubAccD)       /* 23 - Subtract from Accumulator Direct Addressing */ \
+    { \
+        int addr; \
+        PB12_ADDR(addr, 0); \
+        cpu->acc -= pb12GetMemOp(cpu, mem, addr); \
+        if (cpu->acc < 0) \
+            cpu->acc += 10000; \
+    } \
+    PB12_NEXT \
+    \
+    PB12_HANDLER(EquR)          /* 24 - Compare Equal Register Addressing */ \
+    { \
+        short int *ptr; \
+        PB12_PTR(ptr, 0, PB12_ERROR_INVALID_PTR_1); \
+        cpu->psw[0] = cpu->acc == pb12GetMemOp(cpu, mem, *ptr) ? 'T' : 'F'; \
+    } \
+    PB12_NEXT \
+    \
+    PB12_HANDLER(LesR)          /* 25 - Compare Less Register Addressing */ \
+    { \
+        short int *ptr; \
+        PB12_PTR(ptr, 0, PB12_ERROR_INVALID_PTR_1); \
+        cpu->psw[0] = cpu->acc < pb12GetMemOp(cpu, mem, *ptr) ? 'T' : 'F'; \
+    } \
+    PB12_NEXT \
+    \
+    PB12_HANDLER(GreR)          /* 26 - Compare Greater Register Addressing */ \
+    { \
+        short int *ptr; \
+        PB12_PTR(ptr, 0, PB12_ERROR_INVALID_PTR_1); \
+        cpu->psw[0] = cpu->acc > pb12GetMemOp(cpu, mem, *ptr) ? 'T' : 'F'; \
+    } \
+    PB12_NEXT \
+    \
+    PB12_HANDLER(GreI)          /* 27 - Compare Greater Immediate */ \
+        cpu->psw[0] = cpu->acc > dec->value ? 'T' : 'F'; \
+    PB12_NEXT \
+    \
+    PB12_HANDLER(EquI)          /* 28 - Compare Equal Immediate */ \
+        cpu->psw[0] = cpu->acc == dec->value ? 'T' : 'F'; \
+    PB12_NEXT \
+    \
+    PB12_HANDLER(LesI)          /* 29 - Compare Less Immediate */ \
+        cpu->psw[0] = cpu->acc < dec->value ? 'T' : 'F'; \
+    PB12_NEXT \
+    \
+    PB12_HANDLER(EquReg)        /* 30 - Compare Register Equal */ \
+    { \
+        int *gen; \
+        PB12_GEN(gen, 0, PB12_ERROR_INVALID_REG_1); \
+        cpu->psw[0] = cpu->acc == *gen ? 'T' : 'F'; \
+    } \
+    PB12_NEXT \
+    \
+    PB12_HANDLER(LesReg)        /* 31 - Compare Register Less */ \
+    { \
+        int *gen; \
+        PB12_GEN(gen, 0, PB12_ERROR_INVALID_REG_1); \
+        cpu->psw[0] = cpu->acc < *gen ? 'T' : 'F'; \
+    } \
+    PB12_NEXT \
+    \
+    PB12_HANDLER(GreReg)        /* 32 - Compare Register Greater */ \
+    { \
+        int *gen; \
+        PB12_GEN(gen, 0, PB12_ERROR_INVALID_REG_1); \
+        cpu->psw[0] = cpu->acc > *gen ? 'T' : 'F'; \
+    } \
+    PB12_NEXT \
+    \
+    PB12_HANDLER(Brt)           /* 33 - Branch Condition True */ \
+        if (cpu->psw[0] == 'T') \
+            cpu->pc = dec->operand[0]; \
+    PB12_NEXT \
+    \
+    PB12_HANDLER(Brf)           /* 34 - Branch Condition False */ \
+        if (cpu->psw[0] == 'F') \
+            cpu->pc = dec->operand[0]; \
+    PB12_NEXT \
+    \
+    PB12_HANDLER(Bru)           /* 35 - Branch Unconditional */ \
+        cpu->pc = dec->operand[0]; \
+    PB12_NEXT \
+    \
+    PB12_HANDLER(Trap)          /* 36 - OS Trap Instruction */ \
+    { \
+        int *gen; \
+        PB12_GEN(gen, 0, PB12_ERROR_INVALID_REG_1); \
+        hw->trap_num = *gen; \
+        hw->trap_op = dec->reg; \
+    } \
+    /* The OS has to respond to the trap before anything else runs. */ \
+    PB12_STOP(PB12_SUCCESS) \
+    PB12_NEXT \
+    \
+    PB12_HANDLER(Mod)           /* 37 - Modulo Operator */ \
+    { \
+        int *gen1; \
+        int *gen2; \
+        PB12_GEN(gen1, 0, PB12_ERROR_INVALID_REG_1); \
+        PB12_GEN(gen2, 1, PB12_ERROR_INVALID_REG_2); \
+        cpu->acc = *gen1 % *gen2; \
+    } \
+    PB12_NEXT \
+    \
+    PB12_HANDLER(Invalid)       /* Any other opcode */ \
+        PB12_FAIL(PB12_ERROR_INVALID_OPCODE) \
+    PB12_NEXT \
+    \
+    PB12_ENTRY(GreIBr)          /* 27 then 33 or 34 */ \
+        PB12_FUSED_GUARD(2) \
+        ++cpu->pc; \
+        cpu->psw[0] = cpu->acc > dec->value ? 'T' : 'F'; \
+        PB12_FETCH_FUSED(); \
+        if (cpu->psw[0] == (dec->op == PB12_BRT ? 'T' : 'F')) \
+            cpu->pc = dec->operand[0]; \
+    PB12_NEXT \
+    \
+    PB12_ENTRY(EquIBr)          /* 28 then 33 or 34 */ \
+        PB12_FUSED_GUARD(2) \
+        ++cpu->pc; \
+        cpu->psw[0] = cpu->acc == dec->value ? 'T' : 'F'; \
+        PB12_FETCH_FUSED(); \
+        if (cpu->psw[0] == (dec->op == PB12_BRT ? 'T' : 'F')) \
+            cpu->pc = dec->operand[0]; \
+    PB12_NEXT \
+    \
+    PB12_ENTRY(LesIBr)          /* 29 then 33 or 34 */ \
+        PB12_FUSED_GUARD(2) \
+        ++cpu->pc; \
+        cpu->psw[0] = cpu->acc < dec->value ? 'T' : 'F'; \
+        PB12_FETCH_FUSED(); \
+        if (cpu->psw[0] == (dec->op == PB12_BRT ? 'T' : 'F')) \
+            cpu->pc = dec->operand[0]; \
+    PB12_NEXT \
+    \
+    PB12_ENTRY(RegAddI)         /* 14 then 16 then 15 */ \
+        PB12_FUSED_GUARD(3) \
+        ++cpu->pc; \
+        cpu->acc = *pb12GetGenReg(cpu, dec->gen[0]); \
+        PB12_FETCH_FUSED(); \
+        cpu->acc += dec->value; \
+        if (cpu->acc > 9999) \
+            cpu->acc -= 10000; \
+        PB12_FETCH_FUSED(); \
+        *pb12GetGenReg(cpu, dec->gen[0]) = cpu->acc; \
+    PB12_NEXT \
+    \
+    PB12_ENTRY(RegSubI)         /* 14 then 17 then 15 */ \
+        PB12_FUSED_GUARD(3) \
+        ++cpu->pc; \
+        cpu->acc = *pb12GetGenReg(cpu, dec->gen[0]); \
+        PB12_FETCH_FUSED(); \
+        cpu->acc -= dec->value; \
+        if (cpu->acc < 0) \
+            cpu->acc += 10000; \
+        PB12_FETCH_FUSED(); \
+        *pb12GetGenReg(cpu, dec->gen[0]) = cpu->acc; \
+    PB12_NEXT \
+    \
+    PB12_UNCHECKED_HANDLERS
+
+
+/* Pointer register and memory operand of an instruction proved in range */
+#define PB12_PTR_U(n) (*pb12GetPtrReg(cpu, dec->ptr[n]))
+#define PB12_GET_U(addr) pb12GetMemOpUnchecked(cpu, mem, addr)
+#define PB12_PUT_U(addr, value) pb12PutMemOpUnchecked(cpu, mem, addr, value)
+
+/*
+    Memory instructions whose registers and addresses pb12VerifyProgram()
+    proved valid and inside the process's block, so none of them are
+    checked.  Apart from that they match the handlers above.
+*/
+#define PB12_UNCHECKED_HANDLERS \
+    PB12_HANDLER(LodAccRU)      /* 4 */ \
+        cpu->acc = PB12_GET_U(PB12_PTR_U(0)); \
+    PB12_NEXT \
+    \
+    PB12_HANDLER(LodAccDU)      /* 5 */ \
+        cpu->acc = PB12_GET_U(dec->operand[0]); \
+    PB12_NEXT \
+    \
+    PB12_HANDLER(StoAccRU)      /* 6 */ \
+        PB12_PUT_U(PB12_PTR_U(0), cpu->acc); \
+    PB12_NEXT \
+    \
+    PB12_HANDLER(StoAccDU)      /* 7 */ \
+        PB12_PUT_U(dec->operand[0], cpu->acc); \
+    PB12_NEXT \
+    \
+    PB12_HANDLER(StoRegRU)      /* 8 */ \
+        PB12_PUT_U(PB12_PTR_U(1), *pb12GetGenReg(cpu, dec->gen[0])); \
+    PB12_NEXT \
+    \
+    PB12_HANDLER(StoRegDU)      /* 9 */ \
+        PB12_PUT_U(dec->operand[1], *pb12GetGenReg(cpu, dec->gen[0])); \
+    PB12_NEXT \
+    \
+    PB12_HANDLER(LodRegRU)      /* 10 */ \
+        *pb12GetGenReg(cpu, dec->gen[0]) = PB12_GET_U(PB12_PTR_U(1)); \
+    PB12_NEXT \
+    \
+    PB12_HANDLER(LodRegDU)      /* 11 */ \
+        *pb12GetGenReg(cpu, dec->gen[0]) = PB12_GET_U(dec->operand[1]); \
+    PB12_NEXT \
+    \
+    PB12_HANDLER(AddAccRU)      /* 20 */ \
+        cpu->acc += PB12_GET_U(PB12_PTR_U(0)); \
+        if (cpu->acc > 9999) \
+            cpu->acc -= 9999; \
+    PB12_NEXT \
+    \
+    PB12_HANDLER(AddAccDU)      /* 21 */ \
+        cpu->acc += PB12_GET_U(dec->operand[0]); \
+        if (cpu->acc > 9999) \
+            cpu->acc -= 10000; \
+    PB12_NEXT \
+    \
+    PB12_HANDLER(SubAccRU)      /* 22 */ \
+        cpu->acc -= PB12_GET_U(PB12_PTR_U(0)); \
+        if (cpu->acc < 0) \
+            cpu->acc += 10000; \
+    PB12_NEXT \
+    \
+    PB12_HANDLER(SubAccDU)      /* 23 */ \
+        cpu->acc -= PB12_GET_U(dec->operand[0]); \
+        if (cpu->acc < 0) \
+            cpu->acc += 10000; \
+    PB12_NEXT \
+    \
+    PB12_HANDLER(EquRU)         /* 24 */ \
+        cpu->psw[0] = cpu->acc == PB12_GET_U(PB12_PTR_U(0)) ? 'T' : 'F'; \
+    PB12_NEXT \
+    \
+    PB12_HANDLER(LesRU)         /* 25 */ \
+        cpu->psw[0] = cpu->acc < PB12_GET_U(PB12_PTR_U(0)) ? 'T' : 'F'; \
+    PB12_NEXT \
+    \
+    PB12_HANDLER(GreRU)         /* 26 */ \
+        cpu->psw[0] = cpu->acc > PB12_GET_U(PB12_PTR_U(0)) ? 'T' : 'F'; \
+    PB12_NEXT
+
+
+/*
+    The engine itself is in pb12_threaded.inc, which is compiled once for
+    untraced runs and once for traced runs.  PB12_TRACED is a constant in
+    each, so the untraced engine has no trace checks at all.  Handler
+    functions and tables get the name of their variant appended.
+*/
+#define PB12_PASTE2(a, b) a##b
+#define PB12_PASTE(a, b) PB12_PASTE2(a, b)
+#define PB12_OP(name) PB12_PASTE(pb12Op##name, PB12_VARIANT)
+#define PB12_HANDLER_TABLE PB12_PASTE(pb12Handlers, PB12_VARIANT)
+
+#define PB12_TRACED 0
+#define PB12_VARIANT Untraced
+#define PB12_RUN_THREADED pb12RunThreadedUntraced
+#include "pb12_threaded.inc"
+#undef PB12_TRACED
+#undef PB12_VARIANT
+#undef PB12_RUN_THREADED
+
+#define PB12_TRACED 1
+#define PB12_VARIANT Traced
+#define PB12_RUN_THREADED pb12RunThreadedTraced
+#include "pb12_threaded.inc"
+#undef PB12_TRACED
+#undef PB12_VARIANT
+#undef PB12_RUN_THREADED
+
+
+/**
+    Runs instructions with the threaded dispatch engine, traced if the VM
+    was started with PB12_OPT_VERBOSE.
+
+    @param PB12_CPU *cpu - CPU.
+    @param PB12_HW *hw - Hardware.
+    @param int count - Maximum number of dispatches, or 0.
+
+    @return int - PB12_SUCCESS, PB12_FAILURE, or PB12_TERMINATE
+*/
+int pb12RunThreaded(PB12_CPU *cpu, PB12_HW *hw, int count) {
+    if (hw->config->options & PB12_OPT_VERBOSE)
+        return pb12RunThreadedTraced(cpu, hw, count);
+    return pb12RunThreadedUntraced(cpu, hw, count);
+}
@@ -0,0 +1,59 @@
+#ifndef PB12_THREADED_H
+#define PB12_THREADED_H
+
+#include "pb12_cpu.h"
+
+struct S_PB12_HW;
+
+
+/**
+    Runs instructions with the threaded dispatch engine.  Each instruction
+    handler dispatches straight to the handler of the next instruction
+    (computed goto), or a table of handler functions is called when the
+    compiler does not support labels as values.
+
+    Common sequences of instructions (see pb12FuseDecoded()) are executed
+    as one superinstruction, which counts as a single dispatch but updates
+    pc, ic and the other registers exactly as its separate instructions
+    would have.
+
+    Execution stops after count dispatches (0 for no limit), when the time
+    slice runs out (ic reaches 0), when a trap is raised, or when an
+    instruction halts or fails.  The number of instructions executed is left
+    in hw->retired.  Instructions are traced if the VM was started with
+    PB12_OPT_VERBOSE.
+
+    @param PB12_CPU *cpu - CPU.
+    @param struct S_PB12_HW *hw - Hardware.
+    @param int count - Maximum number of dispatches, or 0.
+
+    @return int - PB12_SUCCESS, PB12_FAILURE, or PB12_TERMINATE
+*/
+int pb12RunThreaded(PB12_CPU *cpu, struct S_PB12_HW *hw, int count);
+
+
+/**
+    pb12RunThreaded() compiled for untraced runs, with no trace checks.
+
+    @param PB12_CPU *cpu - CPU.
+    @param struct S_PB12_HW *hw - Hardware.
+    @param int count - Maximum number of dispatches, or 0.
+
+    @return int - PB12_SUCCESS, PB12_FAILURE, or PB12_TERMINATE
+*/
+int pb12RunThreadedUntraced(PB12_CPU *cpu, struct S_PB12_HW *hw, int count);
+
+
+/**
+    pb12RunThreaded() compiled for traced runs.  Every instruction is
+    printed and superinstructions are never used.
+
+    @param PB12_CPU *cpu - CPU.
+    @param struct S_PB12_HW *hw - Hardware.
+    @param int count - Maximum number of dispatches, or 0.
+
+    @return int - PB12_SUCCESS, PB12_FAILURE, or PB12_TERMINATE
+*/
+int pb12RunThreadedTraced(PB12_CPU *cpu, struct S_PB12_HW *hw, int count);
+
+#endif /* PB12_THREADED_H */
@@ -0,0 +1,144 @@
+#include <stdio.h>
+#include <string.h>
+#include "pb12.h"
+#include "pb12_trace.h"
+
+/**
+    Store a number as 4 little endian bytes.
+
+    @param unsigned char *bytes - Where to store it.
+    @param unsigned long value - Number.
+*/
+static void pb12TracePut32(unsigned char *bytes, unsigned long value) {
+    bytes[0] = (unsigned char)(value & 0xff);
+    bytes[1] = (unsigned char)(value >> 8 & 0xff);
+    bytes[2] = (unsigned char)(value >> 16 & 0xff);
+    bytes[3] = (unsigned char)(value >> 24 & 0xff);
+}
+
+
+/**
+    Load a number stored as 4 little endian bytes.
+
+    @param const unsigned char *bytes - Where it is stored.
+
+    @return unsigned long - Number.
+*/
+static unsigned long pb12TraceGet32(const unsigned char *bytes) {
+    return (unsigned long)bytes[0] | (unsigned long)bytes[1] << 8 |
+           (unsigned long)bytes[2] << 16 | (unsigned long)bytes[3] << 24;
+}
+
+
+/**
+    Create a trace file to record events to.
+
+    @param PB12_Trace *trace - Trace.
+    @param const char *path - Name of the file.
+    @param int size - Words of memory the allocations are from.
+
+    @return int - PB12_SUCCESS or PB12_FAILURE
+*/
+int pb12OpenTraceWrite(PB12_Trace *trace, const char *path, int size) {
+    unsigned char header[PB12_TRACE_HEADER];
+
+    trace->size = size;
+    trace->events = 0;
+    trace->file = fopen(path, "wb");
+    if (trace->file == NULL)
+        return PB12_FAILURE;
+
+    memcpy(header, PB12_TRACE_MAGIC, 8);
+    pb12TracePut32(&header[8], (unsigned long)size);
+    if (fwrite(header, 1, PB12_TRACE_HEADER, trace->file) != PB12_TRACE_HEADER) {
+        pb12CloseTrace(trace);
+        return PB12_FAILURE;
+    }
+    return PB12_SUCCESS;
+}
+
+
+/**
+    Open a trace file to replay the events in it.
+
+    @param PB12_Trace *trace - Trace.
+    @param const char *path - Name of the file.
+
+    @return int - PB12_SUCCESS, or PB12_FAILURE if it is not a trace file
+*/
+int pb12OpenTraceRead(PB12_Trace *trace, const char *path) {
+    unsigned char header[PB12_TRACE_HEADER];
+
+    trace->size = 0;
+    trace->events = 0;
+    trace->file = fopen(path, "rb");
+    if (trace->file == NULL)
+        return PB12_FAILURE;
+
+    if (fread(header, 1, PB12_TRACE_HEADER, trace->file) != PB12_TRACE_HEADER ||
+        memcmp(header, PB12_TRACE_MAGIC, 8) != 0) {
+        pb12CloseTrace(trace);
+        return PB12_FAILURE;
+    }
+    trace->size = (int)pb12TraceGet32(&header[8]);
+    return PB12_SUCCESS;
+}
+
+
+/**
+    Close a trace file.
+
+    @param PB12_Trace *trace - Trace.
+*/
+void pb12CloseTrace(PB12_Trace *trace) {
+    if (trace->file != NULL)
+        fclose(trace->file);
+    trace->file = NULL;
+}
+
+
+/**
+    Record an event.
+
+    @param PB12_Trace *trace - Trace opened with pb12OpenTraceWrite().
+    @param int op - PB12_TRACE_*.
+    @param int id - Process the block is for.
+    @param int length - Words asked for, or 0.
+    @param unsigned long tick - Clock tick it happened at.
+
+    @return int - PB12_SUCCESS or PB12_FAILURE
+*/
+int pb12TraceWrite(PB12_Trace *trace, int op, int id, int length, unsigned long tick) {
+    unsigned char record[PB12_TRACE_RECORD];
+
+    record[0] = (unsigned char)op;
+    pb12TracePut32(&record[1], (unsigned long)id);
+    pb12TracePut32(&record[5], (unsigned long)length);
+    pb12TracePut32(&record[9], tick);
+    if (fwrite(record, 1, PB12_TRACE_RECORD, trace->file) != PB12_TRACE_RECORD)
+        return PB12_FAILURE;
+    ++trace->events;
+    return PB12_SUCCESS;
+}
+
+
+/**
+    Read the next event.
+
+    @param PB12_Trace *trace - Trace opened with pb12OpenTraceRead().
+    @param PB12_TraceEvent *event - Set to the event.
+
+    @return int - PB12_SUCCESS, or PB12_FAILURE at the end of the trace
+*/
+int pb12TraceRead(PB12_Trace *trace, PB12_TraceEvent *event) {
+    unsigned char record[PB12_TRACE_RECORD];
+
+    if (fread(record, 1, PB12_TRACE_RECORD, trace->file) != PB12_TRACE_RECORD)
+        return PB12_FAILURE;
+    event->op = record[0];
+    event->id = (int)pb12TraceGet32(&record[1]);
+    event->length = (int)pb12TraceGet32(&record[5]);
+    event->tick = pb12TraceGet32(&record[9]);
+    ++trace->events;
+    return PB12_SUCCESS;
+}
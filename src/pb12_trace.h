@@ -0,0 +1,95 @@
+#ifndef PB12_TRACE_H
+#define PB12_TRACE_H
+
+#include <stdio.h>
+#include "pb12.h"
+
+#define PB12_TRACE_MAGIC    "PB12ATR1"  /* First bytes of every trace file */
+#define PB12_TRACE_HEADER   12          /* Bytes of the magic and memory size */
+#define PB12_TRACE_RECORD   13          /* Bytes of each event */
+
+/* Events of a trace */
+#define PB12_TRACE_ALLOC    'A'         /* A process was given a block */
+#define PB12_TRACE_FREE     'F'         /* A process gave its block back */
+#define PB12_TRACE_WAIT     'W'         /* A program did not fit and had to wait */
+#define PB12_TRACE_COMPACT  'C'         /* Every block was slid down to address 0 */
+#define PB12_TRACE_RESIZE   'R'         /* A process grew or shrank its block */
+
+/* One allocation event, as the OS made it */
+typedef struct S_PB12_TraceEvent {
+    int op;                     /* PB12_TRACE_* */
+    int id;                     /* Process the block is for */
+    int length;                 /* Words asked for, for PB12_TRACE_ALLOC, _WAIT and _RESIZE */
+    unsigned long tick;         /* Clock tick it happened at */
+} PB12_TraceEvent;
+
+/*
+    A trace file records the allocations and frees of a run so that they can
+    be replayed against any allocator without running the programs again.
+    After the magic comes the number of words of memory, and then one record
+    per event: its op as a byte, then its id, length and tick as 32 bit
+    little endian numbers.
+*/
+typedef struct S_PB12_Trace {
+    FILE *file;                 /* Trace file */
+    int size;                   /* Words of memory the allocations were from */
+    unsigned long events;       /* Events written or read so far */
+} PB12_Trace;
+
+
+/**
+    Create a trace file to record events to.
+
+    @param PB12_Trace *trace - Trace.
+    @param const char *path - Name of the file.
+    @param int size - Words of memory the allocations are from.
+
+    @return int - PB12_SUCCESS or PB12_FAILURE
+*/
+int pb12OpenTraceWrite(PB12_Trace *trace, const char *path, int size);
+
+
+/**
+    Open a trace file to replay the events in it.
+
+    @param PB12_Trace *trace - Trace.
+    @param const char *path - Name of the file.
+
+    @return int - PB12_SUCCESS, or PB12_FAILURE if it is not a trace file
+*/
+int pb12OpenTraceRead(PB12_Trace *trace, const char *path);
+
+
+/**
+    Close a trace file.
+
+    @param PB12_Trace *trace - Trace.
+*/
+void pb12CloseTrace(PB12_Trace *trace);
+
+
+/**
+    Record an event.
+
+    @param PB12_Trace *trace - Trace opened with pb12OpenTraceWrite().
+    @param int op - PB12_TRACE_*.
+    @param int id - Process the block is for.
+    @param int length - Words asked for, or 0.
+    @param unsigned long tick - Clock tick it happened at.
+
+    @return int - PB12_SUCCESS or PB12_FAILURE
+*/
+int pb12TraceWrite(PB12_Trace *trace, int op, int id, int length, unsigned long tick);
+
+
+/**
+    Read the next event.
+
+    @param PB12_Trace *trace - Trace opened with pb12OpenTraceRead().
+    @param PB12_TraceEvent *event - Set to the event.
+
+    @return int - PB12_SUCCESS, or PB12_FAILURE at the end of the trace
+*/
+int pb12TraceRead(PB12_Trace *trace, PB12_TraceEvent *event);
+
+#endif /* PB12_TRACE_H */
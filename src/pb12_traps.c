@@ -9,7 +9,8 @@ void (*pb12TrapVectors[PB12_TRAP_MAX_TRAP])(struct S_PB12_OS *os) = {
     pb12TrapWait,
     pb12TrapSignal,
     pb12TrapPID,
-    pb12TrapDump
+    pb12TrapDump,
+    pb12TrapResize
 };
 
 
@@ -23,13 +24,13 @@ void pb12TrapWait(struct S_PB12_OS *os) {
     reg = pb12GetGenReg(&os->hw->cpu, os->hw->trap_op);
     if (reg) {
         if (*reg == 0) {
-            if (pb12Options & PB12_OPT_VERBOSE) {
+            if (os->hw->config->options & PB12_OPT_VERBOSE) {
                 printf("Trap: Wait on fork %d.\n", os->hw->cpu.acc);
             }
             pb12SemWait(&os->forks[os->hw->cpu.acc], os);
         }
         else {
-            if (pb12Options & PB12_OPT_VERBOSE) {
+            if (os->hw->config->options & PB12_OPT_VERBOSE) {
                 printf("Trap: Wait on doorman.\n");
             }
             pb12SemWait(&os->doorman, os);
@@ -48,13 +49,13 @@ void pb12TrapSignal(struct S_PB12_OS *os) {
     reg = pb12GetGenReg(&os->hw->cpu, os->hw->trap_op);
     if (reg) {
         if (*reg == 0) {
-            if (pb12Options & PB12_OPT_VERBOSE) {
+            if (os->hw->config->options & PB12_OPT_VERBOSE) {
                 printf("Trap: Signal on fork %d.\n", os->hw->cpu.acc);
             }
             pb12SemSignal(&os->forks[os->hw->cpu.acc], os);
         }
         else {
-            if (pb12Options & PB12_OPT_VERBOSE) {
+            if (os->hw->config->options & PB12_OPT_VERBOSE) {
                 printf("Trap: Signal doorman.\n");
             }
             pb12SemSignal(&os->doorman, os);
@@ -73,7 +74,7 @@ void pb12TrapPID(struct S_PB12_OS *os) {
     reg = pb12GetGenReg(&os->hw->cpu, os->hw->trap_op);
     if (reg) {
         *reg = pb12CurrentPid(os);
-        if (pb12Options & PB12_OPT_VERBOSE) {
+        if (os->hw->config->options & PB12_OPT_VERBOSE) {
             printf("Trap: Get PID %d.\n", *reg);
         }
     }
@@ -89,3 +90,24 @@ void pb12TrapDump(struct S_PB12_OS *os) {
     pb12DumpCPU(&os->hw->cpu);
     pb12DumpMemory(&os->hw->mem);
 }
+
+
+/**
+    Resize Memory trap.  The register holds the words the process wants,
+    and is set to the words it has afterwards.  Growing compacts memory and
+    swaps out blocked processes as admitting a program would, and if there
+    is still no room the process keeps what it had.
+
+    @param struct S_PB12_OS *os - Operating System
+*/
+void pb12TrapResize(struct S_PB12_OS *os) {
+    int *reg;
+    reg = pb12GetGenReg(&os->hw->cpu, os->hw->trap_op);
+    if (reg) {
+        if (os->hw->config->options & PB12_OPT_VERBOSE) {
+            printf("Trap: Resize memory to %d.\n", *reg);
+        }
+        pb12ResizeProcess(os, *reg);
+        *reg = os->hw->cpu.lr - os->hw->cpu.bar;
+    }
+}
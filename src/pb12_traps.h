@@ -5,7 +5,8 @@
 #define PB12_TRAP_SIGNAL    1
 #define PB12_TRAP_PID       2
 #define PB12_TRAP_DUMP      3
-#define PB12_TRAP_MAX_TRAP  4
+#define PB12_TRAP_RESIZE    4
+#define PB12_TRAP_MAX_TRAP  5
 
 struct S_PB12_OS;
 
@@ -40,4 +41,15 @@ void pb12TrapPID(struct S_PB12_OS *os);
 */
 void pb12TrapDump(struct S_PB12_OS *os);
 
+
+/**
+    Resize Memory trap.  The register holds the words the process wants,
+    and is set to the words it has afterwards.  Growing compacts memory and
+    swaps out blocked processes as admitting a program would, and if there
+    is still no room the process keeps what it had.
+
+    @param struct S_PB12_OS *os - Operating System
+*/
+void pb12TrapResize(struct S_PB12_OS *os);
+
 #endif /* PB12_TRAPS_H */
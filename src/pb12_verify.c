@@ -0,0 +1,1007 @@
+#include <stdlib.h>
+#include "pb12.h"
+#include "pb12_verify.h"
+#include "pb12_inst.h"
+
+#define PB12_VERIFY_UNBOUNDED   -1  /* Pointer register could hold anything */
+
+/* What pb12RangeProgram() leaves in reach */
+#define PB12_VERIFY_REACHED     1   /* Control can get to the word */
+#define PB12_VERIFY_TARGET      2   /* A branch goes to the word */
+
+/* Registers of a PB12_VState whose values are known */
+#define PB12_VK_ACC     1
+#define PB12_VK_R0      2           /* r[n] is PB12_VK_R0 << n */
+#define PB12_VK_PSW     32
+
+/*
+    The registers of a process at one instruction, as the verifier follows
+    it.  Pointer registers are only ever set from the program's own
+    immediates, so they are always known.  Everything else is known until a
+    value read from memory (or handed back by a trap) ends up in it.
+*/
+typedef struct S_PB12_VState {
+    int acc;
+    int r[4];
+    short int p[4];
+    short int pc;
+    char psw;
+    unsigned char known;    /* PB12_VK_* flags */
+} PB12_VState;
+
+/* States of a program the verifier has reached so far */
+typedef struct S_PB12_VStates {
+    PB12_VState *state;     /* Every state reached, in the order reached */
+    int count;              /* Number of states */
+    int size;               /* Number of states allocated */
+    int *table;             /* Hash table of indexes into state, or -1 */
+    int table_size;         /* Number of entries in table, a power of two */
+    int max;                /* Most states to follow before giving up */
+} PB12_VStates;
+
+
+/**
+    Work out where control can go after an instruction.
+
+    @param const PB12_Decoded *dec - Instruction.
+    @param int pc - Relative address of the instruction.
+    @param int *next - Where to write the relative addresses it can go to.
+
+    @return int - Number of addresses written to next, at most two.
+*/
+static int pb12Successors(const PB12_Decoded *dec, int pc, int *next) {
+    switch (dec->op) {
+    case PB12_DEC_OP_HLT:
+    case PB12_DEC_OP_INVALID:
+        return 0;
+
+    case PB12_BRU:
+        next[0] = (short int)dec->operand[0];
+        return 1;
+
+    case PB12_BRT:
+    case PB12_BRF:
+        next[0] = (short int)dec->operand[0];
+        next[1] = pc + 1;
+        return 2;
+
+    default:
+        next[0] = pc + 1;
+        return 1;
+    }
+}
+
+
+/**
+    Work out which operand of a memory instruction holds its address.
+    Instructions with invalid registers or direct addresses outside of
+    memory fail before they get to memory, so they do not count.
+
+    @param const PB12_Decoded *dec - Instruction.
+    @param int mem_size - Size of memory in VM.
+    @param int *direct - Set to nonzero for direct addressing.
+
+    @return int - Operand holding the address, or -1 if the instruction
+                  does not access memory.
+*/
+static int pb12AccessOperand(const PB12_Decoded *dec, int mem_size, int *direct) {
+    int n;
+
+    switch (dec->op) {
+    case PB12_LOD_ACC_R:
+    case PB12_STO_ACC_R:
+    case PB12_ADD_ACC_R:
+    case PB12_SUB_ACC_R:
+    case PB12_EQU_R:
+    case PB12_LES_R:
+    case PB12_GRE_R:
+        n = 0;
+        *direct = 0;
+        break;
+
+    case PB12_LOD_ACC_D:
+    case PB12_STO_ACC_D:
+    case PB12_ADD_ACC_D:
+    case PB12_SUB_ACC_D:
+        n = 0;
+        *direct = 1;
+        break;
+
+    case PB12_STO_REG_R:
+    case PB12_LOD_REG_R:
+        n = 1;
+        *direct = 0;
+        break;
+
+    case PB12_STO_REG_D:
+    case PB12_LOD_REG_D:
+        n = 1;
+        *direct = 1;
+        break;
+
+    default:
+        return -1;
+    }
+
+    if (n == 1 && dec->gen[0] < 0)
+        return -1;
+    if (*direct ? dec->operand[n] >= mem_size : dec->ptr[n] < 0)
+        return -1;
+
+    return n;
+}
+
+
+/**
+    See whether an instruction writes to memory.
+
+    @param const PB12_Decoded *dec - Instruction.
+
+    @return int - Nonzero for stores.
+*/
+static int pb12IsStore(const PB12_Decoded *dec) {
+    return dec->op == PB12_STO_ACC_R || dec->op == PB12_STO_ACC_D ||
+           dec->op == PB12_STO_REG_R || dec->op == PB12_STO_REG_D;
+}
+
+
+/**
+    Work out the value of a general register operand in a state.
+
+    @param const PB12_VState *s - State.
+    @param int reg - General register number.
+    @param int *value - Where to write the value.
+
+    @return int - Nonzero if the value is known.
+*/
+static int pb12StateReg(const PB12_VState *s, int reg, int *value) {
+    *value = s->r[reg];
+    return s->known & (PB12_VK_R0 << reg);
+}
+
+
+/**
+    Set a general register of a state.
+
+    @param PB12_VState *s - State.
+    @param int reg - General register number.
+    @param int value - Value.
+    @param int known - Nonzero if the value is known.
+*/
+static void pb12SetStateReg(PB12_VState *s, int reg, int value, int known) {
+    s->r[reg] = known ? value : 0;
+    if (known)
+        s->known |= PB12_VK_R0 << reg;
+    else
+        s->known &= ~(PB12_VK_R0 << reg);
+}
+
+
+/**
+    Set the accumulator of a state.
+
+    @param PB12_VState *s - State.
+    @param int value - Value.
+    @param int known - Nonzero if the value is known.
+*/
+static void pb12SetStateAcc(PB12_VState *s, int value, int known) {
+    s->acc = known ? value : 0;
+    if (known)
+        s->known |= PB12_VK_ACC;
+    else
+        s->known &= ~PB12_VK_ACC;
+}
+
+
+/**
+    Set the comparison flag of a state.
+
+    @param PB12_VState *s - State.
+    @param int value - Result of the comparison.
+    @param int known - Nonzero if the result is known.
+*/
+static void pb12SetStatePsw(PB12_VState *s, int value, int known) {
+    s->psw = known ? (value ? 'T' : 'F') : ' ';
+    if (known)
+        s->known |= PB12_VK_PSW;
+    else
+        s->known &= ~PB12_VK_PSW;
+}
+
+
+/**
+    Execute one instruction on a state, the same way pb12Execute() does on
+    the CPU.  Values read from memory are not known.
+
+    @param const PB12_Decoded *dec - Instruction at the state's pc.
+    @param const PB12_VState *s - State before the instruction.
+    @param int mem_size - Size of memory in VM.
+    @param PB12_VState *next - Where to write the states after it.
+
+    @return int - Number of states written to next, at most two.
+*/
+static int pb12StepState(const PB12_Decoded *dec, const PB12_VState *s, int mem_size,
+                         PB12_VState *next) {
+    PB12_VState *t;
+    int direct;
+    int a;
+    int b;
+    int ka;
+    int kb;
+    int g0;
+    int g1;
+    int p0;
+
+    next[0] = *s;
+    t = &next[0];
+    t->pc = (short int)(s->pc + 1);
+    g0 = dec->gen[0];
+    g1 = dec->gen[1];
+    p0 = dec->ptr[0];
+    ka = s->known & PB12_VK_ACC;
+
+    switch (dec->op) {
+    case PB12_LOD_PTR_I:
+        if (p0 < 0)
+            return 0;
+        t->p[p0] = (short int)dec->operand[1];
+        break;
+
+    case PB12_ADD_PTR_I:
+        if (p0 < 0)
+            return 0;
+        t->p[p0] = (short int)(t->p[p0] + dec->operand[1]);
+        if (t->p[p0] > 99)
+            t->p[p0] = (short int)(t->p[p0] - 100);
+        break;
+
+    case PB12_SUB_PTR_I:
+        if (p0 < 0)
+            return 0;
+        t->p[p0] = (short int)(t->p[p0] - dec->operand[1]);
+        if (t->p[p0] < 0)
+            t->p[p0] = (short int)(t->p[p0] + 100);
+        break;
+
+    case PB12_LOD_ACC_I:
+        pb12SetStateAcc(t, dec->value, 1);
+        break;
+
+    case PB12_LOD_REG_R0_I:
+        pb12SetStateReg(t, 0, dec->value, 1);
+        break;
+
+    case PB12_TRA_REG_REG:
+        if (g0 < 0 || g1 < 0)
+            return 0;
+        kb = pb12StateReg(s, g1, &b);
+        pb12SetStateReg(t, g0, b, kb);
+        break;
+
+    case PB12_LOD_ACC_REG:
+        if (g0 < 0)
+            return 0;
+        kb = pb12StateReg(s, g0, &b);
+        pb12SetStateAcc(t, b, kb);
+        break;
+
+    case PB12_LOD_REG_ACC:
+        if (g0 < 0)
+            return 0;
+        pb12SetStateReg(t, g0, s->acc, ka);
+        break;
+
+    case PB12_ADD_ACC_I:
+        a = s->acc + dec->value;
+        if (a > 9999)
+            a -= 10000;
+        pb12SetStateAcc(t, a, ka);
+        break;
+
+    case PB12_SUB_ACC_I:
+        a = s->acc - dec->value;
+        if (a < 0)
+            a += 10000;
+        pb12SetStateAcc(t, a, ka);
+        break;
+
+    case PB12_ADD_ACC_REG:
+        if (g0 < 0)
+            return 0;
+        kb = pb12StateReg(s, g0, &b);
+        a = s->acc + b;
+        if (a > 9999)
+            a -= 10000;
+        pb12SetStateAcc(t, a, ka && kb);
+        break;
+
+    case PB12_SUB_ACC_REG:
+        if (g0 < 0)
+            return 0;
+        kb = pb12StateReg(s, g0, &b);
+        a = s->acc - b;
+        if (a < 0)
+            a += 10000;
+        pb12SetStateAcc(t, a, ka && kb);
+        break;
+
+    case PB12_GRE_I:
+        pb12SetStatePsw(t, s->acc > dec->value, ka);
+        break;
+
+    case PB12_EQU_I:
+        pb12SetStatePsw(t, s->acc == dec->value, ka);
+        break;
+
+    case PB12_LES_I:
+        pb12SetStatePsw(t, s->acc < dec->value, ka);
+        break;
+
+    case PB12_EQU_REG:
+    case PB12_LES_REG:
+    case PB12_GRE_REG:
+        if (g0 < 0)
+            return 0;
+        kb = pb12StateReg(s, g0, &b);
+        if (dec->op == PB12_EQU_REG)
+            a = s->acc == b;
+        else if (dec->op == PB12_LES_REG)
+            a = s->acc < b;
+        else
+            a = s->acc > b;
+        pb12SetStatePsw(t, a, ka && kb);
+        break;
+
+    case PB12_BRT:
+    case PB12_BRF:
+        if (!(s->known & PB12_VK_PSW)) {
+            next[1] = *t;
+            next[1].pc = (short int)dec->operand[0];
+            return 2;
+        }
+        if (s->psw == (dec->op == PB12_BRT ? 'T' : 'F'))
+            t->pc = (short int)dec->operand[0];
+        break;
+
+    case PB12_BRU:
+        t->pc = (short int)dec->operand[0];
+        break;
+
+    case PB12_TRAP:
+        if (g0 < 0)
+            return 0;
+        /* A trap may hand a value back in the register named by its last digit. */
+        if (dec->reg >= 0 && dec->reg <= 3)
+            pb12SetStateReg(t, dec->reg, 0, 0);
+        break;
+
+    case PB12_MOD:
+        if (g0 < 0 || g1 < 0)
+            return 0;
+        ka = pb12StateReg(s, g0, &a);
+        kb = pb12StateReg(s, g1, &b);
+        if (ka && kb && b != 0)
+            pb12SetStateAcc(t, a % b, 1);
+        else
+            pb12SetStateAcc(t, 0, 0);
+        break;
+
+    case PB12_DEC_OP_HLT:
+    case PB12_DEC_OP_INVALID:
+        return 0;
+
+    default:
+        /* Everything else accesses memory; loads give unknown values. */
+        if (pb12AccessOperand(dec, mem_size, &direct) < 0)
+            return 0;
+        if (dec->op == PB12_LOD_ACC_R || dec->op == PB12_LOD_ACC_D ||
+            dec->op == PB12_ADD_ACC_R || dec->op == PB12_ADD_ACC_D ||
+            dec->op == PB12_SUB_ACC_R || dec->op == PB12_SUB_ACC_D)
+            pb12SetStateAcc(t, 0, 0);
+        else if (dec->op == PB12_LOD_REG_R || dec->op == PB12_LOD_REG_D)
+            pb12SetStateReg(t, g0, 0, 0);
+        else if (dec->op == PB12_EQU_R || dec->op == PB12_LES_R || dec->op == PB12_GRE_R)
+            pb12SetStatePsw(t, 0, 0);
+        break;
+    }
+
+    return 1;
+}
+
+
+/**
+    Work out which hash table entry a state belongs in.
+
+    @param const PB12_VState *s - State.
+    @param int table_size - Number of entries in the table.
+
+    @return int - Entry.
+*/
+static int pb12HashState(const PB12_VState *s, int table_size) {
+    unsigned long hash;
+    int i;
+
+    hash = (unsigned short)s->pc;
+    hash = hash * 31 + s->known;
+    hash = hash * 31 + (unsigned char)s->psw;
+    hash = hash * 31 + (unsigned int)s->acc;
+    for (i=0; i<4; i++) {
+        hash = hash * 31 + (unsigned int)s->r[i];
+        hash = hash * 31 + (unsigned short)s->p[i];
+    }
+
+    return (int)(hash & (unsigned long)(table_size - 1));
+}
+
+
+/**
+    See whether two states are the same.
+
+    @param const PB12_VState *a - State.
+    @param const PB12_VState *b - State.
+
+    @return int - Nonzero if they are.
+*/
+static int pb12SameState(const PB12_VState *a, const PB12_VState *b) {
+    int i;
+
+    if (a->pc != b->pc || a->known != b->known || a->psw != b->psw || a->acc != b->acc)
+        return 0;
+    for (i=0; i<4; i++) {
+        if (a->r[i] != b->r[i] || a->p[i] != b->p[i])
+            return 0;
+    }
+
+    return 1;
+}
+
+
+/**
+    Add a state to the states reached, unless it has been reached before.
+
+    @param PB12_VStates *states - States reached.
+    @param const PB12_VState *s - State.
+
+    @return int - PB12_SUCCESS, or PB12_FAILURE once there are
+                  states->max states or no memory for more.
+*/
+static int pb12AddState(PB12_VStates *states, const PB12_VState *s) {
+    PB12_VState *more;
+    int *table;
+    int size;
+    int i;
+    int j;
+
+    i = pb12HashState(s, states->table_size);
+    while (states->table[i] >= 0) {
+        if (pb12SameState(&states->state[states->table[i]], s))
+            return PB12_SUCCESS;
+        i = (i + 1) & (states->table_size - 1);
+    }
+
+    if (states->count == states->max)
+        return PB12_FAILURE;
+
+    if (states->count == states->size) {
+        size = states->size * 2;
+        more = (PB12_VState*) realloc(states->state, size * sizeof(PB12_VState));
+        if (more == NULL)
+            return PB12_FAILURE;
+        states->state = more;
+        states->size = size;
+
+        /* Keep the table no more than half full. */
+        table = (int*) malloc(size * 2 * sizeof(int));
+        if (table == NULL)
+            return PB12_FAILURE;
+        free(states->table);
+        states->table = table;
+        states->table_size = size * 2;
+        for (i=0; i<states->table_size; i++)
+            states->table[i] = -1;
+        for (j=0; j<states->count; j++) {
+            i = pb12HashState(&states->state[j], states->table_size);
+            while (states->table[i] >= 0)
+                i = (i + 1) & (states->table_size - 1);
+            states->table[i] = j;
+        }
+        i = pb12HashState(s, states->table_size);
+        while (states->table[i] >= 0)
+            i = (i + 1) & (states->table_size - 1);
+    }
+
+    states->state[states->count] = *s;
+    states->table[i] = states->count;
+    ++states->count;
+
+    return PB12_SUCCESS;
+}
+
+
+/**
+    Follow every state a program can be in from the moment it starts, and
+    record which words it reaches and the lowest and highest address each
+    memory instruction uses.
+
+    @param PB12_MEM *mem - Memory.
+    @param int bar - Base address of the program's block.
+    @param int length - Length of the block.
+    @param char *reach - Set to PB12_VERIFY_REACHED for each word reached.
+    @param int *lo - Lowest address each word accesses.
+    @param int *hi - Highest address each word accesses.
+    @param int *confined - Cleared if control can leave the block.
+
+    @return int - PB12_SUCCESS, or PB12_FAILURE if the program has more
+                  than PB12_VERIFY_STATES_PER_WORD states per word, or
+                  more than PB12_VERIFY_MAX_STATES in all.
+*/
+static int pb12ExploreProgram(PB12_MEM *mem, int bar, int length, char *reach,
+                              int *lo, int *hi, int *confined) {
+    PB12_VStates states;
+    PB12_VState start;
+    PB12_VState next[2];
+    PB12_Decoded *dec;
+    int status;
+    int direct;
+    int count;
+    int addr;
+    int n;
+    int i;
+    int k;
+
+    states.size = 256;
+    states.count = 0;
+    states.max = PB12_VERIFY_MAX_STATES;
+    if (length < PB12_VERIFY_MAX_STATES / PB12_VERIFY_STATES_PER_WORD)
+        states.max = length * PB12_VERIFY_STATES_PER_WORD;
+    states.table_size = states.size * 2;
+    states.state = (PB12_VState*) malloc(states.size * sizeof(PB12_VState));
+    states.table = (int*) malloc(states.table_size * sizeof(int));
+    status = PB12_FAILURE;
+    if (states.state == NULL || states.table == NULL)
+        goto done;
+    for (i=0; i<states.table_size; i++)
+        states.table[i] = -1;
+
+    /* Processes start with every register cleared, as pb12InitCpu(). */
+    start.acc = 0;
+    for (i=0; i<4; i++) {
+        start.r[i] = 0;
+        start.p[i] = 0;
+    }
+    start.pc = 0;
+    start.psw = 'T';
+    start.known = PB12_VK_ACC | (PB12_VK_R0 * 15) | PB12_VK_PSW;
+    if (pb12AddState(&states, &start) == PB12_FAILURE)
+        goto done;
+
+    /* States are added to the end as they are reached, so this is a BFS. */
+    for (k=0; k<states.count; k++) {
+        if (states.state[k].pc < 0 || states.state[k].pc >= length) {
+            *confined = 0;
+            status = PB12_SUCCESS;
+            goto done;
+        }
+
+        i = states.state[k].pc;
+        reach[i] = PB12_VERIFY_REACHED;
+        dec = pb12GetDecoded(mem, bar + i);
+        n = pb12AccessOperand(dec, mem->mem_size, &direct);
+        if (n >= 0) {
+            addr = direct ? dec->operand[n] : states.state[k].p[(int)dec->ptr[n]];
+            if (addr < lo[i])
+                lo[i] = addr;
+            if (addr > hi[i])
+                hi[i] = addr;
+        }
+
+        count = pb12StepState(dec, &states.state[k], mem->mem_size, next);
+        for (n=0; n<count; n++) {
+            if (pb12AddState(&states, &next[n]) == PB12_FAILURE)
+                goto done;
+        }
+    }
+    status = PB12_SUCCESS;
+
+done:
+    free(states.state);
+    free(states.table);
+    return status;
+}
+
+
+
+/**
+    Change the pointer registers the way an instruction does.  A pointer
+    register loaded with something that is not two digits becomes
+    PB12_VERIFY_UNBOUNDED.
+
+    @param const PB12_Decoded *dec - Instruction.
+    @param int *ptr - Pointer registers.
+*/
+static void pb12StepPointers(const PB12_Decoded *dec, int *ptr) {
+    int i;
+
+    if (dec->ptr[0] < 0)
+        return;
+    if (dec->op != PB12_LOD_PTR_I && dec->op != PB12_ADD_PTR_I &&
+        dec->op != PB12_SUB_PTR_I)
+        return;
+
+    i = dec->ptr[0];
+    if (dec->operand[1] < 0 || dec->operand[1] > 99)
+        ptr[i] = PB12_VERIFY_UNBOUNDED;
+    else if (ptr[i] == PB12_VERIFY_UNBOUNDED)
+        return;
+    else if (dec->op == PB12_LOD_PTR_I)
+        ptr[i] = dec->operand[1];
+    else if (dec->op == PB12_ADD_PTR_I)
+        ptr[i] = (ptr[i] + dec->operand[1]) % 100;
+    else
+        ptr[i] = (ptr[i] - dec->operand[1] + 100) % 100;
+}
+
+
+/**
+    Work out which words a program can reach and which addresses its memory
+    instructions can use, in one pass over the program.  Words before the
+    first branch that nothing branches back into run exactly once, from
+    the registers every process starts with, so their pointer registers are
+    known exactly.  After them each pointer register stays between the
+    value it had at the end of those words and the values the program
+    loads into it, or anywhere in 0-99 once it adds to or subtracts from it.
+
+    @param PB12_MEM *mem - Memory.
+    @param int bar - Base address of the program's block.
+    @param int length - Length of the block.
+    @param char *reach - Set to PB12_VERIFY_REACHED for each word reached.
+    @param int *lo - Lowest address each word accesses.
+    @param int *hi - Highest address each word accesses.
+    @param int *confined - Cleared if control can leave the block.
+*/
+static void pb12RangeProgram(PB12_MEM *mem, int bar, int length, char *reach,
+                             int *lo, int *hi, int *confined) {
+    PB12_Decoded *dec;
+    int *stack;
+    int ptr[4];
+    int ptr_lo[4];
+    int ptr_hi[4];
+    int next[2];
+    int direct;
+    int count;
+    int start;
+    int top;
+    int n;
+    int i;
+    int k;
+
+    for (k=0; k<length; k++)
+        reach[k] = 0;
+
+    stack = (int*) malloc(length * sizeof(int));
+    if (stack == NULL) {
+        *confined = 0;
+        return;
+    }
+
+    reach[0] = PB12_VERIFY_REACHED;
+    stack[0] = 0;
+    top = 1;
+    while (top > 0) {
+        k = stack[--top];
+        dec = pb12GetDecoded(mem, bar + k);
+        count = pb12Successors(dec, k, next);
+        for (i=0; i<count; i++) {
+            if (next[i] < 0 || next[i] >= length) {
+                *confined = 0;
+            }
+            else {
+                if (i == 0 && dec->op >= PB12_BRT && dec->op <= PB12_BRU)
+                    reach[next[i]] |= PB12_VERIFY_TARGET;
+                if (!(reach[next[i]] & PB12_VERIFY_REACHED)) {
+                    reach[next[i]] |= PB12_VERIFY_REACHED;
+                    stack[top++] = next[i];
+                }
+            }
+        }
+    }
+    free(stack);
+
+    /* Processes start with every pointer register cleared, as pb12InitCpu(). */
+    for (i=0; i<4; i++)
+        ptr[i] = 0;
+
+    /* Follow the words that run once, if nothing can branch to the first. */
+    start = 0;
+    while (start < length && !(reach[start] & PB12_VERIFY_TARGET)) {
+        dec = &mem->decoded[bar + start];
+        n = pb12AccessOperand(dec, mem->mem_size, &direct);
+        if (n < 0) {
+            /* Nothing to record */
+        }
+        else if (direct) {
+            lo[start] = dec->operand[n];
+            hi[start] = dec->operand[n];
+        }
+        else if (ptr[(int)dec->ptr[n]] == PB12_VERIFY_UNBOUNDED) {
+            lo[start] = -1;
+            hi[start] = mem->mem_size;
+        }
+        else {
+            lo[start] = ptr[(int)dec->ptr[n]];
+            hi[start] = ptr[(int)dec->ptr[n]];
+        }
+        pb12StepPointers(dec, ptr);
+        ++start;
+        if (pb12Successors(dec, start - 1, next) != 1 || next[0] != start)
+            break;
+    }
+
+    for (i=0; i<4; i++) {
+        ptr_lo[i] = ptr[i];
+        ptr_hi[i] = ptr[i];
+    }
+    for (k=start; k<length; k++) {
+        dec = &mem->decoded[bar + k];
+        if (!reach[k] || dec->ptr[0] < 0)
+            continue;
+        if (dec->op != PB12_LOD_PTR_I && dec->op != PB12_ADD_PTR_I &&
+            dec->op != PB12_SUB_PTR_I)
+            continue;
+
+        i = dec->ptr[0];
+        if (dec->operand[1] < 0 || dec->operand[1] > 99) {
+            ptr_lo[i] = PB12_VERIFY_UNBOUNDED;
+        }
+        else if (ptr_lo[i] == PB12_VERIFY_UNBOUNDED) {
+            continue;
+        }
+        else if (dec->op == PB12_LOD_PTR_I) {
+            if (dec->operand[1] < ptr_lo[i])
+                ptr_lo[i] = dec->operand[1];
+            if (dec->operand[1] > ptr_hi[i])
+                ptr_hi[i] = dec->operand[1];
+        }
+        else if (dec->operand[1] > 0) {
+            ptr_lo[i] = 0;
+            ptr_hi[i] = 99;
+        }
+    }
+
+    for (k=start; k<length; k++) {
+        dec = &mem->decoded[bar + k];
+        n = pb12AccessOperand(dec, mem->mem_size, &direct);
+        if (!reach[k] || n < 0) {
+            continue;
+        }
+        else if (direct) {
+            lo[k] = dec->operand[n];
+            hi[k] = dec->operand[n];
+        }
+        else if (ptr_lo[(int)dec->ptr[n]] == PB12_VERIFY_UNBOUNDED) {
+            lo[k] = -1;
+            hi[k] = mem->mem_size;
+        }
+        else {
+            lo[k] = ptr_lo[(int)dec->ptr[n]];
+            hi[k] = ptr_hi[(int)dec->ptr[n]];
+        }
+    }
+}
+
+
+/**
+    Set the proof flags of a decoded entry.  Blocks the JIT compiled from
+    the word may have been compiled without range checks, so they are
+    thrown away if the flags change.
+
+    @param PB12_MEM *mem - Memory.
+    @param int address - Memory address.
+    @param int flags - PB12_DEC_VERIFIED and PB12_DEC_UNCHECKED flags.
+*/
+static void pb12SetProofFlags(PB12_MEM *mem, int address, int flags) {
+    PB12_Decoded *dec;
+
+    dec = &mem->decoded[address];
+    if ((dec->flags & (PB12_DEC_VERIFIED | PB12_DEC_UNCHECKED)) == flags)
+        return;
+
+    if (dec->flags & PB12_DEC_JIT)
+        pb12CountCodeWrite(mem, address);
+
+    /* The threaded engine has to pick a handler for the word again. */
+    dec->flags &= ~(PB12_DEC_VERIFIED | PB12_DEC_UNCHECKED | PB12_DEC_FUSED);
+    dec->flags |= flags;
+}
+
+
+/**
+    Put the proof flags of a program on the words of its block.
+
+    @param PB12_MEM *mem - Memory.
+    @param int bar - Base address of the program's block.
+    @param PB12_Proof *proof - Proof of the program.
+*/
+static void pb12PlaceProof(PB12_MEM *mem, int bar, PB12_Proof *proof) {
+    int k;
+
+    proof->bar = bar;
+    proof->writes = mem->proof_writes[bar];
+    for (k=0; k<proof->length; k++) {
+        pb12SetProofFlags(mem, bar + k, proof->marks[k]);
+        mem->proof_block[bar + k] = bar;
+    }
+}
+
+
+/**
+    Work out which memory accesses of a program that has just been loaded
+    can never leave its block.  Every state the program can be in is
+    followed from the start, so addresses are known exactly, unless it has
+    more than PB12_VERIFY_STATES_PER_WORD states per word; then one pass
+    over the program bounds them instead (see pb12RangeProgram()), so the
+    work stays in proportion to the program's length.  Nothing is worked
+    out for the switch engine, which never runs anything unchecked, unless
+    PB12_OPT_VERIFY asks for a report.
+    Accesses that stay between bar and lr, and stores that cannot write to
+    any word the program can reach, are marked PB12_DEC_UNCHECKED and run
+    without range checks.  Every reachable word is marked
+    PB12_DEC_VERIFIED, since the proof only holds while none of them are
+    written.
+
+    @param PB12_MEM *mem - Memory.
+    @param int bar - Base address of the program's block.
+    @param int length - Length of the block.
+    @param PB12_Proof *proof - What was proved.
+*/
+void pb12VerifyProgram(PB12_MEM *mem, int bar, int length, PB12_Proof *proof) {
+    PB12_Decoded *dec;
+    char *reach;
+    int *lo;
+    int *hi;
+    int *seen;
+    int direct;
+    int flags;
+    int last;
+    int k;
+
+    pb12FreeProof(proof);
+    proof->confined = 0;
+    proof->accesses = 0;
+    proof->verified = 0;
+    proof->bar = bar;
+    proof->writes = 0;
+
+    if (length > mem->mem_size - bar)
+        length = mem->mem_size - bar;
+    if (length <= 0)
+        return;
+    if (mem->config->engine == PB12_ENGINE_SWITCH &&
+        !(mem->config->options & PB12_OPT_VERIFY))
+        return;
+
+    reach = (char*) calloc(length, sizeof(char));
+    lo = (int*) malloc(length * sizeof(int));
+    hi = (int*) malloc(length * sizeof(int));
+    seen = (int*) malloc((length + 1) * sizeof(int));
+    proof->marks = (unsigned char*) malloc(length * sizeof(unsigned char));
+    if (reach == NULL || lo == NULL || hi == NULL || seen == NULL || proof->marks == NULL) {
+        pb12FreeProof(proof);
+        goto done;
+    }
+    proof->length = length;
+
+    for (k=0; k<length; k++) {
+        lo[k] = mem->mem_size;
+        hi[k] = -1;
+    }
+    proof->confined = 1;
+    if (pb12ExploreProgram(mem, bar, length, reach, lo, hi,
+                           &proof->confined) == PB12_FAILURE) {
+        for (k=0; k<length; k++) {
+            lo[k] = mem->mem_size;
+            hi[k] = -1;
+        }
+        pb12RangeProgram(mem, bar, length, reach, lo, hi, &proof->confined);
+    }
+
+    /* Reachable words before each word, to see what a store can hit */
+    seen[0] = 0;
+    for (k=0; k<length; k++)
+        seen[k+1] = seen[k] + (reach[k] != 0);
+
+    for (k=0; k<length; k++) {
+        flags = 0;
+        dec = &mem->decoded[bar + k];
+        if (reach[k] && pb12AccessOperand(dec, mem->mem_size, &direct) >= 0) {
+            ++proof->accesses;
+            if (proof->confined && lo[k] >= 0 && hi[k] <= length &&
+                bar + hi[k] < mem->mem_size)
+                flags = PB12_DEC_UNCHECKED;
+            if (flags && pb12IsStore(dec)) {
+                last = hi[k] < length ? hi[k] : length - 1;
+                if (last >= lo[k] && seen[last + 1] > seen[lo[k]])
+                    flags = 0;
+            }
+            if (flags)
+                ++proof->verified;
+        }
+        if (proof->confined && reach[k])
+            flags |= PB12_DEC_VERIFIED;
+        proof->marks[k] = (unsigned char)flags;
+    }
+    pb12PlaceProof(mem, bar, proof);
+
+done:
+    free(reach);
+    free(lo);
+    free(hi);
+    free(seen);
+}
+
+
+/**
+    Put back the proof of a program whose block has been moved or swapped
+    back in.  Its words are the same as when it was proved, so the proof is
+    only worked out again if one it depended on was written, the block is
+    a different length, or the block now ends at the end of memory.
+
+    @param PB12_MEM *mem - Memory.
+    @param int bar - New base address of the program's block.
+    @param int length - Length of the block.
+    @param PB12_Proof *proof - Proof of the program.
+*/
+void pb12MoveProof(PB12_MEM *mem, int bar, int length, PB12_Proof *proof) {
+    if (proof->marks == NULL || length != proof->length ||
+        length >= mem->mem_size - bar ||
+        proof->writes != mem->proof_writes[proof->bar]) {
+        pb12VerifyProgram(mem, bar, length, proof);
+        return;
+    }
+
+    pb12PlaceProof(mem, bar, proof);
+}
+
+
+/**
+    Free what a proof keeps to be put back when its block moves.
+
+    @param PB12_Proof *proof - Proof.
+*/
+void pb12FreeProof(PB12_Proof *proof) {
+    free(proof->marks);
+    proof->marks = NULL;
+    proof->length = 0;
+}
+
+
+/**
+    Throw away the proof of a program whose block is about to be freed, so
+    that nothing else runs its words unchecked.
+
+    @param PB12_MEM *mem - Memory.
+    @param int bar - Base address of the program's block.
+    @param int length - Length of the block.
+*/
+void pb12ForgetProgram(PB12_MEM *mem, int bar, int length) {
+    int k;
+
+    for (k=0; k<length && bar + k < mem->mem_size; k++)
+        pb12SetProofFlags(mem, bar + k, 0);
+}
+
+
+/**
+    See whether a process may run the unchecked handlers: its control has
+    to be confined to its block, and none of the words the proof depends on
+    can have been written since.  Writes are counted per block, so writes
+    to other programs' words do not matter.
+
+    @param const PB12_Proof *proof - Proof of the process's program.
+    @param const PB12_MEM *mem - Memory.
+
+    @return int - Nonzero if the proof still holds.
+*/
+int pb12ProofHolds(const PB12_Proof *proof, const PB12_MEM *mem) {
+    return proof->confined && proof->writes == mem->proof_writes[proof->bar];
+}
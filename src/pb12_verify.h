@@ -0,0 +1,95 @@
+#ifndef PB12_VERIFY_H
+#define PB12_VERIFY_H
+
+#include "pb12_mem.h"
+
+#define PB12_VERIFY_STATES_PER_WORD 16      /* States followed per word of a program */
+#define PB12_VERIFY_MAX_STATES      65536   /* Most states followed per program */
+
+/*
+    What was proved about a program when it was loaded.  Memory accesses
+    can only be proved in range if control never leaves the words of the
+    program's block, and that only keeps holding while none of the words
+    it was worked out from are written.
+*/
+typedef struct S_PB12_Proof {
+    int confined;               /* Control never leaves the program's block */
+    int bar;                    /* Base address of the block it was proved for */
+    unsigned int writes;        /* mem->proof_writes[bar] when it was proved */
+    int accesses;               /* Reachable instructions that access memory */
+    int verified;               /* How many of them were proved in range */
+    int length;                 /* Words of the block the proof covers */
+    unsigned char *marks;       /* Proof flags of each word, put back when it moves */
+} PB12_Proof;
+
+
+/**
+    Work out which memory accesses of a program that has just been loaded
+    can never leave its block.  Every state the program can be in is
+    followed from the start, so addresses are known exactly, unless it has
+    more than PB12_VERIFY_STATES_PER_WORD states per word; then one pass
+    over the program bounds them instead (see pb12RangeProgram()), so the
+    work stays in proportion to the program's length.  Nothing is worked
+    out for the switch engine, which never runs anything unchecked, unless
+    PB12_OPT_VERIFY asks for a report.
+    Accesses that stay between bar and lr, and stores that cannot write to
+    any word the program can reach, are marked PB12_DEC_UNCHECKED and run
+    without range checks.  Every reachable word is marked
+    PB12_DEC_VERIFIED, since the proof only holds while none of them are
+    written.
+
+    @param PB12_MEM *mem - Memory.
+    @param int bar - Base address of the program's block.
+    @param int length - Length of the block.
+    @param PB12_Proof *proof - What was proved.
+*/
+void pb12VerifyProgram(PB12_MEM *mem, int bar, int length, PB12_Proof *proof);
+
+
+/**
+    Put back the proof of a program whose block has been moved or swapped
+    back in.  Its words are the same as when it was proved, so the proof is
+    only worked out again if one it depended on was written, the block is
+    a different length, or the block now ends at the end of memory.
+
+    @param PB12_MEM *mem - Memory.
+    @param int bar - New base address of the program's block.
+    @param int length - Length of the block.
+    @param PB12_Proof *proof - Proof of the program.
+*/
+void pb12MoveProof(PB12_MEM *mem, int bar, int length, PB12_Proof *proof);
+
+
+/**
+    Free what a proof keeps to be put back when its block moves.
+
+    @param PB12_Proof *proof - Proof.
+*/
+void pb12FreeProof(PB12_Proof *proof);
+
+
+/**
+    Throw away the proof of a program whose block is about to be freed, so
+    that nothing else runs its words unchecked.
+
+    @param PB12_MEM *mem - Memory.
+    @param int bar - Base address of the program's block.
+    @param int length - Length of the block.
+*/
+void pb12ForgetProgram(PB12_MEM *mem, int bar, int length);
+
+
+/**
+    See whether a process may run the unchecked handlers: its control has
+    to be confined to its block, and none of the words the proof depends on
+    can have been written since.  Writes are counted per block, so writes
+    to other programs' words do not matter.
+
+    @param const PB12_Proof *proof - Proof of the process's program.
+    @param const PB12_MEM *mem - Memory.
+
+    @return int - Nonzero if the proof still holds.
+*/
+int pb12ProofHolds(const PB12_Proof *proof, const PB12_MEM *mem);
+
+#endif /* PB12_VERIFY_H */
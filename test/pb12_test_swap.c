@@ -0,0 +1,113 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pb12.h"
+#include "pb12_mem.h"
+#include "pb12_swap.h"
+
+#define PB12_TEST_MEM_SIZE  1000    /* Words of memory */
+#define PB12_TEST_ADDRESS   100     /* Where the process is swapped out from */
+#define PB12_TEST_MOVED     500     /* Where it is swapped back in */
+#define PB12_TEST_LENGTH    30      /* Words of the process */
+#define PB12_TEST_CHURN     20      /* Times memory is filled with other words */
+
+
+/**
+    Gives the word a process keeps at one of its addresses.  None of them
+    end in four digits, so memory keeps each one as text rather than as a
+    number.
+
+    @param char *word - Set to the six characters.
+    @param char letter - Letter the words of the process have.
+    @param int i - Address in the process.
+*/
+static void pb12TestWord(char *word, char letter, int i) {
+    char digits[4];
+
+    pb12IntToChars(digits, 3, i);
+    word[0] = 'Z';
+    word[1] = 'Z';
+    word[2] = letter;
+    memcpy(&word[3], digits, 3);
+}
+
+
+/**
+    Swaps a process out, writes other words over all of memory a number of
+    times, and swaps the process back in somewhere else.  Each of its words
+    has to come back as the same six characters of text.  Once the process
+    ends, its room in the backing store has to be given to the next one.
+
+    @return int - EXIT_SUCCESS or EXIT_FAILURE
+*/
+int main(void) {
+    PB12_Config config;
+    PB12_MEM mem;
+    PB12_Swap swap;
+    char expected[6];
+    char word[6];
+    char other[6];
+    long offset;
+    int failed;
+    int round;
+    int i;
+
+    pb12InitConfig(&config);
+    if (pb12InitMem(&mem, PB12_TEST_MEM_SIZE, &config) == PB12_FAILURE ||
+        pb12InitSwap(&swap) == PB12_FAILURE) {
+        printf("ERROR: Could not set up memory and swap.\n");
+        return EXIT_FAILURE;
+    }
+
+    for (i=0; i<PB12_TEST_LENGTH; i++) {
+        pb12TestWord(word, 'A', i);
+        pb12PutMemWord(&mem, PB12_TEST_ADDRESS + i, word);
+    }
+    offset = pb12SwapReserve(&swap, PB12_TEST_LENGTH);
+    if (pb12SwapWrite(&swap, &mem, offset, PB12_TEST_ADDRESS, PB12_TEST_LENGTH) < 0) {
+        printf("ERROR: Could not swap out.\n");
+        return EXIT_FAILURE;
+    }
+
+    /* Every word of memory is written over with different text each round. */
+    for (round=0; round<PB12_TEST_CHURN; round++) {
+        for (i=0; i<PB12_TEST_MEM_SIZE; i++) {
+            pb12IntToChars(other, 6, round * PB12_TEST_MEM_SIZE + i);
+            other[0] = 'Z';
+            other[2] = (char)('B' + i % 20);
+            pb12PutMemWord(&mem, i, other);
+        }
+    }
+
+    if (pb12SwapRead(&swap, &mem, offset, PB12_TEST_MOVED, PB12_TEST_LENGTH) < 0) {
+        printf("ERROR: Could not swap in.\n");
+        return EXIT_FAILURE;
+    }
+
+    failed = 0;
+    for (i=0; i<PB12_TEST_LENGTH; i++) {
+        pb12TestWord(expected, 'A', i);
+        pb12GetMemWord(&mem, PB12_TEST_MOVED + i, word);
+        if (memcmp(word, expected, 6) != 0) {
+            printf("FAIL: Word %d swapped in as %.6s, not %.6s.\n", i, word, expected);
+            failed = 1;
+        }
+    }
+
+    /* Once the process ends, the next one that fits has to get its room
+       rather than more of the file. */
+    pb12SwapReserve(&swap, PB12_TEST_LENGTH);
+    pb12SwapRelease(&swap, offset, PB12_TEST_LENGTH);
+    if (pb12SwapReserve(&swap, PB12_TEST_LENGTH / 2) != offset) {
+        printf("FAIL: Room given back was not reused.\n");
+        failed = 1;
+    }
+
+    pb12DestroySwap(&swap);
+    pb12DestroyMem(&mem);
+
+    if (failed)
+        return EXIT_FAILURE;
+    printf("pb12_test_swap: %d words swapped back in as they were.\n", PB12_TEST_LENGTH);
+    return EXIT_SUCCESS;
+}